@@ -10,42 +10,193 @@
 #ifndef __PMD_ROYALE_ROS_DRIVER__CAMERA_NODE_HPP__
 #define __PMD_ROYALE_ROS_DRIVER__CAMERA_NODE_HPP__
 
+#include <array>
+#include <atomic>
+#include <future>
+#include <mutex>
 #include <royale.hpp>
 #include <thread>
 
 #include <rclcpp/rclcpp.hpp>
+#include <lifecycle_msgs/msg/state.hpp>
+#include <rclcpp_lifecycle/lifecycle_node.hpp>
 
 #include <sensor_msgs/image_encodings.hpp>
 #include <sensor_msgs/msg/camera_info.hpp>
+#include <sensor_msgs/msg/compressed_image.hpp>
 #include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/laser_scan.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
+#include <sensor_msgs/msg/region_of_interest.hpp>
 #include <sensor_msgs/point_cloud2_iterator.hpp>
 #include <std_msgs/msg/bool.hpp>
 #include <std_msgs/msg/float32.hpp>
+#include <std_msgs/msg/float32_multi_array.hpp>
 #include <std_msgs/msg/string.hpp>
 #include <std_msgs/msg/u_int16.hpp>
 #include <std_msgs/msg/u_int32.hpp>
+#include <std_msgs/msg/u_int64.hpp>
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/transform_listener.h>
 
+#include "CameraRegistry.hpp"
+#include "CaptureWatchdog.hpp"
+#include "ClockSync.hpp"
+#include "CloudCodec.hpp"
+#include "DepthStatistics.hpp"
+#include "FlyingPixelFilter.hpp"
+#include "FrameConversions.hpp"
+#include "FramePool.hpp"
+#include "FrameReducer.hpp"
+#include "FrameTypeAdapter.hpp"
+#include "FrameWorker.hpp"
+#include "GrayPairing.hpp"
+#include "OutputThrottle.hpp"
+#include "PointTransform.hpp"
+#include "PublishMessage.hpp"
+#include "ShmFrameRingWriter.hpp"
+#include "RowBandPool.hpp"
+#include "StreamDiagnostics.hpp"
+#include "TemporalFilter.hpp"
+#include "VirtualScanner.hpp"
 #include "VisibilityControl.hpp"
 
-#define ROYALE_ROS_MAX_STREAMS 2u
-
 namespace pmd_royale_ros_driver {
 
-class CameraNode : public rclcpp::Node,
+/// Lifecycle managed camera node.
+///
+/// Configuring opens the camera and sets up the publishers, frame buffers and workers of all streams, activating only
+/// starts the capture. With the autostart parameter the camera is opened in the background while the node is
+/// constructed and the node configures and activates itself once that is done. Without it, configuring opens the camera
+/// and blocks until it is open.
+class CameraNode : public rclcpp_lifecycle::LifecycleNode,
                    public royale::IPointCloudListener,
                    public royale::IIRImageListener,
                    public royale::IExposureListener {
   public:
+    using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
+
     PMD_ROYALE_ROS_DRIVER_PUBLIC
     CameraNode(const rclcpp::NodeOptions &options);
     ~CameraNode();
 
     // Starting and stopping the camera
-    void start();
+    bool start();
     void stop();
 
+  protected:
+    CallbackReturn on_configure(const rclcpp_lifecycle::State &state) override;
+    CallbackReturn on_activate(const rclcpp_lifecycle::State &state) override;
+    CallbackReturn on_deactivate(const rclcpp_lifecycle::State &state) override;
+    CallbackReturn on_cleanup(const rclcpp_lifecycle::State &state) override;
+    CallbackReturn on_shutdown(const rclcpp_lifecycle::State &state) override;
+
   private:
+    /// Clock the message stamps are taken from
+    enum class StampSource { Device, Arrival, Synchronized };
+
+    /// Throttled outputs per stream, one bit each in the masks handed to the worker
+    static constexpr size_t MAX_THROTTLED_OUTPUTS = 32;
+
+    /// Point cloud or depth image of a stream with its own rate, see OutputThrottle
+    struct ThrottledOutput {
+        explicit ThrottledOutput(const OutputThrottle::Settings &settings) : throttle(settings), isPub(false) {}
+
+        // Only touched by the capture callback
+        OutputThrottle throttle;
+
+        // One of them is set, depending on the output
+        rclcpp::Publisher<FrameAdapter>::SharedPtr pubCloud;
+        rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr pubDepth;
+        std::atomic<bool> isPub;
+
+        sensor_msgs::msg::PointCloud2 msgCloud;
+        sensor_msgs::msg::Image msgDepth;
+    };
+
+    /// Publishers, parameters and conversion worker of one stream of the current usecase
+    struct Stream {
+        royale::StreamId id;
+        std::string frameId;
+        int64_t exposureTime;
+        bool isAutoExposureEnabled;
+
+        rclcpp::Publisher<FrameAdapter>::SharedPtr pubCloud;
+        rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr pubDepth;
+        rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr pubGray;
+        rclcpp::Publisher<std_msgs::msg::UInt64>::SharedPtr pubShmNotify;
+        rclcpp::Publisher<sensor_msgs::msg::LaserScan>::SharedPtr pubScan;
+        rclcpp::Publisher<FrameAdapter>::SharedPtr pubCloudReduced;
+        rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr pubDepthReduced;
+        rclcpp::Publisher<std_msgs::msg::Float32MultiArray>::SharedPtr pubStatistics;
+        rclcpp::Publisher<sensor_msgs::msg::CompressedImage>::SharedPtr pubCompressed;
+        rclcpp::Subscription<std_msgs::msg::String>::SharedPtr procParamsSubscription;
+
+        // Which outputs have subscribers, updated by updateDataListeners
+        std::atomic<bool> isPubCloud;
+        std::atomic<bool> isPubDepth;
+        std::atomic<bool> isPubGray;
+        std::atomic<bool> isPubShm;
+        std::atomic<bool> isPubScan;
+        std::atomic<bool> isPubCloudReduced;
+        std::atomic<bool> isPubDepthReduced;
+        std::atomic<bool> isPubStatistics;
+        std::atomic<bool> isPubCompressed;
+        std::atomic<bool> isPubThrottledCloud;
+
+        // Throttled outputs and the masks of those which are depth images and those which are reduced
+        std::vector<std::unique_ptr<ThrottledOutput>> throttledOutputs;
+        uint32_t throttledDepthMask;
+        uint32_t throttledReducedMask;
+
+        // Part of the sensor which is published, and the optional mask of the full sensor
+        sensor_msgs::msg::RegionOfInterest roi;
+        std::vector<uint8_t> roiMask;
+        uint32_t roiMaskWidth;
+        uint32_t roiMaskHeight;
+
+        // Optional shared memory ring for out-of-process consumers
+        std::unique_ptr<ShmFrameRingWriter> shmRing;
+
+        // Frames of this stream are taken from the pool and returned once they are published
+        std::unique_ptr<FramePool> framePool;
+
+        // Messages which are reused for every frame when intra-process communication is off. The gray image and
+        // its camera info belong to the IR callback, the others to the worker.
+        sensor_msgs::msg::PointCloud2 msgCloud;
+        sensor_msgs::msg::PointCloud2 msgCloudReduced;
+        sensor_msgs::msg::Image msgDepth;
+        sensor_msgs::msg::Image msgDepthReduced;
+        sensor_msgs::msg::Image msgGray;
+        sensor_msgs::msg::CameraInfo msgCameraInfo;
+        sensor_msgs::msg::CameraInfo msgCameraInfoReduced;
+        sensor_msgs::msg::CameraInfo msgCameraInfoGray;
+        sensor_msgs::msg::LaserScan msgScan;
+        std_msgs::msg::Float32MultiArray msgStatistics;
+        sensor_msgs::msg::CompressedImage msgCompressed;
+
+        // Attaches the gray image of the IR callback to the Frame of the same capture, in either order
+        GrayPairing grayPairing;
+
+        // Filters, running on the worker thread with the row bands split over the pool
+        std::unique_ptr<RowBandPool> rowBands;
+        TemporalFilter temporalFilter;
+        FlyingPixelFilter flyingPixelFilter;
+
+        // Transform of the optical frame into the target frame, row major 3x4
+        bool hasTargetTransform;
+        PointTransform targetTransform;
+
+        VirtualScanner scanner;
+        FrameReducer reducer;
+        DepthStatistics statistics;
+        CloudCodec codec;
+        float scanTime;
+
+        std::unique_ptr<StreamDiagnostics> diagnostics;
+        std::unique_ptr<FrameWorker> worker;
+    };
+
     // Callbacks from CameraDevice when image is ready
     void onNewData(const royale::PointCloud *data) override;
     void onNewData(const royale::IRImage *data) override;
@@ -53,39 +204,95 @@ class CameraNode : public rclcpp::Node,
     // Called by CameraDevice for every new exposure time when auto exposure is enabled.
     void onNewExposure(const uint32_t exposureTime, const royale::StreamId streamId) override;
 
-    // Parameter set/events callbacks
+    // Parameter set callback
     rcl_interfaces::msg::SetParametersResult onSetParameters(const std::vector<rclcpp::Parameter> &parameters);
-    void onParametersSetEvent(const rcl_interfaces::msg::ParameterEvent &event);
+
+    // Set up the streams of a new usecase and restart the capture, deferred from onSetParameters
+    void reinitUseCase();
+
+    // Find and initialize the camera, runs in the background
+    bool openDevice();
+
+    // Everything of the configuration which needs the open camera
+    bool configureDevice();
+
+    // Undo configureDevice and close the camera
+    void releaseDevice();
+
+    // Configure and activate the node once the camera is open
+    void autostart();
+
+    // Run the capture watchdog and take the recovery action it decides on
+    void checkCapture();
+
+    // Replace a stalled camera with a newly opened one of the same serial, keeping the streams and their topics
+    bool reopenDevice();
 
     // Create cameraInfo, return true if the setting is successful, otherwise false
     bool setCameraInfo();
+    void fillCameraInfo(const Frame &frame, sensor_msgs::msg::CameraInfo &cameraInfo);
+    void fillCameraInfo(const std::string &frameId, const builtin_interfaces::msg::Time &stamp,
+                        const sensor_msgs::msg::RegionOfInterest &roi, uint32_t fullWidth, uint32_t fullHeight,
+                        sensor_msgs::msg::CameraInfo &cameraInfo);
+
+    // Publish the throttled outputs of the mask from frame. Clouds are copied for intra-process subscribers, so the
+    // frame can go on to the other outputs.
+    void publishThrottled(Stream &stream, const Frame &frame, uint32_t outputs);
+
+    // Transform the points of a cloud into the target frame, if one is set and its transform is known
+    void transformToTarget(Stream &stream, Frame &frame);
+
+    // Mask of the stream if it matches the image size, otherwise nullptr
+    const uint8_t *roiMask(const Stream &stream, uint32_t width, uint32_t height);
 
     // Callbacks for parameter changes which reconfigure the CameraDevice
     bool setUseCase(const std::string &useCase);
-    bool setExposureTime(int exposureTime, royale::StreamId streamId);
-    bool enableAutoExposure(bool enable, royale::StreamId streamId);
+    bool setExposureTime(int exposureTime, uint32_t streamIdx);
+    bool enableAutoExposure(bool enable, uint32_t streamIdx);
+    bool setStampSource(const std::string &stampSource);
+    bool setPointCloudFields(const std::string &pointCloudFields);
+
+    // Stamp for a frame according to the stamp source. Only one callback per capture adds its arrival to the clock sync.
+    rclcpp::Time frameStamp(uint64_t deviceTimestampUs, const rclcpp::Time &arrival, bool addSample);
 
-    void initUseCase();
+    // Create, update and destroy the streams to match the current usecase
+    bool initUseCase();
+    bool createStream(uint32_t streamIdx, royale::StreamId streamId);
+    void updateStream(uint32_t streamIdx, royale::StreamId streamId);
+    void destroyStream(uint32_t streamIdx);
+
+    // Publish the entry of this node in the camera registry, after the streams changed
+    void publishRegistry();
+
+    // Hand the frames which are ready after a callback to the stream's worker
+    void postFrames(Stream &stream, GrayPairing::Result frames);
+
+    // Runs on the stream's worker thread
+    void processFrame(Stream &stream, std::unique_ptr<Frame> frame, uint32_t throttledOutputs);
 
     void updateDataListeners();
 
     void setProcParams(const std_msgs::msg::String::SharedPtr parameters, uint32_t streamIdx);
 
+    // Report camera level diagnostics like the temperature, where Royale exposes it
+    void updateCameraDiagnostics(diagnostic_updater::DiagnosticStatusWrapper &stat);
+
     // Published topics
     sensor_msgs::msg::CameraInfo m_cameraInfo;
     rclcpp::Publisher<sensor_msgs::msg::CameraInfo>::SharedPtr m_pubCameraInfo;
-    rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr m_pubCloud[ROYALE_ROS_MAX_STREAMS];
-    rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr m_pubDepth[ROYALE_ROS_MAX_STREAMS];
-    rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr m_pubGray[ROYALE_ROS_MAX_STREAMS];
+    rclcpp::Publisher<sensor_msgs::msg::CameraInfo>::SharedPtr m_pubCameraInfoReduced;
+    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubRegistry;
 
     // Interface to configure actual camera
     std::unique_ptr<royale::ICameraDevice> m_cameraDevice;
 
-    OnSetParametersCallbackHandle::SharedPtr m_onSetParametersCbHandle;
-    rclcpp::Subscription<rcl_interfaces::msg::ParameterEvent>::SharedPtr m_onSetParametersEventCbHandle;
-    rclcpp::SyncParametersClient m_parametersClient;
+    rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr m_onSetParametersCbHandle;
+    rclcpp::TimerBase::SharedPtr m_reinitUseCaseTimer;
+    rclcpp::TimerBase::SharedPtr m_autostartTimer;
+    rclcpp::TimerBase::SharedPtr m_watchdogTimer;
 
-    rclcpp::Subscription<std_msgs::msg::String>::SharedPtr m_procParamsSubscription[ROYALE_ROS_MAX_STREAMS];
+    // All parameters were declared and are valid, the node can be configured
+    bool m_isDeclared;
 
     // Parameters
     std::string m_serial;
@@ -95,16 +302,46 @@ class CameraNode : public rclcpp::Node,
     std::string m_startUseCase;
     std::string m_currentUseCase;
     std::string m_cam_access_code;
-    int64_t m_exposureTime[ROYALE_ROS_MAX_STREAMS];
-    bool m_isAutoExposureEnabled[ROYALE_ROS_MAX_STREAMS];
-    bool m_isPubCloud;
-    bool m_isPubDepth;
-    bool m_isPubGray;
-    bool m_registeredPCListener;
-    bool m_registeredIRListener;
+    bool m_isIntraProcess;
+    bool m_isShmRingEnabled;
+    bool m_isWatchdogEnabled;
+    int64_t m_shmRingSlots;
+    std::atomic<StampSource> m_stampSource;
+    std::atomic<Frame::CloudFields> m_cloudFields;
+    std::atomic<float> m_compressionPrecision;
+    int64_t m_filterThreads;
+    TemporalFilter::Settings m_temporalFilterSettings;
+    FlyingPixelFilter::Settings m_flyingPixelFilterSettings;
+    VirtualScanner::Settings m_scannerSettings;
+    FrameReducer::Settings m_reducerSettings;
+    DepthStatistics::Settings m_statisticsSettings;
+    std::vector<OutputThrottle::Settings> m_throttledOutputs;
+    std::string m_scanFrameId;
+    std::string m_targetFrame;
+    std::shared_ptr<tf2_ros::Buffer> m_tfBuffer;
+    std::shared_ptr<tf2_ros::TransformListener> m_tfListener;
+    // Written by the executor, read by the capture callbacks
+    std::atomic<bool> m_registeredPCListener;
+    std::atomic<bool> m_registeredIRListener;
     rclcpp::TimerBase::SharedPtr m_updateDataListenersTimer;
-    std::map<royale::StreamId, uint32_t> m_streamIdx;
     std::string m_recording_file;
+    std::string m_playback_file;
+
+    // Streams of the current usecase. They are only changed while the capture is stopped.
+    std::vector<std::unique_ptr<Stream>> m_streams;
+    std::map<royale::StreamId, uint32_t> m_streamIdx;
+
+    // Mapping of the device clock to the node clock, shared by all streams
+    ClockSync m_clockSync;
+
+    // Detects stalls of the capture, reported in the diagnostics
+    CaptureWatchdog m_watchdog;
+
+    // Result of the openDevice of autostart, which uses the members above
+    std::future<bool> m_deviceOpened;
+
+    // Diagnostics, the stream tasks have to outlive the updater
+    diagnostic_updater::Updater m_diagnostics;
 };
 
 } // namespace pmd_royale_ros_driver
@@ -0,0 +1,110 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__CAMERA_REGISTRY_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__CAMERA_REGISTRY_HPP__
+
+// Format of the camera registry, written by the camera node and read by the tools which look for cameras. This
+// header has no dependencies besides the C++ standard library, so the tools can include it without linking against
+// the driver.
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace pmd_royale_ros_driver {
+
+/// Topic the camera nodes publish their registry entries on as std_msgs/String, transient local so late joiners get
+/// all of them
+static const char *const CAMERA_REGISTRY_TOPIC = "/pmd_royale_ros_cameras";
+
+/// One camera node as announced in the registry.
+///
+/// The camera node publishes an entry whenever its streams change. It consists of key=value lines: node, serial,
+/// model, usecase and streams, followed by the topics as "topic=<name> <type>" for node wide ones and
+/// "topic_<n>=<name> <type>" for the ones of stream n.
+struct CameraRegistryEntry {
+    struct Topic {
+        int streamIdx; // -1 for node wide topics
+        std::string name;
+        std::string type;
+    };
+
+    std::string node;
+    std::string serial;
+    std::string model;
+    std::string usecase;
+    uint32_t numStreams = 0;
+    std::vector<Topic> topics;
+
+    /// Data of the registry message
+    std::string format() const {
+        std::ostringstream data;
+        data << "node=" << node << "\n";
+        data << "serial=" << serial << "\n";
+        data << "model=" << model << "\n";
+        data << "usecase=" << usecase << "\n";
+        data << "streams=" << numStreams << "\n";
+        for (auto &topic : topics) {
+            data << "topic";
+            if (topic.streamIdx >= 0) {
+                data << "_" << topic.streamIdx;
+            }
+            data << "=" << topic.name << " " << topic.type << "\n";
+        }
+        return data.str();
+    }
+
+    /// Parse an entry, returns false if it doesn't name a node
+    static bool parse(const std::string &data, CameraRegistryEntry &entry) {
+        entry = CameraRegistryEntry();
+        std::istringstream lines(data);
+        std::string line;
+        try {
+            while (std::getline(lines, line)) {
+                auto separator = line.find('=');
+                if (separator == std::string::npos) {
+                    continue;
+                }
+                auto key = line.substr(0, separator);
+                auto value = line.substr(separator + 1);
+
+                if (key == "node") {
+                    entry.node = value;
+                } else if (key == "serial") {
+                    entry.serial = value;
+                } else if (key == "model") {
+                    entry.model = value;
+                } else if (key == "usecase") {
+                    entry.usecase = value;
+                } else if (key == "streams") {
+                    entry.numStreams = static_cast<uint32_t>(std::stoul(value));
+                } else if (key == "topic" || key.find("topic_") == 0) {
+                    auto space = value.find(' ');
+                    if (space == std::string::npos) {
+                        continue;
+                    }
+                    Topic topic;
+                    topic.streamIdx = key == "topic" ? -1 : std::stoi(key.substr(6));
+                    topic.name = value.substr(0, space);
+                    topic.type = value.substr(space + 1);
+                    entry.topics.push_back(topic);
+                }
+            }
+        } catch (const std::exception &) {
+            return false;
+        }
+        return !entry.node.empty();
+    }
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__CAMERA_REGISTRY_HPP__
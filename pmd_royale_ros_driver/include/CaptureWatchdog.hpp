@@ -0,0 +1,79 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__CAPTURE_WATCHDOG_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__CAPTURE_WATCHDOG_HPP__
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <diagnostic_updater/diagnostic_updater.hpp>
+
+namespace pmd_royale_ros_driver {
+
+/// Detects stalled streams and decides how the node recovers from a stall.
+///
+/// A stream is stalled if it didn't deliver a frame for STALL_PERIODS frame periods of the usecase, but at least
+/// MIN_TIMEOUT. The recovery escalates with every stall which outlasts the previous action: first the capture is
+/// restarted, then the camera is reopened, and from then on the camera is reopened whenever its serial is enumerated
+/// again. Every action restarts the timeout, so each one gets the same time to bring the frames back.
+class CaptureWatchdog : public diagnostic_updater::DiagnosticTask {
+  public:
+    static constexpr double STALL_PERIODS = 10.;
+    static constexpr std::chrono::milliseconds MIN_TIMEOUT{1000};
+
+    enum class Action { None, RestartCapture, ReopenDevice };
+
+    explicit CaptureWatchdog(const std::string &name);
+
+    /// Number of streams of the current usecase and its nominal frame rate, 0 if unknown
+    void setStreams(size_t numStreams, double nominalFps);
+
+    /// Whether frames are expected at all, i.e. the capture runs and a data listener is registered
+    void setActive(bool active);
+
+    /// Give the streams another timeout, e.g. after the node spent some time on an action
+    void restartTimeout();
+
+    /// Called for every frame of a stream
+    void onFrame(size_t streamIdx);
+
+    /// Called periodically, returns the action the node has to take
+    Action check();
+
+    void run(diagnostic_updater::DiagnosticStatusWrapper &stat) override;
+
+  private:
+    std::chrono::steady_clock::duration timeout() const;
+    void restartTimeout(std::chrono::steady_clock::time_point now);
+
+    std::mutex m_mutex;
+    double m_nominalFps;
+    bool m_active;
+    std::vector<std::chrono::steady_clock::time_point> m_lastFrames;
+    // Which streams delivered a frame since the timeout was restarted
+    std::vector<bool> m_hasFrame;
+
+    // Recovery in progress, 0 if the streams are fine
+    uint32_t m_level;
+    std::chrono::steady_clock::time_point m_stallStart;
+
+    uint64_t m_stalls;
+    uint64_t m_recoveries;
+    uint64_t m_reopens;
+    double m_lastRecoveryTime;
+    double m_maxRecoveryTime;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__CAPTURE_WATCHDOG_HPP__
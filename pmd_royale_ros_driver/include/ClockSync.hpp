@@ -0,0 +1,72 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__CLOCK_SYNC_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__CLOCK_SYNC_HPP__
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace pmd_royale_ros_driver {
+
+/// Maps device timestamps to host time.
+///
+/// The drift is the slope of a least squares fit of the arrival times against the device timestamps over the
+/// last WINDOW_SIZE frames. The arrival times only ever lag behind the capture by the transfer and processing
+/// latency, so the offset is taken from the frame with the smallest residual instead of the mean of the fit. This
+/// keeps the latency jitter out of the mapped stamps, which only move as slowly as the window.
+class ClockSync {
+  public:
+    static constexpr size_t WINDOW_SIZE = 300;
+
+    ClockSync();
+
+    void reset();
+
+    /// Add the arrival time of a frame and return its synchronized host time in nanoseconds
+    int64_t update(uint64_t deviceTimestampUs, int64_t arrivalNs);
+
+    /// Synchronized host time in nanoseconds for a device timestamp, without adding a sample
+    int64_t toHost(uint64_t deviceTimestampUs) const;
+
+    /// Host minus device time in seconds at the newest sample
+    double offset() const;
+
+    /// Rate difference of the device clock against the host clock in parts per million
+    double drift() const;
+
+    /// Spread of the arrival latencies in the window in milliseconds
+    double jitter() const;
+
+    size_t sampleCount() const;
+
+  private:
+    struct Sample {
+        uint64_t deviceUs;
+        int64_t arrivalNs;
+    };
+
+    void fit();
+    int64_t map(uint64_t deviceTimestampUs) const;
+
+    mutable std::mutex m_mutex;
+    std::deque<Sample> m_samples;
+
+    // host = m_refArrivalNs + m_intercept + m_slope * (device - m_refDeviceUs) * 1000
+    uint64_t m_refDeviceUs;
+    int64_t m_refArrivalNs;
+    double m_slope;
+    double m_intercept;
+    double m_jitter;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__CLOCK_SYNC_HPP__
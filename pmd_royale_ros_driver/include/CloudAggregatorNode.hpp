@@ -0,0 +1,89 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__CLOUD_AGGREGATOR_NODE_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__CLOUD_AGGREGATOR_NODE_HPP__
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/transform_listener.h>
+
+#include "FramePool.hpp"
+#include "FrameTypeAdapter.hpp"
+#include "PointTransform.hpp"
+#include "PublishMessage.hpp"
+#include "RowBandPool.hpp"
+#include "VisibilityControl.hpp"
+
+namespace pmd_royale_ros_driver {
+
+/// Fuses the point clouds of several camera nodes into one cloud in a common frame.
+///
+/// The node is meant to be loaded into the container of the camera nodes with intra-process communication, so it
+/// receives their frames without any copy. Once every input has a frame within the sync tolerance of the newest one,
+/// the frames are transformed into the target frame and written next to each other into one unorganized frame from a
+/// pool, one thread per input. Each point is copied exactly once. The transforms are looked up once per frame id and
+/// must be static.
+class CloudAggregatorNode : public rclcpp::Node {
+  public:
+    COMPOSITION_PUBLIC explicit CloudAggregatorNode(const rclcpp::NodeOptions &options);
+
+  private:
+    // Frames kept per input while waiting for the other inputs
+    static constexpr size_t QUEUE_SIZE = 4;
+
+    struct Source {
+        std::string topic;
+        rclcpp::Subscription<FrameAdapter>::SharedPtr subscription;
+        std::deque<std::shared_ptr<const Frame>> frames;
+
+        // Static transform into the target frame, valid if frameId matches the frames
+        std::string frameId;
+        PointTransform transform;
+    };
+
+    void onFrame(size_t sourceIdx, std::shared_ptr<const Frame> frame);
+
+    // Take one frame of every input which is within the sync tolerance of the newest frame of sourceIdx.
+    // Returns false if an input has none.
+    bool takeMatchingFrames(size_t sourceIdx, std::vector<std::shared_ptr<const Frame>> &frames);
+
+    bool lookupTransform(Source &source, const std::string &frameId);
+    void fuse(const std::vector<std::shared_ptr<const Frame>> &frames);
+
+    bool m_isIntraProcess;
+    std::string m_targetFrame;
+    int64_t m_syncToleranceNs;
+
+    // Guards the frame queues of the sources
+    std::mutex m_queueMutex;
+    std::vector<std::unique_ptr<Source>> m_sources;
+
+    // Guards the fusion, which owns the row bands, the offsets and the reused message
+    std::mutex m_fuseMutex;
+    std::unique_ptr<RowBandPool> m_rowBands;
+    std::vector<size_t> m_offsets;
+    FramePool m_framePool;
+    sensor_msgs::msg::PointCloud2 m_msgCloud;
+
+    rclcpp::Publisher<FrameAdapter>::SharedPtr m_pubCloud;
+    std::shared_ptr<tf2_ros::Buffer> m_tfBuffer;
+    std::shared_ptr<tf2_ros::TransformListener> m_tfListener;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__CLOUD_AGGREGATOR_NODE_HPP__
@@ -0,0 +1,425 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__CLOUD_CODEC_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__CLOUD_CODEC_HPP__
+
+// Compression of organized point clouds as published on compressed_cloud_<n>, with the encoder used by the camera
+// node and the matching decoder. This header has no dependencies besides the C++ standard library, so receivers
+// which are not built against the driver can include it directly.
+//
+// The coordinates are quantized to a configurable precision and the confidence to 8 bits. Every pixel is predicted
+// from its left, upper and upper left neighbors with the median edge detector of LOCO-I, which follows the planes
+// and edges of the organized grid. The residuals are coded with adaptive Rice codes whose parameter is tracked per
+// channel and local gradient. Pixels with confidence 0 are invalid, only their confidence is coded and they decode
+// to the origin. The data starts with a CloudCodecHeader, followed by the bit stream; both are little endian.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace pmd_royale_ros_driver {
+
+static const uint32_t CLOUD_CODEC_MAGIC = 0x43444d50; // "PMDC"
+static const uint32_t CLOUD_CODEC_VERSION = 1u;
+
+/// Format of the CompressedImage messages which carry a compressed cloud
+static const char *const CLOUD_CODEC_FORMAT = "pmd_cloud_codec";
+
+struct CloudCodecHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    float precision;       // Quantization step of x, y and z in meters
+    float confidenceScale; // Confidence of one quantization step
+};
+
+/// Bit stream writer, least significant bit first
+class CloudBitWriter {
+  public:
+    explicit CloudBitWriter(std::vector<uint8_t> &data) : m_data(data), m_bits(0), m_count(0) {}
+
+    /// Append the lowest numBits bits of value, up to 32
+    void write(uint32_t value, uint32_t numBits) {
+        m_bits |= uint64_t(value & mask(numBits)) << m_count;
+        m_count += numBits;
+        while (m_count >= 8) {
+            m_data.push_back(static_cast<uint8_t>(m_bits));
+            m_bits >>= 8;
+            m_count -= 8;
+        }
+    }
+
+    /// Append count one bits
+    void writeOnes(uint32_t count) {
+        for (; count >= 32; count -= 32) {
+            write(0xffffffffu, 32);
+        }
+        write(0xffffffffu, count);
+    }
+
+    /// Write the last partial byte
+    void flush() {
+        if (m_count > 0) {
+            m_data.push_back(static_cast<uint8_t>(m_bits));
+        }
+        m_bits = 0;
+        m_count = 0;
+    }
+
+    static uint32_t mask(uint32_t numBits) {
+        return numBits >= 32 ? 0xffffffffu : (1u << numBits) - 1u;
+    }
+
+  private:
+    std::vector<uint8_t> &m_data;
+    uint64_t m_bits;
+    uint32_t m_count;
+};
+
+/// Bit stream reader for CloudBitWriter. Reading past the end yields zeros and marks the stream as overrun.
+class CloudBitReader {
+  public:
+    CloudBitReader(const uint8_t *data, size_t size)
+        : m_pos(data), m_end(data + size), m_bits(0), m_count(0), m_consumed(0), m_size(size) {}
+
+    uint32_t read(uint32_t numBits) {
+        refill();
+        auto value = static_cast<uint32_t>(m_bits) & CloudBitWriter::mask(numBits);
+        consume(numBits);
+        return value;
+    }
+
+    /// Number of one bits before the next zero bit, at most limit. The zero bit is consumed as well unless the
+    /// limit was reached.
+    uint32_t readOnes(uint32_t limit) {
+        uint32_t count = 0;
+        while (count < limit) {
+            refill();
+            uint64_t zeros = ~m_bits;
+            uint32_t ones = zeros ? static_cast<uint32_t>(__builtin_ctzll(zeros)) : 64u;
+            ones = std::min(std::min(ones, m_count), limit - count);
+            consume(ones);
+            count += ones;
+            if (count < limit && ones < m_count) {
+                consume(1);
+                break;
+            }
+        }
+        return count;
+    }
+
+    bool isOverrun() const {
+        return (m_consumed + 7) / 8 > m_size;
+    }
+
+  private:
+    void refill() {
+        while (m_count <= 56) {
+            uint64_t byte = m_pos < m_end ? *m_pos++ : 0u;
+            m_bits |= byte << m_count;
+            m_count += 8;
+        }
+    }
+
+    void consume(uint32_t numBits) {
+        m_bits = numBits >= 64 ? 0 : m_bits >> numBits;
+        m_count -= numBits;
+        m_consumed += numBits;
+    }
+
+    const uint8_t *m_pos;
+    const uint8_t *m_end;
+    uint64_t m_bits;
+    uint32_t m_count;
+    uint64_t m_consumed;
+    size_t m_size;
+};
+
+/// Encoder and decoder of organized point clouds.
+///
+/// The codec keeps its two rows of quantized values between calls, so in steady state neither encoding nor decoding
+/// allocates memory. One instance must not be used by several threads at once.
+class CloudCodec {
+  public:
+    /// Largest quantized coordinate, which keeps every residual within 32 bits
+    static constexpr int32_t MAX_VALUE = (1 << 30) - 1;
+
+    CloudCodec() : m_width(0) {}
+
+    /// Compress the interleaved x, y, z, confidence points of a width x height grid into data, which is
+    /// overwritten. Coordinates are rounded to multiples of precision meters.
+    void encode(const float *xyzc, uint32_t width, uint32_t height, float precision, std::vector<uint8_t> &data) {
+        auto numPoints = size_t(width) * height;
+        float maxConfidence = 0.f;
+        for (size_t i = 0; i < numPoints; ++i) {
+            maxConfidence = std::max(maxConfidence, xyzc[4 * i + 3]);
+        }
+
+        CloudCodecHeader header;
+        header.magic = CLOUD_CODEC_MAGIC;
+        header.version = CLOUD_CODEC_VERSION;
+        header.width = width;
+        header.height = height;
+        header.precision = precision > 0.f ? precision : 0.001f;
+        header.confidenceScale = maxConfidence > 0.f ? maxConfidence / 255.f : 1.f;
+
+        // The capacity of data is kept, so a reused buffer stops growing once it fits the frames
+        data.resize(sizeof(header));
+        ::memcpy(data.data(), &header, sizeof(header));
+
+        float scale = 1.f / header.precision;
+        float confidenceScale = 1.f / header.confidenceScale;
+        CloudBitWriter writer(data);
+        start(width);
+        for (uint32_t y = 0; y < height; ++y) {
+            const float *points = xyzc + size_t(4) * width * y;
+            int32_t *row = currentRow();
+            for (uint32_t x = 0; x < width; ++x) {
+                const float *point = points + 4 * x;
+                int32_t values[CHANNELS];
+                values[CONFIDENCE] = quantizeConfidence(point[3], confidenceScale);
+                for (uint32_t channel = 0; channel < 3; ++channel) {
+                    values[channel] = quantize(point[channel], scale);
+                }
+
+                bool isValid = values[CONFIDENCE] > 0;
+                for (uint32_t channel = 0; channel < CHANNELS; ++channel) {
+                    auto c = channelOrder(channel);
+                    int32_t activity;
+                    int32_t prediction = predict(x, y, c, activity);
+                    if (c == CONFIDENCE || isValid) {
+                        encodeResidual(writer, m_contexts[c][contextIndex(activity)],
+                                       zigzag(int64_t(values[c]) - prediction));
+                        row[CHANNELS * x + c] = values[c];
+                    } else {
+                        // Invalid pixels continue the surface, so they don't disturb the prediction of their neighbors
+                        row[CHANNELS * x + c] = prediction;
+                    }
+                }
+            }
+            nextRow();
+        }
+        writer.flush();
+    }
+
+    /// Decompress data into interleaved x, y, z, confidence points. Returns false if the data isn't a compressed
+    /// cloud or is truncated.
+    bool decode(const uint8_t *data, size_t size, std::vector<float> &xyzc, uint32_t &width, uint32_t &height) {
+        CloudCodecHeader header;
+        if (size < sizeof(header)) {
+            return false;
+        }
+        ::memcpy(&header, data, sizeof(header));
+        if (header.magic != CLOUD_CODEC_MAGIC || header.version != CLOUD_CODEC_VERSION ||
+            size_t(header.width) * header.height > MAX_POINTS) {
+            return false;
+        }
+
+        width = header.width;
+        height = header.height;
+        xyzc.resize(size_t(4) * width * height);
+
+        CloudBitReader reader(data + sizeof(header), size - sizeof(header));
+        start(width);
+        for (uint32_t y = 0; y < height; ++y) {
+            float *points = xyzc.data() + size_t(4) * width * y;
+            int32_t *row = currentRow();
+            for (uint32_t x = 0; x < width; ++x) {
+                bool isValid = true;
+                for (uint32_t channel = 0; channel < CHANNELS; ++channel) {
+                    auto c = channelOrder(channel);
+                    int32_t activity;
+                    int32_t prediction = predict(x, y, c, activity);
+                    if (c == CONFIDENCE || isValid) {
+                        auto mapped = decodeResidual(reader, m_contexts[c][contextIndex(activity)]);
+                        row[CHANNELS * x + c] = static_cast<int32_t>(prediction + unzigzag(mapped));
+                    } else {
+                        row[CHANNELS * x + c] = prediction;
+                    }
+                    if (c == CONFIDENCE) {
+                        isValid = row[CHANNELS * x + c] > 0;
+                    }
+                }
+
+                float *point = points + 4 * x;
+                if (isValid) {
+                    point[0] = row[CHANNELS * x] * header.precision;
+                    point[1] = row[CHANNELS * x + 1] * header.precision;
+                    point[2] = row[CHANNELS * x + 2] * header.precision;
+                    point[3] = row[CHANNELS * x + CONFIDENCE] * header.confidenceScale;
+                } else {
+                    point[0] = point[1] = point[2] = point[3] = 0.f;
+                }
+            }
+            nextRow();
+        }
+        return !reader.isOverrun();
+    }
+
+  private:
+    static constexpr uint32_t CHANNELS = 4;
+    static constexpr uint32_t CONFIDENCE = 3;
+
+    // Contexts per channel, by the magnitude of the local gradient
+    static constexpr uint32_t ACTIVITY_CONTEXTS = 8;
+
+    // Residuals whose Rice quotient reaches the limit are written as escape and 32 raw bits
+    static constexpr uint32_t ESCAPE_LIMIT = 24;
+    static constexpr uint32_t MAX_K = 24;
+    // The context statistics are halved after this many residuals, so they follow the scene
+    static constexpr uint32_t CONTEXT_RESET = 64;
+
+    static constexpr size_t MAX_POINTS = size_t(1) << 26;
+
+    struct Context {
+        uint64_t sum;
+        uint32_t count;
+    };
+
+    // The confidence comes first, it tells whether the coordinates follow
+    static uint32_t channelOrder(uint32_t channel) {
+        return (channel + CONFIDENCE) % CHANNELS;
+    }
+
+    static int32_t quantize(float value, float scale) {
+        if (std::isnan(value)) {
+            return 0;
+        }
+        float scaled = std::max(std::min(value * scale, float(MAX_VALUE)), -float(MAX_VALUE));
+        return static_cast<int32_t>(std::lround(scaled));
+    }
+
+    // Valid points keep a confidence of at least 1
+    static int32_t quantizeConfidence(float confidence, float scale) {
+        if (!(confidence > 0.f)) {
+            return 0;
+        }
+        return std::min(std::max(static_cast<int32_t>(std::lround(confidence * scale)), 1), 255);
+    }
+
+    static uint32_t zigzag(int64_t residual) {
+        return static_cast<uint32_t>(residual >= 0 ? 2 * residual : -2 * residual - 1);
+    }
+
+    static int64_t unzigzag(uint32_t mapped) {
+        return (mapped & 1u) ? -int64_t(mapped >> 1) - 1 : int64_t(mapped >> 1);
+    }
+
+    static uint32_t contextIndex(int32_t activity) {
+        uint32_t index = 0;
+        for (auto value = static_cast<uint32_t>(activity); value > 1 && index < ACTIVITY_CONTEXTS - 1; value >>= 2) {
+            index++;
+        }
+        return index;
+    }
+
+    static uint32_t riceParameter(const Context &context) {
+        uint32_t k = 0;
+        while ((uint64_t(context.count) << k) < context.sum && k < MAX_K) {
+            k++;
+        }
+        return k;
+    }
+
+    static void updateContext(Context &context, uint32_t mapped) {
+        context.sum += mapped;
+        if (++context.count >= CONTEXT_RESET) {
+            context.sum >>= 1;
+            context.count >>= 1;
+        }
+    }
+
+    static void encodeResidual(CloudBitWriter &writer, Context &context, uint32_t mapped) {
+        auto k = riceParameter(context);
+        auto quotient = mapped >> k;
+        if (quotient < ESCAPE_LIMIT) {
+            writer.writeOnes(quotient);
+            writer.write(0u, 1);
+            writer.write(mapped, k);
+        } else {
+            writer.writeOnes(ESCAPE_LIMIT);
+            writer.write(mapped, 32);
+        }
+        updateContext(context, mapped);
+    }
+
+    static uint32_t decodeResidual(CloudBitReader &reader, Context &context) {
+        auto k = riceParameter(context);
+        auto quotient = reader.readOnes(ESCAPE_LIMIT);
+        uint32_t mapped;
+        if (quotient < ESCAPE_LIMIT) {
+            mapped = (quotient << k) | reader.read(k);
+        } else {
+            mapped = reader.read(32);
+        }
+        updateContext(context, mapped);
+        return mapped;
+    }
+
+    void start(uint32_t width) {
+        m_width = width;
+        m_rows.assign(size_t(2) * CHANNELS * width, 0);
+        m_current = 0;
+        for (auto &channel : m_contexts) {
+            for (auto &context : channel) {
+                context = Context{4, 1};
+            }
+        }
+    }
+
+    int32_t *currentRow() {
+        return m_rows.data() + size_t(m_current) * CHANNELS * m_width;
+    }
+
+    const int32_t *previousRow() const {
+        return m_rows.data() + size_t(1 - m_current) * CHANNELS * m_width;
+    }
+
+    void nextRow() {
+        m_current = 1 - m_current;
+    }
+
+    // Median edge detector on the left (a), upper (b) and upper left (c) neighbor
+    int32_t predict(uint32_t x, uint32_t y, uint32_t channel, int32_t &activity) const {
+        const int32_t *row = m_rows.data() + size_t(m_current) * CHANNELS * m_width;
+        const int32_t *above = previousRow();
+        activity = 0;
+        if (y == 0) {
+            return x == 0 ? 0 : row[CHANNELS * (x - 1) + channel];
+        }
+        int32_t b = above[CHANNELS * x + channel];
+        if (x == 0) {
+            return b;
+        }
+        int32_t a = row[CHANNELS * (x - 1) + channel];
+        int32_t c = above[CHANNELS * (x - 1) + channel];
+        int64_t gradient = std::abs(int64_t(a) - c) + std::abs(int64_t(b) - c);
+        activity = static_cast<int32_t>(std::min(gradient, int64_t(MAX_VALUE)));
+        if (c >= std::max(a, b)) {
+            return std::min(a, b);
+        }
+        if (c <= std::min(a, b)) {
+            return std::max(a, b);
+        }
+        return a + b - c;
+    }
+
+    uint32_t m_width;
+    std::vector<int32_t> m_rows;
+    uint32_t m_current;
+    Context m_contexts[CHANNELS][ACTIVITY_CONTEXTS];
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__CLOUD_CODEC_HPP__
@@ -0,0 +1,68 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__DEPTH_STATISTICS_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__DEPTH_STATISTICS_HPP__
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+#include <std_msgs/msg/float32_multi_array.hpp>
+
+#include "Frame.hpp"
+
+namespace pmd_royale_ros_driver {
+
+/// Summarizes the depth of a frame for health monitoring, so monitors don't need the depth image.
+///
+/// The statistics are the ratio of valid pixels, the minimum, maximum and mean depth of the valid pixels and the
+/// fraction of the valid pixels in each of HISTOGRAM_BINS equally wide depth bins up to the histogram range; the
+/// last bin also holds everything beyond. They are computed while the depth image is filled, in one pass over the
+/// frame, with the sums, minimum and maximum kept in fixed lanes so the compiler can vectorize them.
+class DepthStatistics {
+  public:
+    static constexpr uint32_t HISTOGRAM_BINS = 16;
+
+    /// Valid ratio, minimum, maximum, mean and the histogram
+    static constexpr uint32_t NUM_VALUES = 4 + HISTOGRAM_BINS;
+
+    struct Settings {
+        // Statistics of every n-th frame are published
+        uint32_t decimation;
+        float histogramRange;
+    };
+
+    DepthStatistics();
+
+    void configure(const Settings &settings);
+
+    /// Count a frame, returns whether the statistics of this frame are due
+    bool nextFrame();
+
+    /// Compute the statistics of the frame. If depth isn't null, the depth of every pixel is written to it in the
+    /// same pass, numPoints() floats.
+    void apply(const Frame &frame, float *depth);
+
+    /// Fill the message with the statistics of the last frame
+    void fill(std_msgs::msg::Float32MultiArray &msg) const;
+
+  private:
+    template <bool WriteDepth>
+    void accumulate(const Frame &frame, float *depth);
+
+    std::mutex m_mutex;
+    Settings m_settings;
+    uint32_t m_frameCount;
+    std::array<float, NUM_VALUES> m_values;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__DEPTH_STATISTICS_HPP__
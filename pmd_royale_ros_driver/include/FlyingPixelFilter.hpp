@@ -0,0 +1,71 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__FLYING_PIXEL_FILTER_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__FLYING_PIXEL_FILTER_HPP__
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Frame.hpp"
+#include "RowBandPool.hpp"
+
+namespace pmd_royale_ros_driver {
+
+/// Invalidates flying pixels, the mixed depth values time-of-flight cameras produce at depth discontinuities.
+///
+/// Every valid neighbor in a window of 3x3 or 5x5 pixels is tested: it is suspicious if its depth differs by more
+/// than maxDepthJump times the depth of the pixel, or if the line to it is closer than minAngle to the viewing ray,
+/// i.e. the surface between them would be seen at a grazing angle. A pixel with more suspicious than regular
+/// neighbors lies between two surfaces and is invalidated. Real edges keep their pixels, as these have the
+/// neighbors on their own surface. The loops run over one neighbor offset at a time on deinterleaved rows, so the
+/// compiler vectorizes them.
+class FlyingPixelFilter {
+  public:
+    struct Settings {
+        bool enabled;
+        uint32_t windowSize;
+        float maxDepthJump;
+        float minAngle; // degrees
+    };
+
+    FlyingPixelFilter();
+
+    void configure(const Settings &settings);
+
+    /// Filter the frame in place. Invalid points have all coordinates and the confidence set to 0.
+    void apply(Frame &frame, RowBandPool &pool);
+
+  private:
+    void filterRows(Frame &frame, uint32_t firstRow, uint32_t endRow);
+
+    // Instantiated for the row widths of the Flexx2 usecases, so the loops over a row have a known trip count, and
+    // with Width 0 for any other width
+    template <int Width>
+    void filterRowsOfWidth(Frame &frame, uint32_t firstRow, uint32_t endRow);
+
+    std::mutex m_mutex;
+    Settings m_settings;
+    float m_cosMinAngleSq;
+
+    // Deinterleaved copy of the unfiltered frame and per pixel counters
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<float> m_valid;
+    std::vector<float> m_suspicious;
+    std::vector<float> m_neighbors;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__FLYING_PIXEL_FILTER_HPP__
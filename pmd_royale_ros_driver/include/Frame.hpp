@@ -0,0 +1,180 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__FRAME_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__FRAME_HPP__
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <std_msgs/msg/header.hpp>
+
+namespace pmd_royale_ros_driver {
+
+/// Takes over the planes of frames when they are destroyed, so their buffers can be reused. recycle() is called
+/// from whichever thread drops the last reference to the frame and must not throw.
+class FramePlaneRecycler {
+  public:
+    virtual ~FramePlaneRecycler() = default;
+
+    virtual void recycle(std::vector<float> &&xyzc, std::vector<uint8_t> &&gray) = 0;
+};
+
+/// One captured frame of a camera stream in its native layout.
+///
+/// The point plane is the organized x, y, z, confidence grid exactly as Royale delivers it (four floats per
+/// pixel, row major). The gray plane holds the MONO8 amplitude image of the same capture if it was available.
+/// If the stream has a region of interest, the frame only holds that part of the sensor, which starts at
+/// xOffset(), yOffset() of the fullWidth() x fullHeight() image.
+/// A frame is filled by the camera node and becomes immutable once it is published; intra-process
+/// subscribers receive it as std::shared_ptr<const Frame> without any copy.
+/// A frame with a recycler hands its planes to it when it is destroyed, which is how the frames of a FramePool
+/// come back after intra-process subscribers dropped them.
+class Frame {
+  public:
+    /// Fields of the PointCloud2 the frame is converted to, in this order. The intensity is the gray value.
+    enum class CloudFields { Xyz, Xyzc, Xyzi, Xyzic };
+
+    Frame()
+        : m_width(0), m_height(0), m_xOffset(0), m_yOffset(0), m_fullWidth(0), m_fullHeight(0),
+          m_cloudFields(CloudFields::Xyzc) {}
+
+    Frame(uint32_t width, uint32_t height) : m_cloudFields(CloudFields::Xyzc) {
+        resize(width, height);
+    }
+
+    Frame(const Frame &) = default;
+    Frame(Frame &&) = default;
+    Frame &operator=(const Frame &) = default;
+    Frame &operator=(Frame &&) = default;
+
+    ~Frame() {
+        if (m_recycler) {
+            m_recycler->recycle(std::move(m_xyzc), std::move(m_gray));
+        }
+    }
+
+    void setRecycler(std::shared_ptr<FramePlaneRecycler> recycler) {
+        m_recycler = std::move(recycler);
+    }
+
+    /// Exchange the planes with the given buffers, their content is undefined until the next resize()
+    void swapPlanes(std::vector<float> &xyzc, std::vector<uint8_t> &gray) {
+        m_xyzc.swap(xyzc);
+        m_gray.swap(gray);
+    }
+
+    void resize(uint32_t width, uint32_t height) {
+        m_width = width;
+        m_height = height;
+        m_xyzc.resize(4u * width * height);
+        m_gray.clear();
+        setRegion(0, 0, width, height);
+    }
+
+    /// Position of the frame within the full image of the sensor
+    void setRegion(uint32_t xOffset, uint32_t yOffset, uint32_t fullWidth, uint32_t fullHeight) {
+        m_xOffset = xOffset;
+        m_yOffset = yOffset;
+        m_fullWidth = fullWidth;
+        m_fullHeight = fullHeight;
+    }
+
+    uint32_t width() const {
+        return m_width;
+    }
+
+    uint32_t height() const {
+        return m_height;
+    }
+
+    uint32_t xOffset() const {
+        return m_xOffset;
+    }
+
+    uint32_t yOffset() const {
+        return m_yOffset;
+    }
+
+    uint32_t fullWidth() const {
+        return m_fullWidth;
+    }
+
+    uint32_t fullHeight() const {
+        return m_fullHeight;
+    }
+
+    uint32_t numPoints() const {
+        return m_width * m_height;
+    }
+
+    /// Interleaved x, y, z and confidence values, 4 * numPoints() floats
+    const float *xyzc() const {
+        return m_xyzc.data();
+    }
+
+    float *xyzc() {
+        return m_xyzc.data();
+    }
+
+    bool hasGray() const {
+        return !m_gray.empty();
+    }
+
+    /// Gray values of the same capture, numPoints() bytes. Only valid if hasGray() is true.
+    const uint8_t *gray() const {
+        return m_gray.data();
+    }
+
+    void setGray(const uint8_t *gray) {
+        m_gray.assign(gray, gray + numPoints());
+    }
+
+    /// Allocate the gray plane and return it to be filled in place, numPoints() bytes
+    uint8_t *initGray() {
+        m_gray.resize(numPoints());
+        return m_gray.data();
+    }
+
+    CloudFields cloudFields() const {
+        return m_cloudFields;
+    }
+
+    void setCloudFields(CloudFields cloudFields) {
+        m_cloudFields = cloudFields;
+    }
+
+    bool hasConfidenceField() const {
+        return m_cloudFields == CloudFields::Xyzc || m_cloudFields == CloudFields::Xyzic;
+    }
+
+    bool hasIntensityField() const {
+        return m_cloudFields == CloudFields::Xyzi || m_cloudFields == CloudFields::Xyzic;
+    }
+
+    std_msgs::msg::Header header;
+
+  private:
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_xOffset;
+    uint32_t m_yOffset;
+    uint32_t m_fullWidth;
+    uint32_t m_fullHeight;
+    CloudFields m_cloudFields;
+    std::vector<float> m_xyzc;
+    std::vector<uint8_t> m_gray;
+    std::shared_ptr<FramePlaneRecycler> m_recycler;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__FRAME_HPP__
@@ -0,0 +1,80 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__FRAME_CONVERSIONS_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__FRAME_CONVERSIONS_HPP__
+
+#include <cstdint>
+#include <cstring>
+
+#include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/region_of_interest.hpp>
+
+#include "Frame.hpp"
+
+namespace pmd_royale_ros_driver {
+
+class DepthStatistics;
+
+/// Row widths of the Flexx2 usecases. The row kernels of copyRoi and of the FlyingPixelFilter are instantiated for
+/// them, so the trip count of their inner loops is known at compile time and they are unrolled and vectorized
+/// without a remainder; other widths take the generic instantiation.
+constexpr uint32_t FLEXX2_WIDTH = 224;
+constexpr uint32_t FLEXX2_VGA_WIDTH = 640;
+
+/// Limit the region of interest to the image, an empty region selects the whole image
+sensor_msgs::msg::RegionOfInterest clampRoi(const sensor_msgs::msg::RegionOfInterest &roi, uint32_t width,
+                                            uint32_t height);
+
+/// Copy the region of interest out of the full xyzc grid. Points outside the mask are invalidated on the way.
+void copyRoi(const float *src, uint32_t srcWidth, const sensor_msgs::msg::RegionOfInterest &roi, const uint8_t *mask,
+             float *dst);
+
+/// Copy the region of interest out of the full gray image
+void copyGrayRoi(const uint8_t *src, uint32_t srcWidth, const sensor_msgs::msg::RegionOfInterest &roi, uint8_t *dst);
+
+/// Fill the depth image, and compute the statistics of the frame in the same pass if they are given
+void fillDepthImage(const Frame &frame, sensor_msgs::msg::Image &msgDepthImage, DepthStatistics *statistics = nullptr);
+
+/// Pack the points into the interleaved layout of a PointCloud2 with the fields x, y, z, then intensity and conf
+/// if they are selected. The field selection is a template parameter, so the loop has no branches per point.
+/// Without a gray plane the intensity is 0.
+template <bool HasIntensity, bool HasConf>
+void packPoints(const float *xyzc, const uint8_t *gray, uint32_t numPoints, float *points) {
+    for (auto i = 0u; i < numPoints; ++i, xyzc += 4) {
+        *points++ = xyzc[0];
+        *points++ = xyzc[1];
+        *points++ = xyzc[2];
+        if (HasIntensity) {
+            *points++ = gray ? static_cast<float>(gray[i]) : 0.f;
+        }
+        if (HasConf) {
+            *points++ = xyzc[3];
+        }
+    }
+}
+
+/// Pack the points with the instantiation of packPoints for the selected fields. The native layout is x, y, z, conf,
+/// so that one is a plain copy.
+inline void packCloud(const float *xyzc, const uint8_t *gray, uint32_t numPoints, bool hasIntensity, bool hasConf,
+                      float *points) {
+    if (hasIntensity && hasConf) {
+        packPoints<true, true>(xyzc, gray, numPoints, points);
+    } else if (hasIntensity) {
+        packPoints<true, false>(xyzc, gray, numPoints, points);
+    } else if (hasConf) {
+        ::memcpy(points, xyzc, 4 * sizeof(float) * numPoints);
+    } else {
+        packPoints<false, false>(xyzc, gray, numPoints, points);
+    }
+}
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__FRAME_CONVERSIONS_HPP__
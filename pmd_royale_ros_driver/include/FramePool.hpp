@@ -0,0 +1,67 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__FRAME_POOL_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__FRAME_POOL_HPP__
+
+#include "Frame.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pmd_royale_ros_driver {
+
+/// Recycles the frames of a stream, so their buffers are allocated once instead of for every capture.
+///
+/// A frame keeps the capacity of its planes when it is resized, so in steady state acquiring and filling a frame
+/// doesn't touch the heap. Frames which are handed to intra-process subscribers belong to them and are not
+/// released; their planes come back through the recycler of the pool once the last subscriber drops them, and
+/// acquire() puts them into a new Frame. Only the Frame object itself is allocated then, the planes are not.
+class FramePool {
+  public:
+    explicit FramePool(size_t maxFrames);
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    /// A recycled frame if one is available, otherwise a new one. The content of the frame is undefined.
+    std::unique_ptr<Frame> acquire();
+
+    /// Return a frame which stayed with the caller for reuse. If the pool is full, it is freed and its planes are
+    /// recycled. A frame which was moved into a publisher is null here and comes back through the recycler.
+    void release(std::unique_ptr<Frame> frame);
+
+  private:
+    class PlaneRecycler : public FramePlaneRecycler {
+      public:
+        explicit PlaneRecycler(size_t maxPlanes);
+
+        void recycle(std::vector<float> &&xyzc, std::vector<uint8_t> &&gray) override;
+
+        /// Move recycled planes into frame, returns false if there are none
+        bool take(Frame &frame);
+
+      private:
+        std::mutex m_mutex;
+        size_t m_maxPlanes;
+        std::vector<std::vector<float>> m_xyzc;
+        std::vector<std::vector<uint8_t>> m_gray;
+    };
+
+    std::mutex m_mutex;
+    size_t m_maxFrames;
+    std::vector<std::unique_ptr<Frame>> m_frames;
+    std::shared_ptr<PlaneRecycler> m_recycler;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__FRAME_POOL_HPP__
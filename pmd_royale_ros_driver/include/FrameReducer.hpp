@@ -0,0 +1,73 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__FRAME_REDUCER_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__FRAME_REDUCER_HPP__
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sensor_msgs/msg/camera_info.hpp>
+
+#include "Frame.hpp"
+#include "RowBandPool.hpp"
+
+namespace pmd_royale_ros_driver {
+
+/// Reduces a frame to a lower resolution by combining blocks of factor x factor pixels.
+///
+/// Only valid points of a block take part: mean averages them, median picks the one with the median depth and
+/// nearest picks the one closest to the center of the block, which is a decimation that falls back to a neighbor
+/// for invalid center pixels. A block without valid points stays invalid. The reduced frame covers the same field
+/// of view, reduceCameraInfo scales the intrinsics to match. If the cloud of the frame has an intensity field, the
+/// gray plane is reduced as well, to the mean of each block.
+class FrameReducer {
+  public:
+    enum class Mode { Mean, Median, Nearest };
+
+    struct Settings {
+        Mode mode;
+        uint32_t factor;
+    };
+
+    static constexpr uint32_t MAX_FACTOR = 4;
+
+    /// Parse "mean", "median" or "nearest", returns false for anything else
+    static bool parseMode(const std::string &name, Mode &mode);
+
+    FrameReducer();
+
+    void configure(const Settings &settings);
+
+    /// Fill reduced from frame, including header and region. Returns the factor of the reduction, the camera info
+    /// of the reduced frame has to be scaled by it rather than by the current settings, which may have changed since.
+    uint32_t apply(const Frame &frame, Frame &reduced, RowBandPool &pool);
+
+    /// Scale the intrinsics and roi of a full resolution camera info to frames reduced by factor
+    static void reduceCameraInfo(uint32_t factor, sensor_msgs::msg::CameraInfo &cameraInfo);
+
+  private:
+    void reduceRows(const Frame &frame, Frame &reduced, uint32_t firstRow, uint32_t endRow);
+    void reduceGray(const Frame &frame, Frame &reduced);
+
+    std::mutex m_mutex;
+    Settings m_settings;
+
+    // Offsets of the pixels of a block, sorted by decreasing distance to its center
+    uint32_t m_blockOrder[MAX_FACTOR * MAX_FACTOR];
+
+    // Reduced gray plane, kept to avoid an allocation per frame
+    std::vector<uint8_t> m_gray;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__FRAME_REDUCER_HPP__
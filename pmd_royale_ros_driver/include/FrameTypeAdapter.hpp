@@ -0,0 +1,133 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__FRAME_TYPE_ADAPTER_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__FRAME_TYPE_ADAPTER_HPP__
+
+#include "Frame.hpp"
+#include "FrameConversions.hpp"
+
+#include <rclcpp/type_adapter.hpp>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <sensor_msgs/point_cloud2_iterator.hpp>
+
+// REP-2007 type adapter between Frame and sensor_msgs/PointCloud2. Publishers and subscriptions created for
+// FrameAdapter exchange Frames intra-process without any conversion; the PointCloud2 is only materialized
+// when an inter-process subscriber is present.
+namespace rclcpp {
+
+template <>
+struct TypeAdapter<pmd_royale_ros_driver::Frame, sensor_msgs::msg::PointCloud2> {
+    using is_specialized = std::true_type;
+    using custom_type = pmd_royale_ros_driver::Frame;
+    using ros_message_type = sensor_msgs::msg::PointCloud2;
+
+    static void convert_to_ros_message(const custom_type &source, ros_message_type &destination) {
+        destination.header = source.header;
+        destination.width = source.width();
+        destination.height = source.height();
+        destination.is_bigendian = false;
+        destination.is_dense = false;
+
+        bool hasIntensity = source.hasIntensityField();
+        bool hasConf = source.hasConfidenceField();
+        setFields(destination, hasIntensity, hasConf);
+        destination.row_step = destination.point_step * destination.width;
+        destination.data.resize(size_t(destination.row_step) * destination.height);
+
+        // Only the selected fields are written, in a single pass over the point and gray planes
+        float *points = reinterpret_cast<float *>(destination.data.data());
+        const uint8_t *gray = source.hasGray() ? source.gray() : nullptr;
+        pmd_royale_ros_driver::packCloud(source.xyzc(), gray, source.numPoints(), hasIntensity, hasConf, points);
+    }
+
+    static void convert_to_custom(const ros_message_type &source, custom_type &destination) {
+        destination.header = source.header;
+        destination.resize(source.width, source.height);
+
+        bool hasConf = false;
+        bool hasIntensity = false;
+        for (auto &field : source.fields) {
+            hasConf |= field.name == "conf";
+            hasIntensity |= field.name == "intensity";
+        }
+        destination.setCloudFields(hasIntensity ? (hasConf ? custom_type::CloudFields::Xyzic : custom_type::CloudFields::Xyzi)
+                                                : (hasConf ? custom_type::CloudFields::Xyzc : custom_type::CloudFields::Xyz));
+
+        sensor_msgs::PointCloud2ConstIterator<float> iterX(source, "x");
+        sensor_msgs::PointCloud2ConstIterator<float> iterY(source, "y");
+        sensor_msgs::PointCloud2ConstIterator<float> iterZ(source, "z");
+        if (hasIntensity) {
+            std::vector<uint8_t> gray(destination.numPoints());
+            sensor_msgs::PointCloud2ConstIterator<float> iterIntensity(source, "intensity");
+            for (auto i = 0u; i < destination.numPoints(); ++i, ++iterIntensity) {
+                gray[i] = static_cast<uint8_t>(*iterIntensity);
+            }
+            destination.setGray(gray.data());
+        }
+        float *xyzc = destination.xyzc();
+        if (hasConf) {
+            sensor_msgs::PointCloud2ConstIterator<float> iterConf(source, "conf");
+            for (auto i = 0u; i < destination.numPoints(); ++i, ++iterX, ++iterY, ++iterZ, ++iterConf) {
+                *xyzc++ = *iterX;
+                *xyzc++ = *iterY;
+                *xyzc++ = *iterZ;
+                *xyzc++ = *iterConf;
+            }
+        } else {
+            for (auto i = 0u; i < destination.numPoints(); ++i, ++iterX, ++iterY, ++iterZ) {
+                *xyzc++ = *iterX;
+                *xyzc++ = *iterY;
+                *xyzc++ = *iterZ;
+                *xyzc++ = 1.0f;
+            }
+        }
+    }
+
+  private:
+    // A message which is reused for every frame keeps its fields, setting them again would allocate
+    static void setFields(ros_message_type &msg, bool hasIntensity, bool hasConf) {
+        const char *names[5] = {"x", "y", "z", nullptr, nullptr};
+        uint32_t numFields = 3;
+        if (hasIntensity) {
+            names[numFields++] = "intensity";
+        }
+        if (hasConf) {
+            names[numFields++] = "conf";
+        }
+
+        bool isSame = msg.fields.size() == numFields;
+        for (auto i = 0u; isSame && i < numFields; ++i) {
+            isSame = msg.fields[i].name == names[i];
+        }
+        if (!isSame) {
+            msg.fields.resize(numFields);
+            for (auto i = 0u; i < numFields; ++i) {
+                msg.fields[i].name = names[i];
+                msg.fields[i].offset = i * sizeof(float);
+                msg.fields[i].datatype = sensor_msgs::msg::PointField::FLOAT32;
+                msg.fields[i].count = 1;
+            }
+        }
+        msg.point_step = numFields * sizeof(float);
+    }
+};
+
+} // namespace rclcpp
+
+RCLCPP_USING_CUSTOM_TYPE_AS_ROS_MESSAGE_TYPE(pmd_royale_ros_driver::Frame, sensor_msgs::msg::PointCloud2);
+
+namespace pmd_royale_ros_driver {
+
+using FrameAdapter = rclcpp::TypeAdapter<Frame, sensor_msgs::msg::PointCloud2>;
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__FRAME_TYPE_ADAPTER_HPP__
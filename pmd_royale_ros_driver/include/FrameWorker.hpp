@@ -0,0 +1,57 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__FRAME_WORKER_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__FRAME_WORKER_HPP__
+
+#include "Frame.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace pmd_royale_ros_driver {
+
+/// Converts and publishes the frames of one stream on a dedicated thread.
+///
+/// The Royale callback only copies the frame and hands it over, so it returns immediately and the streams of a
+/// mixed mode usecase are converted in parallel. At most one frame waits for conversion; if the worker falls
+/// behind, the waiting frame is replaced by the newer one and given back to the caller for reuse.
+/// Every frame carries the bit mask of the throttled outputs which are due for it. The mask of a dropped frame is
+/// passed on to the newer one, so a throttled output doesn't miss its frame because the worker fell behind.
+class FrameWorker {
+  public:
+    using Handler = std::function<void(std::unique_ptr<Frame>, uint32_t)>;
+
+    explicit FrameWorker(Handler handler);
+    ~FrameWorker();
+
+    FrameWorker(const FrameWorker &) = delete;
+    FrameWorker &operator=(const FrameWorker &) = delete;
+
+    /// Queue a frame for conversion. Returns the waiting frame if it had to be dropped for it, otherwise nullptr.
+    std::unique_ptr<Frame> post(std::unique_ptr<Frame> frame, uint32_t throttledOutputs = 0);
+
+  private:
+    void run();
+
+    Handler m_handler;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::unique_ptr<Frame> m_pending;
+    uint32_t m_pendingOutputs;
+    bool m_stop;
+    std::thread m_thread;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__FRAME_WORKER_HPP__
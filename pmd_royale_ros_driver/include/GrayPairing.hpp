@@ -0,0 +1,68 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__GRAY_PAIRING_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__GRAY_PAIRING_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <sensor_msgs/msg/region_of_interest.hpp>
+
+#include "Frame.hpp"
+
+namespace pmd_royale_ros_driver {
+
+/// Attaches the gray image of a capture to the frame of the same capture, whichever of the two comes first.
+///
+/// Royale calls the point cloud and the IR image listener of a capture one after the other, but in no specified
+/// order. A gray image which comes first is kept until the frame comes. A frame which needs the gray image and comes
+/// first is held back until it does, so the second callback of a capture hands the frame on. A held frame whose gray
+/// image doesn't come is handed on without it as soon as the gray image or the frame of a later capture arrives.
+class GrayPairing {
+  public:
+    struct Handoff {
+        std::unique_ptr<Frame> frame;
+        uint32_t throttledOutputs = 0;
+    };
+
+    /// Frames which are ready after a callback, each may be null
+    struct Result {
+        // The frame of the capture, with its gray image if it came
+        Handoff complete;
+        // A frame which was held back for a gray image which didn't come
+        Handoff withoutGray;
+    };
+
+    GrayPairing();
+
+    /// Frame of a capture. If needsGray is false, the frame is complete right away, the gray image is only attached
+    /// if it is already there.
+    Result addFrame(std::unique_ptr<Frame> frame, uint64_t timestamp, uint32_t throttledOutputs, bool needsGray);
+
+    /// Gray image of a capture, the region of interest is copied out of it
+    Result addGray(const uint8_t *gray, uint32_t width, const sensor_msgs::msg::RegionOfInterest &roi,
+                   uint64_t timestamp);
+
+  private:
+    // Attach the kept gray image if it belongs to the capture of the frame
+    bool attachGray(Frame &frame, uint64_t timestamp) const;
+
+    std::mutex m_mutex;
+    std::vector<uint8_t> m_gray;
+    uint64_t m_grayTimestamp;
+    Handoff m_held;
+    uint64_t m_heldTimestamp;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__GRAY_PAIRING_HPP__
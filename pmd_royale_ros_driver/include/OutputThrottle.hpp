@@ -0,0 +1,64 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__OUTPUT_THROTTLE_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__OUTPUT_THROTTLE_HPP__
+
+#include <cstdint>
+#include <string>
+
+namespace pmd_royale_ros_driver {
+
+/// Decides which frames of a stream a throttled output publishes.
+///
+/// A throttled output is a secondary point cloud or depth image topic of a stream for a consumer which needs fewer
+/// frames, like a teleoperation view. It is given as "<output>/<name>:<policy>[:reduced]", e.g.
+/// "point_cloud/teleop:2hz" or "depth_image/logger:every_10:reduced". The output is point_cloud or depth_image, the
+/// topic of stream n is <output>_<n>/<name>. The policy is either a rate in Hz, for which the frames are picked by
+/// their stamps, or every_<n> for every n-th frame. With reduced, the output has the resolution of the reduced
+/// outputs. The decision is made in the capture callback, so skipped frames cost nothing for the output.
+class OutputThrottle {
+  public:
+    enum class Output { PointCloud, DepthImage };
+    enum class Policy { Rate, EveryNth };
+
+    struct Settings {
+        Output output;
+        std::string name;
+        Policy policy;
+        double rate;
+        uint32_t every;
+        bool isReduced;
+    };
+
+    /// Parse the description of an output, returns false if it is invalid
+    static bool parse(const std::string &description, Settings &settings);
+
+    explicit OutputThrottle(const Settings &settings);
+
+    const Settings &settings() const {
+        return m_settings;
+    }
+
+    /// Topic of the output for a stream, relative to the node name
+    std::string topic(uint32_t streamIdx) const;
+
+    /// Count a frame, returns whether the output publishes it
+    bool nextFrame(int64_t stampNs);
+
+  private:
+    Settings m_settings;
+    int64_t m_periodNs;
+    int64_t m_nextNs;
+    uint32_t m_frameCount;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__OUTPUT_THROTTLE_HPP__
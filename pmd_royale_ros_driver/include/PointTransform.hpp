@@ -0,0 +1,31 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__POINT_TRANSFORM_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__POINT_TRANSFORM_HPP__
+
+#include <array>
+#include <cstddef>
+
+#include <geometry_msgs/msg/transform.hpp>
+
+namespace pmd_royale_ros_driver {
+
+/// Row major 3x4 matrix of a rigid transform
+using PointTransform = std::array<float, 12>;
+
+PointTransform transformMatrix(const geometry_msgs::msg::Transform &transform);
+
+/// Transform interleaved x, y, z, confidence points from in to out, which may be the same buffer. The confidence is
+/// copied, invalid points end up at the origin.
+void transformPoints(const float *in, float *out, size_t numPoints, const PointTransform &m);
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__POINT_TRANSFORM_HPP__
@@ -0,0 +1,50 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__PUBLISH_MESSAGE_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__PUBLISH_MESSAGE_HPP__
+
+#include <memory>
+
+#include "FrameTypeAdapter.hpp"
+
+namespace pmd_royale_ros_driver {
+
+/// Publish a message filled by fill. Without intra-process communication the reused message is published by
+/// reference, so nothing is allocated per frame. With it, the publisher would copy a reused message into a new one
+/// anyway, so a new one is filled and handed over instead.
+template <typename PublisherT, typename MessageT, typename FillT>
+void publishMessage(PublisherT &publisher, MessageT &reused, bool isIntraProcess, FillT fill) {
+    if (isIntraProcess) {
+        auto message = std::make_unique<MessageT>();
+        fill(*message);
+        publisher.publish(std::move(message));
+    } else {
+        fill(reused);
+        publisher.publish(reused);
+    }
+}
+
+/// Publish the cloud of a frame. Intra-process subscribers take the frame as is and it is moved out, its planes
+/// return to its FramePool once they drop it. Otherwise the frame is packed into the reused message and stays
+/// with the caller.
+template <typename PublisherT>
+void publishFrame(PublisherT &publisher, sensor_msgs::msg::PointCloud2 &reused, bool isIntraProcess,
+                  std::unique_ptr<Frame> &frame) {
+    if (isIntraProcess) {
+        publisher.publish(std::move(frame));
+    } else {
+        FrameAdapter::convert_to_ros_message(*frame, reused);
+        publisher.publish(reused);
+    }
+}
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__PUBLISH_MESSAGE_HPP__
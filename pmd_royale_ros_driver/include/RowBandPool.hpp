@@ -0,0 +1,65 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__ROW_BAND_POOL_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__ROW_BAND_POOL_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pmd_royale_ros_driver {
+
+/// Splits the rows of a frame into bands and processes them on a fixed set of threads.
+///
+/// The calling thread works on the bands as well, so a pool with zero threads simply runs the whole frame
+/// inline. Only one frame can be processed at a time, each stream owns its own pool.
+class RowBandPool {
+  public:
+    using BandFunction = std::function<void(uint32_t firstRow, uint32_t endRow)>;
+
+    explicit RowBandPool(uint32_t numThreads);
+    ~RowBandPool();
+
+    RowBandPool(const RowBandPool &) = delete;
+    RowBandPool &operator=(const RowBandPool &) = delete;
+
+    /// Call fn for bands covering the rows [0, numRows) and return once all of them are done
+    void run(uint32_t numRows, const BandFunction &fn);
+
+    uint32_t numThreads() const {
+        return static_cast<uint32_t>(m_threads.size());
+    }
+
+  private:
+    void worker();
+    void processBands();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_startCondition;
+    std::condition_variable m_doneCondition;
+    bool m_stop;
+    uint64_t m_generation;
+    uint32_t m_busyThreads;
+
+    // Current job
+    const BandFunction *m_fn;
+    uint32_t m_numRows;
+    uint32_t m_bandRows;
+    std::atomic<uint32_t> m_nextRow;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__ROW_BAND_POOL_HPP__
@@ -0,0 +1,186 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__SHM_FRAME_RING_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__SHM_FRAME_RING_HPP__
+
+// Layout of the POSIX shared memory frame ring exported by the camera node and a header-only reader for it.
+// This header has no dependencies besides the C++ standard library and POSIX, so processes which are not
+// built against ROS can include it directly.
+//
+// The ring consists of a ShmRingHeader followed by slotCount slots. Each slot starts with a ShmSlotHeader and
+// holds the interleaved x, y, z, confidence floats of one frame, optionally followed by its gray values.
+// Frame n is written to slot n % slotCount. Slots are protected by a seqlock: the writer makes the slot's
+// lock counter odd while it is writing and even again when it is done, readers validate that the counter
+// did not change while they were accessing the slot.
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pmd_royale_ros_driver {
+
+static const uint32_t SHM_RING_MAGIC = 0x524d4450; // "PMDR"
+static const uint32_t SHM_RING_VERSION = 1u;
+static const uint32_t SHM_RING_ALIGNMENT = 64u;
+
+struct ShmRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotStride;   // Bytes between the start of two slots
+    uint32_t payloadSize;  // Maximum payload bytes per slot
+    uint32_t reserved;
+    std::atomic<uint64_t> lastSequence; // Sequence number of the last completely written frame, 0 if none
+};
+
+struct ShmSlotHeader {
+    std::atomic<uint64_t> lock; // Seqlock counter, odd while the slot is being written
+    uint64_t sequence;          // Frame sequence number, starting at 1
+    int64_t stamp;              // Header stamp of the frame in nanoseconds
+    uint32_t width;
+    uint32_t height;
+    uint32_t hasGray;
+    uint32_t reserved;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The shared memory ring requires lock free atomics");
+
+/// Name of the shared memory object which carries the frames of one stream of a camera node. shm_open only takes
+/// names with a single leading '/', so the slashes of a namespaced node name are replaced by '_'.
+inline std::string shmFrameRingName(const std::string &nodeName, uint32_t streamIdx) {
+    std::string name = nodeName;
+    for (auto &c : name) {
+        if (c == '/') {
+            c = '_';
+        }
+    }
+    return "/" + name + "_point_cloud_" + std::to_string(streamIdx);
+}
+
+inline uint32_t shmAlign(uint32_t size) {
+    return (size + SHM_RING_ALIGNMENT - 1) / SHM_RING_ALIGNMENT * SHM_RING_ALIGNMENT;
+}
+
+/// Frame as seen by a reader. Pointers refer directly into the shared memory and are only valid inside the
+/// ShmFrameRingReader::read callback.
+struct ShmFrameView {
+    uint64_t sequence;
+    int64_t stamp;
+    uint32_t width;
+    uint32_t height;
+    const float *xyzc;
+    const uint8_t *gray; // nullptr if the frame has no gray plane
+};
+
+/// Zero-copy reader for a frame ring. The sequence numbers to read are announced by the camera node on the
+/// point_cloud_<n>/shm topic.
+class ShmFrameRingReader {
+  public:
+    ShmFrameRingReader() : m_base(nullptr), m_size(0) {}
+
+    ~ShmFrameRingReader() {
+        close();
+    }
+
+    ShmFrameRingReader(const ShmFrameRingReader &) = delete;
+    ShmFrameRingReader &operator=(const ShmFrameRingReader &) = delete;
+
+    bool open(const std::string &name) {
+        close();
+        int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < shmAlign(sizeof(ShmRingHeader))) {
+            ::close(fd);
+            return false;
+        }
+        void *base = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            return false;
+        }
+        m_base = static_cast<const uint8_t *>(base);
+        m_size = st.st_size;
+        if (header()->magic != SHM_RING_MAGIC || header()->version != SHM_RING_VERSION || header()->slotCount == 0 ||
+            shmAlign(sizeof(ShmRingHeader)) + static_cast<size_t>(header()->slotCount) * header()->slotStride > m_size) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (m_base) {
+            ::munmap(const_cast<uint8_t *>(m_base), m_size);
+            m_base = nullptr;
+            m_size = 0;
+        }
+    }
+
+    bool isOpen() const {
+        return m_base != nullptr;
+    }
+
+    uint64_t lastSequence() const {
+        return header()->lastSequence.load(std::memory_order_acquire);
+    }
+
+    /// Calls fn with a view on frame `sequence`. Returns false if the frame is not (or no longer) in the ring.
+    /// Also returns false if the writer touched the slot while fn was running; anything fn derived from the
+    /// view must then be discarded, as the data may have been torn.
+    template <typename Fn>
+    bool read(uint64_t sequence, Fn &&fn) const {
+        auto slot = slotHeader(sequence % header()->slotCount);
+        uint64_t lock = slot->lock.load(std::memory_order_acquire);
+        if ((lock & 1u) || slot->sequence != sequence) {
+            return false;
+        }
+
+        ShmFrameView view;
+        view.sequence = sequence;
+        view.stamp = slot->stamp;
+        view.width = slot->width;
+        view.height = slot->height;
+        if (static_cast<size_t>(view.width) * view.height * (4 * sizeof(float) + (slot->hasGray ? 1 : 0)) >
+            header()->payloadSize) {
+            return false;
+        }
+        view.xyzc = reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(slot) + shmAlign(sizeof(ShmSlotHeader)));
+        view.gray = slot->hasGray ? reinterpret_cast<const uint8_t *>(view.xyzc + 4u * view.width * view.height) : nullptr;
+        fn(view);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot->lock.load(std::memory_order_relaxed) == lock;
+    }
+
+  private:
+    const ShmRingHeader *header() const {
+        return reinterpret_cast<const ShmRingHeader *>(m_base);
+    }
+
+    const ShmSlotHeader *slotHeader(uint32_t idx) const {
+        return reinterpret_cast<const ShmSlotHeader *>(m_base + shmAlign(sizeof(ShmRingHeader)) +
+                                                       static_cast<size_t>(idx) * header()->slotStride);
+    }
+
+    const uint8_t *m_base;
+    size_t m_size;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__SHM_FRAME_RING_HPP__
@@ -0,0 +1,53 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__SHM_FRAME_RING_WRITER_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__SHM_FRAME_RING_WRITER_HPP__
+
+#include "Frame.hpp"
+#include "ShmFrameRing.hpp"
+
+#include <string>
+
+namespace pmd_royale_ros_driver {
+
+/// Creates a shared memory frame ring and writes frames to it. Only one writer may exist per ring.
+class ShmFrameRingWriter {
+  public:
+    ShmFrameRingWriter();
+    ~ShmFrameRingWriter();
+
+    ShmFrameRingWriter(const ShmFrameRingWriter &) = delete;
+    ShmFrameRingWriter &operator=(const ShmFrameRingWriter &) = delete;
+
+    /// Create (or replace) the shared memory object `name` with `slotCount` slots for frames of up to
+    /// `maxPoints` points. Returns false if the object could not be created.
+    bool create(const std::string &name, uint32_t slotCount, uint32_t maxPoints);
+    void destroy();
+
+    bool isOpen() const {
+        return m_base != nullptr;
+    }
+
+    /// Copy the frame into the next slot. Returns its sequence number, or 0 if the frame did not fit.
+    uint64_t write(const Frame &frame);
+
+  private:
+    ShmRingHeader *header();
+    ShmSlotHeader *slotHeader(uint32_t idx);
+
+    std::string m_name;
+    uint8_t *m_base;
+    size_t m_size;
+    uint64_t m_sequence;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__SHM_FRAME_RING_WRITER_HPP__
@@ -0,0 +1,81 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__STREAM_DIAGNOSTICS_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__STREAM_DIAGNOSTICS_HPP__
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include <diagnostic_updater/diagnostic_updater.hpp>
+
+namespace pmd_royale_ros_driver {
+
+/// Frame rate, timestamp gap, drop and processing time statistics of one stream.
+///
+/// The frame callbacks only update a few counters; rates are computed when the diagnostic_updater runs the
+/// task, from a rolling window over the last WINDOW_SIZE updater periods.
+class StreamDiagnostics : public diagnostic_updater::DiagnosticTask {
+  public:
+    static constexpr size_t WINDOW_SIZE = 5;
+
+    explicit StreamDiagnostics(const std::string &name);
+
+    /// Nominal frame rate of the current usecase, 0 if unknown
+    void setNominalFps(double fps);
+
+    /// Whether frames are expected at all, i.e. a data listener is registered for the stream
+    void setActive(bool active);
+
+    /// Called for every frame with its device timestamp and the time spent in the frame callback
+    void onFrame(uint64_t deviceTimestampUs, std::chrono::steady_clock::duration processingTime);
+
+    /// Called for every frame which was received but not published
+    void onFrameDropped();
+
+    /// Called for every cloud with intensity whose gray image didn't come
+    void onFrameWithoutGray();
+
+    /// Called with the time the conversion worker spent on a frame
+    void onFrameConverted(std::chrono::steady_clock::duration conversionTime);
+
+    void run(diagnostic_updater::DiagnosticStatusWrapper &stat) override;
+
+  private:
+    std::mutex m_mutex;
+    double m_nominalFps;
+    bool m_active;
+
+    uint64_t m_frameCount;
+    uint64_t m_lastDeviceTimestamp;
+    uint64_t m_timestampGaps;
+    uint64_t m_missedFrames;
+    uint64_t m_droppedFrames;
+    uint64_t m_framesWithoutGray;
+
+    // Processing time since the last run
+    std::chrono::steady_clock::duration m_processingTimeSum;
+    std::chrono::steady_clock::duration m_processingTimeMax;
+    uint64_t m_processingTimeCount;
+    std::chrono::steady_clock::duration m_conversionTimeSum;
+    std::chrono::steady_clock::duration m_conversionTimeMax;
+    uint64_t m_conversionTimeCount;
+
+    // Frame counts at the last WINDOW_SIZE runs
+    std::chrono::steady_clock::time_point m_windowTimes[WINDOW_SIZE];
+    uint64_t m_windowCounts[WINDOW_SIZE];
+    size_t m_windowIdx;
+    size_t m_windowFill;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__STREAM_DIAGNOSTICS_HPP__
@@ -0,0 +1,77 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__TEMPORAL_FILTER_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__TEMPORAL_FILTER_HPP__
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Frame.hpp"
+#include "RowBandPool.hpp"
+
+namespace pmd_royale_ros_driver {
+
+/// Smooths the depth of each pixel over the last frames of a stream.
+///
+/// The depth and confidence planes of the last numFrames frames are kept in a ring. A pixel is replaced by the
+/// confidence weighted mean or the median of its history; samples which differ from the current depth by more
+/// than resetDistance are left out, so moving objects don't smear. Invalid pixels stay invalid and x and y are
+/// scaled along the ray of the pixel. The inner loops run over contiguous planes so the compiler vectorizes them.
+class TemporalFilter {
+  public:
+    enum class Mode { Off, Mean, Median };
+
+    struct Settings {
+        Mode mode;
+        uint32_t numFrames;
+        float resetDistance;
+    };
+
+    static constexpr uint32_t MAX_FRAMES = 16;
+
+    /// Parse "off", "mean" or "median", returns false for anything else
+    static bool parseMode(const std::string &name, Mode &mode);
+
+    TemporalFilter();
+
+    void configure(const Settings &settings);
+
+    /// Filter the frame in place and add it to the history
+    void apply(Frame &frame, RowBandPool &pool);
+
+  private:
+    void filterMean(Frame &frame, uint32_t begin, uint32_t end);
+    void filterMedian(Frame &frame, uint32_t begin, uint32_t end);
+
+    const float *depthPlane(uint32_t age) const;
+    const float *confidencePlane(uint32_t age) const;
+
+    std::mutex m_mutex;
+    Settings m_settings;
+
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_head;
+    uint32_t m_fill;
+    std::vector<float> m_depth;
+    std::vector<float> m_confidence;
+
+    // Per pixel scratch, the bands work on disjoint ranges of it
+    std::vector<float> m_sum;
+    std::vector<float> m_weightedSum;
+    std::vector<float> m_rank;
+    std::vector<float> m_values;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__TEMPORAL_FILTER_HPP__
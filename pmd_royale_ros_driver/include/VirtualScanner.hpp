@@ -0,0 +1,69 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_DRIVER__VIRTUAL_SCANNER_HPP__
+#define __PMD_ROYALE_ROS_DRIVER__VIRTUAL_SCANNER_HPP__
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <sensor_msgs/msg/laser_scan.hpp>
+
+#include "Frame.hpp"
+
+namespace pmd_royale_ros_driver {
+
+/// Turns the organized point cloud into a planar scan, like a laser scanner mounted at the camera.
+///
+/// Every column of the sensor is one ray of the scan. Its range is the smallest horizontal distance of the points
+/// of the column whose height above the camera lies within [minHeight, maxHeight]. The angle of each column and its
+/// bin in the equiangular scan are computed once from the intrinsics, so a frame takes a single pass over the rows
+/// in which the per column minimum is updated with vectorizable loops. The scan is given in a frame with x forward
+/// and z up at the optical center.
+class VirtualScanner {
+  public:
+    struct Settings {
+        float minHeight;
+        float maxHeight;
+        float rangeMin;
+        float rangeMax;
+    };
+
+    VirtualScanner();
+
+    void configure(const Settings &settings);
+
+    /// Focal length and principal point in x of the frames, in pixels
+    void setIntrinsics(double fx, double cx);
+
+    /// Fill ranges, angles and range limits of the scan, the header is left to the caller
+    void apply(const Frame &frame, sensor_msgs::msg::LaserScan &scan);
+
+  private:
+    void updateTables(uint32_t width, uint32_t xOffset);
+
+    std::mutex m_mutex;
+    Settings m_settings;
+    double m_fx;
+    double m_cx;
+
+    // Per column tables of the current width and offset into the sensor
+    uint32_t m_width;
+    uint32_t m_xOffset;
+    float m_angleMin;
+    float m_angleIncrement;
+    std::vector<uint32_t> m_columnBin;
+    std::vector<float> m_columnMin;
+    std::vector<float> m_columnRange;
+};
+
+} // namespace pmd_royale_ros_driver
+
+#endif // __PMD_ROYALE_ROS_DRIVER__VIRTUAL_SCANNER_HPP__
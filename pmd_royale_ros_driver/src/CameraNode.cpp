@@ -9,7 +9,12 @@
  \****************************************************************************/
 
 #include <CameraNode.hpp>
+#include <algorithm>
+#include <fstream>
 #include <limits.h>
+#include <limits>
+#include <regex>
+#include <royale/IReplay.hpp>
 #include <sstream>
 
 using namespace std;
@@ -17,21 +22,105 @@ using namespace royale;
 
 namespace pmd_royale_ros_driver {
 
+namespace {
+// Guards the camera enumeration, which nodes in the same process would otherwise run concurrently
+std::mutex cameraManagerMutex;
+
+// Frame rate implied by the usecase name, e.g. 30 for "Mode_9_30fps". Falls back to the device's frame rate.
+double nominalFps(ICameraDevice &cameraDevice) {
+    String useCase;
+    if (cameraDevice.getCurrentUseCase(useCase) == CameraStatus::SUCCESS) {
+        std::smatch match;
+        std::string name = useCase.toStdString();
+        if (std::regex_search(name, match, std::regex("(\\d+)fps", std::regex::icase))) {
+            return std::stod(match[1]);
+        }
+    }
+    uint16_t frameRate = 0;
+    cameraDevice.getFrameRate(frameRate);
+    return frameRate;
+}
+
+// Open a recording as camera, looped and paced by its timestamps like a live camera
+std::unique_ptr<ICameraDevice> openPlayback(CameraManager &manager, const std::string &file) {
+    auto cameraDevice = manager.createCamera(file);
+    auto replay = dynamic_cast<royale::IReplay *>(cameraDevice.get());
+    if (replay) {
+        replay->loop(true);
+        replay->useTimestamps(true);
+    }
+    return cameraDevice;
+}
+
+// Load an 8 bit binary PGM (P5) image, as written by most image tools
+bool loadPgm(const std::string &path, std::vector<uint8_t> &pixels, uint32_t &width, uint32_t &height) {
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    file >> magic;
+    if (!file || magic != "P5") {
+        return false;
+    }
+
+    // Width, height and maximum value, each possibly preceded by comments
+    uint32_t header[3];
+    for (auto &value : header) {
+        file >> std::ws;
+        while (file.peek() == '#') {
+            file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            file >> std::ws;
+        }
+        file >> value;
+    }
+    file.get();
+    if (!file || header[2] == 0 || header[2] > 255) {
+        return false;
+    }
+
+    width = header[0];
+    height = header[1];
+    pixels.resize(size_t(width) * height);
+    file.read(reinterpret_cast<char *>(pixels.data()), pixels.size());
+    return static_cast<size_t>(file.gcount()) == pixels.size();
+}
+
+// Registry entry of a topic, with its fully qualified name and type
+template <typename PublisherT>
+void addRegistryTopic(CameraRegistryEntry &entry, int streamIdx, const PublisherT &publisher) {
+    if (publisher) {
+        entry.topics.push_back({streamIdx, publisher->get_topic_name(),
+                                rosidl_generator_traits::name<typename PublisherT::element_type::ROSMessageType>()});
+    }
+}
+} // namespace
+
 CameraNode::CameraNode(const rclcpp::NodeOptions &options)
-    : Node("pmd_royale_ros_camera_node", options),
+    : LifecycleNode("pmd_royale_ros_camera_node", options),
       IExposureListener(),
-      m_parametersClient(this),
-      m_isPubCloud(false),
-      m_isPubDepth(false),
-      m_isPubGray(false),
+      m_isIntraProcess(options.use_intra_process_comms()),
+      m_isShmRingEnabled(false),
+      m_isWatchdogEnabled(true),
+      m_shmRingSlots(0),
+      m_stampSource(StampSource::Device),
+      m_cloudFields(Frame::CloudFields::Xyzc),
+      m_compressionPrecision(0.001f),
+      m_filterThreads(0),
+      m_temporalFilterSettings{TemporalFilter::Mode::Off, 4, 0.05f},
+      m_flyingPixelFilterSettings{false, 3, 0.03f, 10.f},
+      m_scannerSettings{-0.1f, 0.1f, 0.1f, 6.f},
+      m_reducerSettings{FrameReducer::Mode::Mean, 2},
+      m_statisticsSettings{1, 5.f},
       m_registeredPCListener(false),
       m_registeredIRListener(false),
+      m_isDeclared(false),
       m_cam_name(""),
       m_node_name(""),
       m_cam_access_code(""),
       m_startUseCase(""),
       m_currentUseCase(""),
-      m_recording_file("") {
+      m_recording_file(""),
+      m_playback_file(""),
+      m_watchdog("capture watchdog"),
+      m_diagnostics(this) {
 
     unsigned int major;
     unsigned int minor;
@@ -69,6 +158,7 @@ CameraNode::CameraNode(const rclcpp::NodeOptions &options)
     else{
         nodeName = this->get_name();
     }
+    m_node_name = nodeName;
 
     rcl_interfaces::msg::ParameterDescriptor startUseCaseParameterDescriptor;
     startUseCaseParameterDescriptor.name = "startUseCase";
@@ -90,51 +180,340 @@ CameraNode::CameraNode(const rclcpp::NodeOptions &options)
         m_recording_file = this->get_parameter("recording_file").as_string();
     }
 
-    CameraManager manager(accessCode.c_str());
-    Vector<String> cameraList(manager.getConnectedCameraList());
-    if (cameraList.empty()) {
-        RCLCPP_ERROR(this->get_logger(), "No suitable cameras found!");
+    rcl_interfaces::msg::ParameterDescriptor playbackFileParameterDescriptor;
+    playbackFileParameterDescriptor.name = "playback_file";
+    playbackFileParameterDescriptor.description = "Recording which is played back in a loop instead of opening a camera.";
+    playbackFileParameterDescriptor.read_only = true;
+    m_playback_file = this->declare_parameter("playback_file", "", playbackFileParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor shmRingParameterDescriptor;
+    shmRingParameterDescriptor.name = "shm_ring";
+    shmRingParameterDescriptor.description = "Export the point clouds through a POSIX shared memory ring per stream. "
+                                             "Cannot change value after node configuration.";
+    shmRingParameterDescriptor.read_only = true;
+    m_isShmRingEnabled = this->declare_parameter("shm_ring", false, shmRingParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor shmRingSlotsParameterDescriptor;
+    shmRingSlotsParameterDescriptor.name = "shm_ring_slots";
+    shmRingSlotsParameterDescriptor.description = "Number of frame slots in each shared memory ring.";
+    shmRingSlotsParameterDescriptor.read_only = true;
+    rcl_interfaces::msg::IntegerRange shmRingSlotsRange;
+    shmRingSlotsRange.from_value = 2;
+    shmRingSlotsRange.to_value = 64;
+    shmRingSlotsRange.step = 1;
+    shmRingSlotsParameterDescriptor.integer_range.push_back(shmRingSlotsRange);
+    m_shmRingSlots = this->declare_parameter("shm_ring_slots", 4, shmRingSlotsParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor stampSourceParameterDescriptor;
+    stampSourceParameterDescriptor.name = "stamp_source";
+    stampSourceParameterDescriptor.description = "Clock of the message stamps.";
+    stampSourceParameterDescriptor.additional_constraints = "One of device (raw device timestamp), arrival (node clock when "
+                                                            "the frame arrived) or synchronized (device timestamp mapped "
+                                                            "to the node clock)";
+    if (!setStampSource(this->declare_parameter("stamp_source", "device", stampSourceParameterDescriptor))) {
         return;
     }
 
-    // If serial is empty/not set, then pick the first camera that CameraManager probes
-    if (this->get_parameter("serial").as_string().empty()) {
-        this->set_parameter(rclcpp::Parameter("serial", cameraList[0].toStdString()));
+    rcl_interfaces::msg::ParameterDescriptor pointCloudFieldsParameterDescriptor;
+    pointCloudFieldsParameterDescriptor.name = "point_cloud_fields";
+    pointCloudFieldsParameterDescriptor.description = "Fields of the point clouds.";
+    pointCloudFieldsParameterDescriptor.additional_constraints = "One of xyz, xyzc (confidence), xyzi (intensity, the gray "
+                                                                 "value) or xyzic";
+    if (!setPointCloudFields(this->declare_parameter("point_cloud_fields", "xyzc", pointCloudFieldsParameterDescriptor))) {
+        return;
     }
-    m_serial = this->get_parameter("serial").as_string();
 
-    int numCamsConnected = cameraList.size(); 
-    RCLCPP_INFO(this->get_logger(), "%d cameras found!", numCamsConnected);
+    rcl_interfaces::msg::ParameterDescriptor filterThreadsParameterDescriptor;
+    filterThreadsParameterDescriptor.name = "filter_threads";
+    filterThreadsParameterDescriptor.description = "Additional threads per stream which filter row bands of the frames.";
+    filterThreadsParameterDescriptor.read_only = true;
+    rcl_interfaces::msg::IntegerRange filterThreadsRange;
+    filterThreadsRange.from_value = 0;
+    filterThreadsRange.to_value = 16;
+    filterThreadsRange.step = 1;
+    filterThreadsParameterDescriptor.integer_range.push_back(filterThreadsRange);
+    m_filterThreads = this->declare_parameter("filter_threads", 2, filterThreadsParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor temporalFilterParameterDescriptor;
+    temporalFilterParameterDescriptor.name = "temporal_filter";
+    temporalFilterParameterDescriptor.description = "Temporal depth filter.";
+    temporalFilterParameterDescriptor.additional_constraints = "One of off, mean (confidence weighted) or median";
+    if (!TemporalFilter::parseMode(this->declare_parameter("temporal_filter", "off", temporalFilterParameterDescriptor),
+                                   m_temporalFilterSettings.mode)) {
+        RCLCPP_ERROR(this->get_logger(), "Unknown temporal filter: %s", this->get_parameter("temporal_filter").as_string().c_str());
+        return;
+    }
 
-    m_cameraDevice = manager.createCamera(m_serial);
-    if (m_cameraDevice) {
-        RCLCPP_INFO(this->get_logger(), "Connected camera serial : %s", m_serial.c_str());
-    } else {
-        RCLCPP_ERROR(this->get_logger(), "Could not connect to camera with serial %s", m_serial.c_str());
+    rcl_interfaces::msg::ParameterDescriptor temporalFilterFramesParameterDescriptor;
+    temporalFilterFramesParameterDescriptor.name = "temporal_filter_frames";
+    temporalFilterFramesParameterDescriptor.description = "Number of frames the temporal filter works on, including the current one.";
+    rcl_interfaces::msg::IntegerRange temporalFilterFramesRange;
+    temporalFilterFramesRange.from_value = 2;
+    temporalFilterFramesRange.to_value = TemporalFilter::MAX_FRAMES;
+    temporalFilterFramesRange.step = 1;
+    temporalFilterFramesParameterDescriptor.integer_range.push_back(temporalFilterFramesRange);
+    m_temporalFilterSettings.numFrames = (uint32_t)this->declare_parameter("temporal_filter_frames", 4, temporalFilterFramesParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor temporalFilterResetParameterDescriptor;
+    temporalFilterResetParameterDescriptor.name = "temporal_filter_reset_distance";
+    temporalFilterResetParameterDescriptor.description = "Depth change in meters above which older samples of a pixel are "
+                                                         "ignored by the temporal filter, so moving objects don't smear.";
+    rcl_interfaces::msg::FloatingPointRange temporalFilterResetRange;
+    temporalFilterResetRange.from_value = 0.;
+    temporalFilterResetRange.to_value = 1.;
+    temporalFilterResetParameterDescriptor.floating_point_range.push_back(temporalFilterResetRange);
+    m_temporalFilterSettings.resetDistance = (float)this->declare_parameter("temporal_filter_reset_distance", 0.05,
+                                                                            temporalFilterResetParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor flyingPixelFilterParameterDescriptor;
+    flyingPixelFilterParameterDescriptor.name = "flying_pixel_filter";
+    flyingPixelFilterParameterDescriptor.description = "Remove the flying pixels at depth discontinuities.";
+    m_flyingPixelFilterSettings.enabled = this->declare_parameter("flying_pixel_filter", false, flyingPixelFilterParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor flyingPixelWindowParameterDescriptor;
+    flyingPixelWindowParameterDescriptor.name = "flying_pixel_window";
+    flyingPixelWindowParameterDescriptor.description = "Size of the neighborhood the flying pixel filter tests, 3 or 5.";
+    rcl_interfaces::msg::IntegerRange flyingPixelWindowRange;
+    flyingPixelWindowRange.from_value = 3;
+    flyingPixelWindowRange.to_value = 5;
+    flyingPixelWindowRange.step = 2;
+    flyingPixelWindowParameterDescriptor.integer_range.push_back(flyingPixelWindowRange);
+    m_flyingPixelFilterSettings.windowSize = (uint32_t)this->declare_parameter("flying_pixel_window", 3, flyingPixelWindowParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor flyingPixelDepthJumpParameterDescriptor;
+    flyingPixelDepthJumpParameterDescriptor.name = "flying_pixel_max_depth_jump";
+    flyingPixelDepthJumpParameterDescriptor.description = "Depth difference to a neighbor, relative to the depth of the pixel, "
+                                                          "above which the neighbor counts as suspicious.";
+    rcl_interfaces::msg::FloatingPointRange flyingPixelDepthJumpRange;
+    flyingPixelDepthJumpRange.from_value = 0.;
+    flyingPixelDepthJumpRange.to_value = 1.;
+    flyingPixelDepthJumpParameterDescriptor.floating_point_range.push_back(flyingPixelDepthJumpRange);
+    m_flyingPixelFilterSettings.maxDepthJump = (float)this->declare_parameter("flying_pixel_max_depth_jump", 0.03,
+                                                                              flyingPixelDepthJumpParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor flyingPixelAngleParameterDescriptor;
+    flyingPixelAngleParameterDescriptor.name = "flying_pixel_min_angle";
+    flyingPixelAngleParameterDescriptor.description = "Angle in degrees between the viewing ray and the line to a neighbor "
+                                                      "below which the neighbor counts as suspicious. 0 disables the test.";
+    rcl_interfaces::msg::FloatingPointRange flyingPixelAngleRange;
+    flyingPixelAngleRange.from_value = 0.;
+    flyingPixelAngleRange.to_value = 90.;
+    flyingPixelAngleParameterDescriptor.floating_point_range.push_back(flyingPixelAngleRange);
+    m_flyingPixelFilterSettings.minAngle = (float)this->declare_parameter("flying_pixel_min_angle", 10.,
+                                                                          flyingPixelAngleParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor scanFrameIdParameterDescriptor;
+    scanFrameIdParameterDescriptor.name = "scan_frame_id";
+    scanFrameIdParameterDescriptor.description = "Frame id of the scans, with x forward and z up at the optical center.";
+    scanFrameIdParameterDescriptor.read_only = true;
+    m_scanFrameId = this->declare_parameter("scan_frame_id", std::string(this->get_name()) + "_link", scanFrameIdParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor scanMinHeightParameterDescriptor;
+    scanMinHeightParameterDescriptor.name = "scan_min_height";
+    scanMinHeightParameterDescriptor.description = "Lower end of the height band of the scan, in meters above the optical center.";
+    rcl_interfaces::msg::FloatingPointRange scanMinHeightRange;
+    scanMinHeightRange.from_value = -10.;
+    scanMinHeightRange.to_value = 10.;
+    scanMinHeightParameterDescriptor.floating_point_range.push_back(scanMinHeightRange);
+    m_scannerSettings.minHeight = (float)this->declare_parameter("scan_min_height", -0.1, scanMinHeightParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor scanMaxHeightParameterDescriptor;
+    scanMaxHeightParameterDescriptor.name = "scan_max_height";
+    scanMaxHeightParameterDescriptor.description = "Upper end of the height band of the scan, in meters above the optical center.";
+    rcl_interfaces::msg::FloatingPointRange scanMaxHeightRange;
+    scanMaxHeightRange.from_value = -10.;
+    scanMaxHeightRange.to_value = 10.;
+    scanMaxHeightParameterDescriptor.floating_point_range.push_back(scanMaxHeightRange);
+    m_scannerSettings.maxHeight = (float)this->declare_parameter("scan_max_height", 0.1, scanMaxHeightParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor scanRangeMinParameterDescriptor;
+    scanRangeMinParameterDescriptor.name = "scan_range_min";
+    scanRangeMinParameterDescriptor.description = "Minimum range of the scan in meters, closer points are ignored.";
+    rcl_interfaces::msg::FloatingPointRange scanRangeMinRange;
+    scanRangeMinRange.from_value = 0.;
+    scanRangeMinRange.to_value = 100.;
+    scanRangeMinParameterDescriptor.floating_point_range.push_back(scanRangeMinRange);
+    m_scannerSettings.rangeMin = (float)this->declare_parameter("scan_range_min", 0.1, scanRangeMinParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor scanRangeMaxParameterDescriptor;
+    scanRangeMaxParameterDescriptor.name = "scan_range_max";
+    scanRangeMaxParameterDescriptor.description = "Maximum range of the scan in meters.";
+    rcl_interfaces::msg::FloatingPointRange scanRangeMaxRange;
+    scanRangeMaxRange.from_value = 0.;
+    scanRangeMaxRange.to_value = 100.;
+    scanRangeMaxParameterDescriptor.floating_point_range.push_back(scanRangeMaxRange);
+    m_scannerSettings.rangeMax = (float)this->declare_parameter("scan_range_max", 6.0, scanRangeMaxParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor reducedFactorParameterDescriptor;
+    reducedFactorParameterDescriptor.name = "reduced_factor";
+    reducedFactorParameterDescriptor.description = "Size of the pixel blocks which are combined for the reduced outputs, 2 or 4.";
+    rcl_interfaces::msg::IntegerRange reducedFactorRange;
+    reducedFactorRange.from_value = 2;
+    reducedFactorRange.to_value = FrameReducer::MAX_FACTOR;
+    reducedFactorRange.step = 2;
+    reducedFactorParameterDescriptor.integer_range.push_back(reducedFactorRange);
+    m_reducerSettings.factor = (uint32_t)this->declare_parameter("reduced_factor", 2, reducedFactorParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor reducedModeParameterDescriptor;
+    reducedModeParameterDescriptor.name = "reduced_mode";
+    reducedModeParameterDescriptor.description = "How the valid pixels of a block are combined for the reduced outputs.";
+    reducedModeParameterDescriptor.additional_constraints = "One of mean (binning), median or nearest (decimation)";
+    if (!FrameReducer::parseMode(this->declare_parameter("reduced_mode", "mean", reducedModeParameterDescriptor),
+                                 m_reducerSettings.mode)) {
+        RCLCPP_ERROR(this->get_logger(), "Unknown reduction: %s", this->get_parameter("reduced_mode").as_string().c_str());
         return;
     }
 
+    rcl_interfaces::msg::ParameterDescriptor statisticsDecimationParameterDescriptor;
+    statisticsDecimationParameterDescriptor.name = "depth_statistics_decimation";
+    statisticsDecimationParameterDescriptor.description = "The depth statistics are published for every n-th frame.";
+    rcl_interfaces::msg::IntegerRange statisticsDecimationRange;
+    statisticsDecimationRange.from_value = 1;
+    statisticsDecimationRange.to_value = 1000;
+    statisticsDecimationRange.step = 1;
+    statisticsDecimationParameterDescriptor.integer_range.push_back(statisticsDecimationRange);
+    m_statisticsSettings.decimation = (uint32_t)this->declare_parameter("depth_statistics_decimation", 1, statisticsDecimationParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor statisticsRangeParameterDescriptor;
+    statisticsRangeParameterDescriptor.name = "depth_statistics_range";
+    statisticsRangeParameterDescriptor.description = "Depth in meters covered by the histogram of the depth statistics.";
+    rcl_interfaces::msg::FloatingPointRange statisticsRangeRange;
+    statisticsRangeRange.from_value = 0.1;
+    statisticsRangeRange.to_value = 100.;
+    statisticsRangeParameterDescriptor.floating_point_range.push_back(statisticsRangeRange);
+    m_statisticsSettings.histogramRange = (float)this->declare_parameter("depth_statistics_range", 5.0, statisticsRangeParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor compressionPrecisionParameterDescriptor;
+    compressionPrecisionParameterDescriptor.name = "compressed_cloud_precision";
+    compressionPrecisionParameterDescriptor.description = "Quantization step in meters of the coordinates of the compressed clouds.";
+    rcl_interfaces::msg::FloatingPointRange compressionPrecisionRange;
+    compressionPrecisionRange.from_value = 0.0001;
+    compressionPrecisionRange.to_value = 0.1;
+    compressionPrecisionParameterDescriptor.floating_point_range.push_back(compressionPrecisionRange);
+    m_compressionPrecision = (float)this->declare_parameter("compressed_cloud_precision", 0.001, compressionPrecisionParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor throttledOutputsParameterDescriptor;
+    throttledOutputsParameterDescriptor.name = "throttled_outputs";
+    throttledOutputsParameterDescriptor.description = "Additional point cloud and depth image topics of every stream with their own rate.";
+    throttledOutputsParameterDescriptor.additional_constraints = "Each one as <point_cloud|depth_image>/<name>:<rate>hz or "
+                                                                 "<point_cloud|depth_image>/<name>:every_<n>, optionally followed by :reduced";
+    throttledOutputsParameterDescriptor.read_only = true;
+    for (auto &description : this->declare_parameter("throttled_outputs", std::vector<std::string>(), throttledOutputsParameterDescriptor)) {
+        OutputThrottle::Settings settings;
+        if (!OutputThrottle::parse(description, settings)) {
+            RCLCPP_ERROR(this->get_logger(), "Invalid throttled output: %s", description.c_str());
+        } else if (m_throttledOutputs.size() == MAX_THROTTLED_OUTPUTS) {
+            RCLCPP_ERROR(this->get_logger(), "Too many throttled outputs, ignoring %s", description.c_str());
+        } else {
+            m_throttledOutputs.push_back(settings);
+        }
+    }
+
+    rcl_interfaces::msg::ParameterDescriptor targetFrameParameterDescriptor;
+    targetFrameParameterDescriptor.name = "target_frame";
+    targetFrameParameterDescriptor.description = "Frame the point clouds are published in. Empty for the optical frame.";
+    targetFrameParameterDescriptor.additional_constraints = "The transform from the optical frame must be static";
+    targetFrameParameterDescriptor.read_only = true;
+    m_targetFrame = this->declare_parameter("target_frame", "", targetFrameParameterDescriptor);
+    if (!m_targetFrame.empty()) {
+        m_tfBuffer = std::make_shared<tf2_ros::Buffer>(this->get_clock());
+        m_tfListener = std::make_shared<tf2_ros::TransformListener>(*m_tfBuffer, this, true);
+    }
+
+    rcl_interfaces::msg::ParameterDescriptor watchdogParameterDescriptor;
+    watchdogParameterDescriptor.name = "watchdog";
+    watchdogParameterDescriptor.description = "Restart the capture, and if that doesn't help reopen the camera, "
+                                              "when a stream stops delivering frames.";
+    watchdogParameterDescriptor.read_only = true;
+    m_isWatchdogEnabled = this->declare_parameter("watchdog", true, watchdogParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor autostartParameterDescriptor;
+    autostartParameterDescriptor.name = "autostart";
+    autostartParameterDescriptor.description = "Configure and activate the node on its own once the camera is open. "
+                                               "Disable to manage the lifecycle externally, configuring then opens "
+                                               "the camera and blocks until it is open.";
+    autostartParameterDescriptor.read_only = true;
+    bool isAutostart = this->declare_parameter("autostart", true, autostartParameterDescriptor);
+
+    m_cam_access_code = accessCode;
+    m_isDeclared = true;
+
+    // Opening the camera takes a while, the container can load other components meanwhile
+    if (isAutostart) {
+        m_deviceOpened = std::async(std::launch::async, &CameraNode::openDevice, this);
+        m_autostartTimer = this->create_wall_timer(std::chrono::milliseconds(10), std::bind(&CameraNode::autostart, this));
+    }
+}
+
+bool CameraNode::openDevice() {
+    // Cameras are enumerated one node at a time, the initialization of the cameras runs in parallel
+    std::unique_lock<std::mutex> lock(cameraManagerMutex);
+    CameraManager manager(m_cam_access_code.c_str());
+
+    // A recording stands in for the camera, e.g. to run the driver on a machine without one
+    if (!m_playback_file.empty()) {
+        m_cameraDevice = openPlayback(manager, m_playback_file);
+        String cameraId;
+        if (!m_cameraDevice || m_cameraDevice->getId(cameraId) != CameraStatus::SUCCESS) {
+            RCLCPP_ERROR(this->get_logger(), "Could not open recording %s", m_playback_file.c_str());
+            return false;
+        }
+        m_serial = cameraId.toStdString();
+        RCLCPP_INFO(this->get_logger(), "Playing back %s, recorded with camera %s", m_playback_file.c_str(), m_serial.c_str());
+    } else {
+        Vector<String> cameraList(manager.getConnectedCameraList());
+        if (cameraList.empty()) {
+            RCLCPP_ERROR(this->get_logger(), "No suitable cameras found!");
+            return false;
+        }
+
+        // If serial is empty/not set, then pick the first camera that CameraManager probes
+        if (this->get_parameter("serial").as_string().empty()) {
+            this->set_parameter(rclcpp::Parameter("serial", cameraList[0].toStdString()));
+        }
+        m_serial = this->get_parameter("serial").as_string();
+
+        int numCamsConnected = cameraList.size(); 
+        RCLCPP_INFO(this->get_logger(), "%d cameras found!", numCamsConnected);
+
+        m_cameraDevice = manager.createCamera(m_serial);
+        if (m_cameraDevice) {
+            RCLCPP_INFO(this->get_logger(), "Connected camera serial : %s", m_serial.c_str());
+        } else {
+            RCLCPP_ERROR(this->get_logger(), "Could not connect to camera with serial %s", m_serial.c_str());
+            return false;
+        }
+    }
+    lock.unlock();
+
     if (m_cameraDevice->initialize(m_startUseCase) != CameraStatus::SUCCESS) {
         RCLCPP_ERROR(this->get_logger(), "Error initializing the camera!");
-        return;
+        return false;
     }
 
+    return true;
+}
+
+bool CameraNode::configureDevice() {
     royale::String cameraName;
     if (m_cameraDevice->getCameraName(cameraName) != royale::CameraStatus::SUCCESS) {
         RCLCPP_ERROR(this->get_logger(), "Could not get camera name for camera with serial %s", m_serial.c_str());
-        return;
+        return false;
     }
     rcl_interfaces::msg::ParameterDescriptor modelParameterDescriptor;
     modelParameterDescriptor.name = "model";
     modelParameterDescriptor.description = "Model for the camera.";
     modelParameterDescriptor.read_only = true;
-    m_model = this->declare_parameter("model", cameraName.toStdString(), modelParameterDescriptor, true);
+    // Read only parameters stay declared when the node is cleaned up and configured again
+    if (!this->has_parameter("model")) {
+        m_model = this->declare_parameter("model", cameraName.toStdString(), modelParameterDescriptor, true);
+    }
 
     // Get the list of available usecases(modes). Filter out multi-stream usecases until it can be properly supported.
     Vector<String> useCases;
     if (m_cameraDevice->getUseCases(useCases) != royale::CameraStatus::SUCCESS) {
         RCLCPP_ERROR(this->get_logger(), "Could not get available usecases");
-        return;
+        return false;
     }
 
     std::vector<std::string> stdUseCaseList;
@@ -146,118 +525,270 @@ CameraNode::CameraNode(const rclcpp::NodeOptions &options)
     availableUseCasesParameterDescriptor.name = "available_usecases";
     availableUseCasesParameterDescriptor.description = "Read only list of available usecases for this camera";
     availableUseCasesParameterDescriptor.read_only = true;
-    this->declare_parameter("available_usecases", stdUseCaseList, availableUseCasesParameterDescriptor, true);
+    if (!this->has_parameter("available_usecases")) {
+        this->declare_parameter("available_usecases", stdUseCaseList, availableUseCasesParameterDescriptor, true);
+    }
 
     rcl_interfaces::msg::ParameterDescriptor currentUseCaseParameterDescriptor;
     currentUseCaseParameterDescriptor.name = "usecase";
     currentUseCaseParameterDescriptor.description = "Current usecase";
-    this->declare_parameter("usecase", "", currentUseCaseParameterDescriptor);
+    if (!this->has_parameter("usecase")) {
+        this->declare_parameter("usecase", "", currentUseCaseParameterDescriptor);
+    }
 
     auto currentUseCaseParam = this->get_parameter("usecase");
     if (currentUseCaseParam.as_string().empty()) {
         String currentUseCase;
         if (m_cameraDevice->getCurrentUseCase(currentUseCase) != royale::CameraStatus::SUCCESS) {
             RCLCPP_ERROR(this->get_logger(), "Could not get current usecase");
-            return;
+            return false;
         }
         this->set_parameter(rclcpp::Parameter("usecase", currentUseCase.toStdString()));
     } else {
         if (m_cameraDevice->setUseCase(royale::String::fromStdString(currentUseCaseParam.as_string())) != royale::CameraStatus::SUCCESS) {
             RCLCPP_ERROR(this->get_logger(), "Could not set usecase %s", currentUseCaseParam.as_string().c_str());
-            return;
+            return false;
         }
     }
 
-    Vector<StreamId> streamIds;
-    if (m_cameraDevice->getStreams(streamIds) != CameraStatus::SUCCESS) {
-        RCLCPP_ERROR(this->get_logger(), "Couldn't retrieve streams!");
+    if (!setCameraInfo()) {
+        RCLCPP_ERROR(this->get_logger(), "Couldn't create camera info!");
+        return false;
+    }
+
+    if (m_cameraDevice->registerExposureListener(this) != CameraStatus::SUCCESS) {
+        RCLCPP_ERROR(this->get_logger(), "Couldn't register exposure listener!");
+        return false;
+    }
+
+    // Advertise our camera info topic, the stream topics are advertised with the streams of the usecase.
+    // These are plain publishers, the node only captures while it is active anyway and lifecycle publishers don't
+    // support the Frame type adapter.
+    m_pubCameraInfo = rclcpp::create_publisher<sensor_msgs::msg::CameraInfo>(
+        *this, m_node_name + "/camera_info", 10);
+    m_pubCameraInfoReduced = rclcpp::create_publisher<sensor_msgs::msg::CameraInfo>(
+        *this, m_node_name + "/camera_info/reduced", 10);
+
+    // All camera nodes share the registry topic, it keeps the latest entry of each of them for late joiners
+    m_pubRegistry = rclcpp::create_publisher<std_msgs::msg::String>(*this, CAMERA_REGISTRY_TOPIC, rclcpp::QoS(1).transient_local());
+
+    m_diagnostics.setHardwareID(m_serial);
+    m_diagnostics.add("camera", this, &CameraNode::updateCameraDiagnostics);
+
+    if (!initUseCase()) {
+        return false;
+    }
+
+    m_updateDataListenersTimer = this->create_wall_timer(std::chrono::milliseconds(250),
+                                                         std::bind(&CameraNode::updateDataListeners, this));
+
+    if (m_isWatchdogEnabled) {
+        m_diagnostics.add(m_watchdog);
+        m_watchdogTimer = this->create_wall_timer(std::chrono::milliseconds(250), std::bind(&CameraNode::checkCapture, this));
+    }
+
+    m_onSetParametersCbHandle = this->add_on_set_parameters_callback(std::bind(&CameraNode::onSetParameters, this, std::placeholders::_1));
+
+    return true;
+}
+
+CameraNode::CallbackReturn CameraNode::on_configure(const rclcpp_lifecycle::State &) {
+    if (!m_isDeclared) {
+        RCLCPP_ERROR(this->get_logger(), "Can't configure the node with invalid parameters!");
+        return CallbackReturn::FAILURE;
+    }
+
+    // With autostart the camera is already being opened, otherwise it is opened now and the transition blocks until
+    // it is open
+    bool isOpen = m_deviceOpened.valid() ? m_deviceOpened.get() : openDevice();
+    if (!isOpen || !configureDevice()) {
+        releaseDevice();
+        return CallbackReturn::FAILURE;
+    }
+    return CallbackReturn::SUCCESS;
+}
+
+CameraNode::CallbackReturn CameraNode::on_activate(const rclcpp_lifecycle::State &) {
+    return start() ? CallbackReturn::SUCCESS : CallbackReturn::FAILURE;
+}
+
+CameraNode::CallbackReturn CameraNode::on_deactivate(const rclcpp_lifecycle::State &) {
+    stop();
+    return CallbackReturn::SUCCESS;
+}
+
+CameraNode::CallbackReturn CameraNode::on_cleanup(const rclcpp_lifecycle::State &) {
+    releaseDevice();
+    return CallbackReturn::SUCCESS;
+}
+
+CameraNode::CallbackReturn CameraNode::on_shutdown(const rclcpp_lifecycle::State &) {
+    releaseDevice();
+    return CallbackReturn::SUCCESS;
+}
+
+void CameraNode::autostart() {
+    if (m_deviceOpened.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
         return;
     }
-    for (auto i = 0u; i < streamIds.size(); ++i) {
-        m_streamIdx[streamIds[i]] = i;
+    m_autostartTimer->cancel();
+
+    if (this->configure().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE) {
+        RCLCPP_ERROR(this->get_logger(), "Autostart failed to configure the node!");
+        return;
     }
+    this->activate();
+}
 
-    for (auto i = 0u; i < ROYALE_ROS_MAX_STREAMS; ++i) {
-        rcl_interfaces::msg::ParameterDescriptor enableAEParamDescriptor;
-        enableAEParamDescriptor.name = "auto_exposure_" + std::to_string(i);
-        enableAEParamDescriptor.description = "Controls auto exposure for stream " + std::to_string(i);
-        enableAEParamDescriptor.additional_constraints = "Cannot set the exposure_time parameter while this paramter's value is True";
-        m_isAutoExposureEnabled[i] = this->declare_parameter("auto_exposure_" + std::to_string(i), true, enableAEParamDescriptor);
-        royale::ExposureMode expoMode = m_isAutoExposureEnabled[i] ? royale::ExposureMode::AUTOMATIC : royale::ExposureMode::MANUAL;
-        if (i < streamIds.size() && m_cameraDevice->setExposureMode(expoMode, streamIds[i]) != royale::CameraStatus::SUCCESS) {
-            RCLCPP_ERROR(this->get_logger(), "Could not configure exposure mode for stream %d", i);
-            return;
-        }
+void CameraNode::releaseDevice() {
+    stop();
+    m_onSetParametersCbHandle.reset();
+    m_updateDataListenersTimer.reset();
+    m_reinitUseCaseTimer.reset();
+    m_watchdogTimer.reset();
+    m_watchdog.setActive(false);
 
-        // If user provided exposure_time and no auto_exposure,
-        royale::Pair<uint32_t, uint32_t> exposureLimits;
-        m_cameraDevice->getExposureLimits(exposureLimits, streamIds[i]);
-        rcl_interfaces::msg::ParameterDescriptor exposureParamDescriptor;
-        exposureParamDescriptor.name = "exposure_time_" + std::to_string(i);
-        exposureParamDescriptor.description = "Current exposure time for stream %d", i;
-        exposureParamDescriptor.additional_constraints = "Cannot be set if auto_exposure is True. "
-                                                         "Must be within the integer range for the current usecase.";
-        rcl_interfaces::msg::IntegerRange exposureTimeRange;
-        exposureTimeRange.from_value = exposureLimits.first;
-        exposureTimeRange.to_value = exposureLimits.second;
-        exposureTimeRange.step = 1;
-        exposureParamDescriptor.integer_range.push_back(exposureTimeRange);
-        exposureParamDescriptor.dynamic_typing = true; // Set dynamic_typing to true only so this can be re-declared later
-        m_exposureTime[i] = this->declare_parameter(exposureParamDescriptor.name, (int)exposureLimits.second, exposureParamDescriptor, m_isAutoExposureEnabled[i]);
-        if (i < streamIds.size() && !m_isAutoExposureEnabled[i]) {
-            if (m_cameraDevice->setExposureTime((uint32_t)m_exposureTime[i], streamIds[i]) != royale::CameraStatus::SUCCESS) {
-                RCLCPP_ERROR(this->get_logger(), "Could not set exposure time of %d for stream %d", (int)m_exposureTime[i], i);
-                return;
-            }
+    if (m_cameraDevice) {
+        if (m_registeredPCListener) {
+            m_cameraDevice->unregisterPointCloudListener();
+        }
+        if (m_registeredIRListener) {
+            m_cameraDevice->unregisterIRImageListener();
         }
+        m_cameraDevice->unregisterExposureListener();
     }
+    m_registeredPCListener = false;
+    m_registeredIRListener = false;
 
-    if (!setCameraInfo()) {
-        RCLCPP_ERROR(this->get_logger(), "Couldn't create camera info!");
-        return;
+    while (!m_streams.empty()) {
+        destroyStream(static_cast<uint32_t>(m_streams.size() - 1));
     }
+    m_streamIdx.clear();
+    m_diagnostics.removeByName("camera");
+    m_diagnostics.removeByName(m_watchdog.getName());
 
-    if (m_cameraDevice->registerExposureListener(this) != CameraStatus::SUCCESS) {
-        RCLCPP_ERROR(this->get_logger(), "Couldn't register exposure listener!");
+    m_pubCameraInfo.reset();
+    m_pubCameraInfoReduced.reset();
+    m_pubRegistry.reset();
+    m_cameraDevice.reset();
+}
+
+void CameraNode::checkCapture() {
+    // Without a data listener Royale doesn't deliver frames, so there is nothing to watch
+    bool isActive = this->get_current_state().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE;
+    m_watchdog.setActive(isActive && (m_registeredPCListener || m_registeredIRListener));
+
+    switch (m_watchdog.check()) {
+    case CaptureWatchdog::Action::None:
         return;
+    case CaptureWatchdog::Action::RestartCapture:
+        RCLCPP_WARN(this->get_logger(), "Camera %s stalled, restarting the capture", m_serial.c_str());
+        if (m_cameraDevice) {
+            m_cameraDevice->stopCapture();
+            if (m_cameraDevice->startCapture() != CameraStatus::SUCCESS) {
+                RCLCPP_ERROR(this->get_logger(), "Error restarting camera capture!");
+            }
+        }
+        break;
+    case CaptureWatchdog::Action::ReopenDevice:
+        RCLCPP_WARN(this->get_logger(), "Camera %s stalled, reopening it", m_serial.c_str());
+        if (reopenDevice()) {
+            RCLCPP_INFO(this->get_logger(), "Reopened camera %s", m_serial.c_str());
+        }
+        break;
     }
 
-    m_updateDataListenersTimer = this->create_wall_timer(std::chrono::milliseconds(250),
-                                                         std::bind(&CameraNode::updateDataListeners, this));
-    m_updateDataListenersTimer->call();
+    // Reopening takes a while, which mustn't count into the timeout of the next action
+    m_watchdog.restartTimeout();
+}
 
-    // Advertise our point cloud topic and image topics
-    m_pubCameraInfo = this->create_publisher<sensor_msgs::msg::CameraInfo>(
-        nodeName + "/camera_info", 10);
-    for (auto i = 0u; i < ROYALE_ROS_MAX_STREAMS; ++i) {
-        m_pubCloud[i] = this->create_publisher<sensor_msgs::msg::PointCloud2>(
-            nodeName + "/point_cloud_" + std::to_string(i), 10);
-        m_pubDepth[i] = this->create_publisher<sensor_msgs::msg::Image>(nodeName + "/depth_image_" + std::to_string(i),
-                                                                        10);
-        m_pubGray[i] = this->create_publisher<sensor_msgs::msg::Image>(nodeName + "/gray_image_" + std::to_string(i),
-                                                                       10);
+bool CameraNode::reopenDevice() {
+    if (m_cameraDevice) {
+        m_cameraDevice->stopCapture();
+        if (m_registeredPCListener) {
+            m_cameraDevice->unregisterPointCloudListener();
+        }
+        if (m_registeredIRListener) {
+            m_cameraDevice->unregisterIRImageListener();
+        }
+        m_cameraDevice->unregisterExposureListener();
+        m_cameraDevice.reset();
+    }
 
-        std::function<void(const std_msgs::msg::String::SharedPtr msg)> fcn = std::bind(&CameraNode::setProcParams, this, std::placeholders::_1, i);
-        m_procParamsSubscription[i] = this->create_subscription<std_msgs::msg::String>(
-            nodeName + "/proc_params_" + std::to_string(i), 10, fcn);
+    // After a hot plug the camera is only found again once it was enumerated, it is identified by its serial
+    {
+        std::lock_guard<std::mutex> lock(cameraManagerMutex);
+        CameraManager manager(m_cam_access_code.c_str());
+        if (!m_playback_file.empty()) {
+            m_cameraDevice = openPlayback(manager, m_playback_file);
+        } else {
+            Vector<String> cameraList(manager.getConnectedCameraList());
+            if (std::find(cameraList.begin(), cameraList.end(), String::fromStdString(m_serial)) == cameraList.end()) {
+                RCLCPP_WARN(this->get_logger(), "Camera %s is not connected", m_serial.c_str());
+                return false;
+            }
+            m_cameraDevice = manager.createCamera(m_serial);
+        }
+    }
+    auto useCase = this->get_parameter("usecase").as_string();
+    if (!m_cameraDevice || m_cameraDevice->initialize(String::fromStdString(useCase)) != CameraStatus::SUCCESS) {
+        RCLCPP_ERROR(this->get_logger(), "Could not reopen camera %s", m_serial.c_str());
+        m_cameraDevice.reset();
+        return false;
     }
 
-    m_onSetParametersCbHandle = this->add_on_set_parameters_callback(std::bind(&CameraNode::onSetParameters, this, std::placeholders::_1));
-    m_onSetParametersEventCbHandle = m_parametersClient.on_parameter_event(std::bind(&CameraNode::onParametersSetEvent, this, std::placeholders::_1));
+    // Same usecase, same streams. The exposure is restored from the parameters.
+    Vector<StreamId> streamIds;
+    if (m_cameraDevice->getStreams(streamIds) != CameraStatus::SUCCESS || streamIds.size() != m_streams.size()) {
+        RCLCPP_ERROR(this->get_logger(), "Streams of the reopened camera don't match the usecase!");
+        return false;
+    }
+    m_streamIdx.clear();
+    for (auto i = 0u; i < streamIds.size(); ++i) {
+        auto &stream = *m_streams[i];
+        stream.id = streamIds[i];
+        m_streamIdx[stream.id] = i;
+        m_cameraDevice->setExposureMode(stream.isAutoExposureEnabled ? ExposureMode::AUTOMATIC : ExposureMode::MANUAL, stream.id);
+        if (!stream.isAutoExposureEnabled) {
+            m_cameraDevice->setExposureTime((uint32_t)stream.exposureTime, stream.id);
+        }
+    }
 
-    initUseCase();
+    if (m_cameraDevice->registerExposureListener(this) != CameraStatus::SUCCESS) {
+        RCLCPP_ERROR(this->get_logger(), "Couldn't register exposure listener!");
+    }
+    if (m_registeredPCListener && m_cameraDevice->registerPointCloudListener(this) != CameraStatus::SUCCESS) {
+        RCLCPP_ERROR(this->get_logger(), "Couldn't register pointcloud data listener!");
+        m_registeredPCListener = false;
+    }
+    if (m_registeredIRListener && m_cameraDevice->registerIRImageListener(this) != CameraStatus::SUCCESS) {
+        RCLCPP_ERROR(this->get_logger(), "Couldn't register IR data listener!");
+        m_registeredIRListener = false;
+    }
 
-    start();
+    // The device clock may have been reset with the camera
+    m_clockSync.reset();
+    if (m_cameraDevice->startCapture() != CameraStatus::SUCCESS) {
+        RCLCPP_ERROR(this->get_logger(), "Error starting camera capture!");
+        return false;
+    }
+    return true;
 }
 
 CameraNode::~CameraNode() {
+    if (m_deviceOpened.valid()) {
+        m_deviceOpened.wait();
+    }
     stop();
 }
 
-void CameraNode::start() {
+bool CameraNode::start() {
+    if (!m_cameraDevice) {
+        return false;
+    }
     if (m_cameraDevice->startCapture() != CameraStatus::SUCCESS) {
         RCLCPP_ERROR(this->get_logger(), "Error starting camera capture!");
-        return;
+        return false;
     }
 
     // If we specified a file start the recording
@@ -267,122 +798,254 @@ void CameraNode::start() {
         RCLCPP_INFO(this->get_logger(), "Recording to : %s", resolvedPath);
         m_cameraDevice->startRecording(m_recording_file);
     }
+    return true;
 }
 
 void CameraNode::stop() {
-    // Close the camera
-    if (m_cameraDevice && m_cameraDevice->stopCapture() != CameraStatus::SUCCESS) {
+    // Close the camera, the node stops the capture on deactivate and again on cleanup
+    bool isCapturing = false;
+    if (!m_cameraDevice || m_cameraDevice->isCapturing(isCapturing) != CameraStatus::SUCCESS || !isCapturing) {
+        return;
+    }
+    if (m_cameraDevice->stopCapture() != CameraStatus::SUCCESS) {
         RCLCPP_ERROR(this->get_logger(), "Error stopping camera capture!");
         return;
     }
 }
 
 void CameraNode::onNewData(const royale::PointCloud *data) {
-    auto curIdx = m_streamIdx[data->streamId];
+    auto callbackStart = chrono::steady_clock::now();
+    auto arrival = this->now();
+    auto streamIt = m_streamIdx.find(data->streamId);
+    if (streamIt == m_streamIdx.end()) {
+        return;
+    }
+    auto &stream = *m_streams[streamIt->second];
+    m_watchdog.onFrame(streamIt->second);
+    auto stamp = frameStamp(data->timestamp, arrival, true);
+
+    // The throttled outputs decide here, so the frames they skip aren't even copied for them
+    uint32_t throttledOutputs = 0;
+    for (auto i = 0u; i < stream.throttledOutputs.size(); ++i) {
+        auto &output = *stream.throttledOutputs[i];
+        if (output.isPub && output.throttle.nextFrame(stamp.nanoseconds())) {
+            throttledOutputs |= 1u << i;
+        }
+    }
 
-    std_msgs::msg::Header header;
-    header.frame_id = string(this->get_name()) + "_optical_frame";
-    header.stamp = rclcpp::Time(
-        (chrono::duration_cast<chrono::nanoseconds>(chrono::microseconds(data->timestamp))).count());
+    if (stream.isPubCloud || stream.isPubDepth || stream.isPubShm || stream.isPubScan || stream.isPubCloudReduced ||
+        stream.isPubDepthReduced || stream.isPubStatistics || stream.isPubCompressed || throttledOutputs) {
+        auto roi = clampRoi(stream.roi, data->width, data->height);
+        auto frame = stream.framePool->acquire();
+        frame->resize(roi.width, roi.height);
+        frame->setRegion(roi.x_offset, roi.y_offset, data->width, data->height);
+        frame->header.frame_id = stream.frameId;
+        frame->header.stamp = stamp;
+        frame->setCloudFields(m_cloudFields);
+        copyRoi(data->xyzcPoints, data->width, roi, roiMask(stream, data->width, data->height), frame->xyzc());
+
+        // A cloud with intensity waits for the gray image of its capture if the IR callback comes second. The IR
+        // callback only passes the gray image on for the outputs with a cloud.
+        bool needsGray = frame->hasIntensityField() && m_registeredIRListener &&
+                         (stream.isPubCloud || stream.isPubCloudReduced || stream.isPubShm || stream.isPubThrottledCloud);
+        postFrames(stream, stream.grayPairing.addFrame(std::move(frame), static_cast<uint64_t>(data->timestamp),
+                                                       throttledOutputs, needsGray));
+    }
 
-    auto numPoints = data->getNumPoints();
-    if (m_isPubCloud) {
-        sensor_msgs::msg::PointCloud2::UniquePtr msgPointCloud(new sensor_msgs::msg::PointCloud2);
-        msgPointCloud->header = header;
-        msgPointCloud->width = data->height;
-        msgPointCloud->height = data->width;
-        msgPointCloud->is_bigendian = false;
-        msgPointCloud->is_dense = false;
-        msgPointCloud->point_step = static_cast<uint32_t>(4 * sizeof(float));
-        msgPointCloud->row_step = static_cast<uint32_t>(4 * sizeof(float) * data->width);
-        msgPointCloud->data.resize(4 * sizeof(float) * numPoints);
+    stream.diagnostics->onFrame(data->timestamp, chrono::steady_clock::now() - callbackStart);
+}
 
-        sensor_msgs::PointCloud2Modifier modifier(*msgPointCloud);
-        modifier.setPointCloud2Fields(4, "x", 1, sensor_msgs::msg::PointField::FLOAT32,
-                                      "y", 1, sensor_msgs::msg::PointField::FLOAT32,
-                                      "z", 1, sensor_msgs::msg::PointField::FLOAT32,
-                                      "conf", 1, sensor_msgs::msg::PointField::FLOAT32);
+void CameraNode::postFrames(Stream &stream, GrayPairing::Result frames) {
+    if (frames.withoutGray.frame) {
+        stream.diagnostics->onFrameWithoutGray();
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                             "No gray image came for a cloud with intensity, its intensity is 0");
+    }
 
-        float *cloudPtr = reinterpret_cast<float *>(&msgPointCloud->data[0]);
-        ::memcpy(cloudPtr, data->xyzcPoints, 4 * sizeof(float) * numPoints);
+    // The data pointer is only valid during the callback, everything else happens on the stream's worker
+    for (auto *handoff : {&frames.withoutGray, &frames.complete}) {
+        if (!handoff->frame) {
+            continue;
+        }
+        auto dropped = stream.worker->post(std::move(handoff->frame), handoff->throttledOutputs);
+        if (dropped) {
+            stream.framePool->release(std::move(dropped));
+            stream.diagnostics->onFrameDropped();
+        }
+    }
+}
+
+void CameraNode::processFrame(Stream &stream, std::unique_ptr<Frame> frame, uint32_t throttledOutputs) {
+    auto conversionStart = chrono::steady_clock::now();
+
+    stream.temporalFilter.apply(*frame, *stream.rowBands);
+    stream.flyingPixelFilter.apply(*frame, *stream.rowBands);
 
-        m_pubCloud[curIdx]->publish(std::move(msgPointCloud));
+    // The statistics are computed while the depth image is filled, or on their own if nobody takes the image
+    bool isStatisticsDue = stream.isPubStatistics && stream.statistics.nextFrame();
+    if (stream.isPubDepth) {
+        publishMessage(*stream.pubDepth, stream.msgDepth, m_isIntraProcess, [&](sensor_msgs::msg::Image &msg) {
+            fillDepthImage(*frame, msg, isStatisticsDue ? &stream.statistics : nullptr);
+        });
+    } else if (isStatisticsDue) {
+        stream.statistics.apply(*frame, nullptr);
     }
+    if (isStatisticsDue) {
+        publishMessage(*stream.pubStatistics, stream.msgStatistics, m_isIntraProcess,
+                       [&](std_msgs::msg::Float32MultiArray &msg) { stream.statistics.fill(msg); });
+    }
+    publishThrottled(stream, *frame, throttledOutputs & stream.throttledDepthMask & ~stream.throttledReducedMask);
+
+    publishMessage(*m_pubCameraInfo, stream.msgCameraInfo, m_isIntraProcess,
+                   [&](sensor_msgs::msg::CameraInfo &msg) { fillCameraInfo(*frame, msg); });
 
-    if (m_isPubDepth) {
-        // Create Depth Image message
-        sensor_msgs::msg::Image::UniquePtr msgDepthImage(new sensor_msgs::msg::Image);
+    uint32_t throttledReduced = throttledOutputs & stream.throttledReducedMask;
+    if (stream.isPubCloudReduced || stream.isPubDepthReduced || throttledReduced) {
+        auto reduced = stream.framePool->acquire();
+        // The camera info is scaled by the factor the frame was reduced by, reduced_factor may change in between
+        auto factor = stream.reducer.apply(*frame, *reduced, *stream.rowBands);
 
-        msgDepthImage->header = header;
-        msgDepthImage->width = data->width;
-        msgDepthImage->height = data->height;
-        msgDepthImage->is_bigendian = false;
-        msgDepthImage->encoding = sensor_msgs::image_encodings::TYPE_32FC1;
-        msgDepthImage->step = static_cast<uint32_t>(sizeof(float) * data->width);
-        msgDepthImage->data.resize(sizeof(float) * numPoints);
+        if (stream.isPubDepthReduced) {
+            publishMessage(*stream.pubDepthReduced, stream.msgDepthReduced, m_isIntraProcess,
+                           [&](sensor_msgs::msg::Image &msg) { fillDepthImage(*reduced, msg); });
+        }
+        publishThrottled(stream, *reduced, throttledReduced & stream.throttledDepthMask);
 
-        float *iterDepth = (float *)&msgDepthImage->data[0];
+        publishMessage(*m_pubCameraInfoReduced, stream.msgCameraInfoReduced, m_isIntraProcess,
+                       [&](sensor_msgs::msg::CameraInfo &msg) {
+                           fillCameraInfo(*frame, msg);
+                           FrameReducer::reduceCameraInfo(factor, msg);
+                       });
 
-        // Iterate over all the points we received in the callback
-        for (auto i = 0u; i < numPoints; ++i) {
-            *iterDepth++ = data->xyzcPoints[i * 4 + 2];
+        if (stream.isPubCloudReduced || (throttledReduced & ~stream.throttledDepthMask)) {
+            transformToTarget(stream, *reduced);
+            publishThrottled(stream, *reduced, throttledReduced & ~stream.throttledDepthMask);
         }
-        m_pubDepth[curIdx]->publish(std::move(msgDepthImage));
+        if (stream.isPubCloudReduced) {
+            publishFrame(*stream.pubCloudReduced, stream.msgCloudReduced, m_isIntraProcess, reduced);
+        }
+        stream.framePool->release(std::move(reduced));
     }
 
-    // Publish with CameraInfo
-    sensor_msgs::msg::CameraInfo::UniquePtr msgCameraInfo(new sensor_msgs::msg::CameraInfo);
-    *msgCameraInfo = m_cameraInfo;
-    msgCameraInfo->header = header;
-    msgCameraInfo->height = data->height;
-    msgCameraInfo->width = data->width;
-    m_pubCameraInfo->publish(std::move(msgCameraInfo));
-}
+    if (stream.isPubScan) {
+        publishMessage(*stream.pubScan, stream.msgScan, m_isIntraProcess, [&](sensor_msgs::msg::LaserScan &msg) {
+            msg.header.stamp = frame->header.stamp;
+            msg.header.frame_id = m_scanFrameId;
+            msg.scan_time = stream.scanTime;
+            stream.scanner.apply(*frame, msg);
+        });
+    }
 
-void CameraNode::onNewData(const royale::IRImage *data) {
-    auto curIdx = m_streamIdx[data->streamId];
+    if (stream.isPubShm && stream.shmRing) {
+        std_msgs::msg::UInt64 msgShmNotify;
+        msgShmNotify.data = stream.shmRing->write(*frame);
+        if (msgShmNotify.data) {
+            stream.pubShmNotify->publish(msgShmNotify);
+        }
+    }
 
-    std_msgs::msg::Header header;
-    header.frame_id = string(this->get_name()) + "_optical_frame";
-    header.stamp = rclcpp::Time(
-        (chrono::duration_cast<chrono::nanoseconds>(chrono::microseconds(data->timestamp))).count());
+    // The compressed and the throttled clouds carry the same points as the full one
+    uint32_t throttledClouds = throttledOutputs & ~stream.throttledDepthMask & ~stream.throttledReducedMask;
+    if (stream.isPubCloud || stream.isPubCompressed || throttledClouds) {
+        transformToTarget(stream, *frame);
+    }
+    publishThrottled(stream, *frame, throttledClouds);
+    if (stream.isPubCompressed) {
+        publishMessage(*stream.pubCompressed, stream.msgCompressed, m_isIntraProcess,
+                       [&](sensor_msgs::msg::CompressedImage &msg) {
+                           msg.header = frame->header;
+                           msg.format = CLOUD_CODEC_FORMAT;
+                           stream.codec.encode(frame->xyzc(), frame->width(), frame->height(), m_compressionPrecision,
+                                               msg.data);
+                       });
+    }
+    if (stream.isPubCloud) {
+        publishFrame(*stream.pubCloud, stream.msgCloud, m_isIntraProcess, frame);
+    }
+    // Null if it went to intra-process subscribers, its planes then come back through the recycler of the pool
+    stream.framePool->release(std::move(frame));
 
-    auto numPoints = data->getNumPoints();
+    stream.diagnostics->onFrameConverted(chrono::steady_clock::now() - conversionStart);
+}
 
-    // Create Depth Image message
-    sensor_msgs::msg::Image::UniquePtr msgGrayImage(new sensor_msgs::msg::Image);
+void CameraNode::publishThrottled(Stream &stream, const Frame &frame, uint32_t outputs) {
+    for (auto i = 0u; i < stream.throttledOutputs.size(); ++i) {
+        if (!(outputs & (1u << i))) {
+            continue;
+        }
+        auto &output = *stream.throttledOutputs[i];
+        if (output.pubDepth) {
+            publishMessage(*output.pubDepth, output.msgDepth, m_isIntraProcess,
+                           [&](sensor_msgs::msg::Image &msg) { fillDepthImage(frame, msg); });
+        } else if (m_isIntraProcess) {
+            output.pubCloud->publish(frame);
+        } else {
+            FrameAdapter::convert_to_ros_message(frame, output.msgCloud);
+            output.pubCloud->publish(output.msgCloud);
+        }
+    }
+}
+
+void CameraNode::onNewData(const royale::IRImage *data) {
+    auto callbackStart = chrono::steady_clock::now();
+    auto arrival = this->now();
+    auto streamIt = m_streamIdx.find(data->streamId);
+    if (streamIt == m_streamIdx.end()) {
+        return;
+    }
+    auto &stream = *m_streams[streamIt->second];
+    m_watchdog.onFrame(streamIt->second);
+    auto stamp = frameStamp(data->timestamp, arrival, !m_registeredPCListener);
 
-    msgGrayImage->header = header;
-    msgGrayImage->width = data->width;
-    msgGrayImage->height = data->height;
-    msgGrayImage->is_bigendian = false;
-    msgGrayImage->encoding = sensor_msgs::image_encodings::MONO8;
-    msgGrayImage->step = static_cast<uint32_t>(data->width);
-    msgGrayImage->data.resize(numPoints);
+    auto roi = clampRoi(stream.roi, data->width, data->height);
+    auto numPoints = roi.width * roi.height;
 
-    ::memcpy(&msgGrayImage->data[0], data->data, numPoints);
+    if (stream.isPubCloud || stream.isPubCloudReduced || stream.isPubShm || stream.isPubThrottledCloud) {
+        postFrames(stream,
+                   stream.grayPairing.addGray(data->data.data(), data->width, roi, static_cast<uint64_t>(data->timestamp)));
+    }
 
-    m_pubGray[curIdx]->publish(std::move(msgGrayImage));
+    if (stream.isPubGray) {
+        // Create Gray Image message
+        publishMessage(*stream.pubGray, stream.msgGray, m_isIntraProcess, [&](sensor_msgs::msg::Image &msgGrayImage) {
+            msgGrayImage.header.frame_id = stream.frameId;
+            msgGrayImage.header.stamp = stamp;
+            msgGrayImage.width = roi.width;
+            msgGrayImage.height = roi.height;
+            msgGrayImage.is_bigendian = false;
+            msgGrayImage.encoding = sensor_msgs::image_encodings::MONO8;
+            msgGrayImage.step = static_cast<uint32_t>(roi.width);
+            msgGrayImage.data.resize(numPoints);
+            copyGrayRoi(data->data.data(), data->width, roi, msgGrayImage.data.data());
+        });
+
+        publishMessage(*m_pubCameraInfo, stream.msgCameraInfoGray, m_isIntraProcess,
+                       [&](sensor_msgs::msg::CameraInfo &msg) {
+                           fillCameraInfo(stream.frameId, stamp, roi, data->width, data->height, msg);
+                       });
+    }
 
-    // Publish with CameraInfo
-    sensor_msgs::msg::CameraInfo::UniquePtr msgCameraInfo(new sensor_msgs::msg::CameraInfo);
-    *msgCameraInfo = m_cameraInfo;
-    msgCameraInfo->header = header;
-    msgCameraInfo->height = data->height;
-    msgCameraInfo->width = data->width;
-    m_pubCameraInfo->publish(std::move(msgCameraInfo));
+    // Frames are counted in the point cloud callback if that one is registered as well
+    if (!m_registeredPCListener) {
+        stream.diagnostics->onFrame(data->timestamp, chrono::steady_clock::now() - callbackStart);
+    }
 }
 
 void CameraNode::onNewExposure(const uint32_t exposureTime, const royale::StreamId streamId) {
-    auto curIdx = m_streamIdx[streamId];
-    if (m_exposureTime[curIdx] == exposureTime) {
+    auto streamIt = m_streamIdx.find(streamId);
+    if (streamIt == m_streamIdx.end()) {
+        return;
+    }
+    auto curIdx = streamIt->second;
+    auto &stream = *m_streams[curIdx];
+    if (stream.exposureTime == exposureTime) {
         return;
     }
 
-    m_exposureTime[curIdx] = exposureTime;
+    stream.exposureTime = exposureTime;
 
     try {
-        this->set_parameter(rclcpp::Parameter("exposure_time_" + std::to_string(curIdx), (int)m_exposureTime[curIdx]));
+        this->set_parameter(rclcpp::Parameter("exposure_time_" + std::to_string(curIdx), (int)stream.exposureTime));
     } catch (std::exception &exception) {
         RCLCPP_INFO(this->get_logger(), "Caught exception in onNewExposure callback: %s", exception.what());
     }
@@ -391,6 +1054,19 @@ void CameraNode::onNewExposure(const uint32_t exposureTime, const royale::Stream
 rcl_interfaces::msg::SetParametersResult CameraNode::onSetParameters(const std::vector<rclcpp::Parameter> &parameters) {
     rcl_interfaces::msg::SetParametersResult result;
     result.successful = true;
+    auto temporalFilterSettings = m_temporalFilterSettings;
+    auto flyingPixelFilterSettings = m_flyingPixelFilterSettings;
+    auto scannerSettings = m_scannerSettings;
+    auto reducerSettings = m_reducerSettings;
+    auto statisticsSettings = m_statisticsSettings;
+    auto compressionPrecision = m_compressionPrecision.load();
+
+    // Most parameters are applied to the camera, which is gone while the watchdog waits for it
+    if (!m_cameraDevice) {
+        result.successful = false;
+        result.reason = "Camera is not connected";
+        return result;
+    }
 
     for (auto &parameter : parameters) {
         if (!result.successful) {
@@ -398,56 +1074,166 @@ rcl_interfaces::msg::SetParametersResult CameraNode::onSetParameters(const std::
         }
         if (parameter.get_name() == "usecase" && parameter.get_type() == rclcpp::PARAMETER_STRING) {
             result.successful = setUseCase(parameter.as_string());
+            // The streams declare and undeclare parameters, which isn't possible within this callback
+            if (result.successful) {
+                m_reinitUseCaseTimer = this->create_wall_timer(std::chrono::milliseconds(0),
+                                                               std::bind(&CameraNode::reinitUseCase, this));
+            }
+        } else if (parameter.get_name() == "stamp_source" && parameter.get_type() == rclcpp::PARAMETER_STRING) {
+            result.successful = setStampSource(parameter.as_string());
+        } else if (parameter.get_name() == "point_cloud_fields" && parameter.get_type() == rclcpp::PARAMETER_STRING) {
+            result.successful = setPointCloudFields(parameter.as_string());
+        } else if (parameter.get_name() == "temporal_filter" && parameter.get_type() == rclcpp::PARAMETER_STRING) {
+            result.successful = TemporalFilter::parseMode(parameter.as_string(), temporalFilterSettings.mode);
+            if (!result.successful) {
+                result.reason = "Unknown temporal filter " + parameter.as_string();
+            }
+        } else if (parameter.get_name() == "temporal_filter_frames" && parameter.get_type() == rclcpp::PARAMETER_INTEGER) {
+            temporalFilterSettings.numFrames = (uint32_t)parameter.as_int();
+        } else if (parameter.get_name() == "temporal_filter_reset_distance" && parameter.get_type() == rclcpp::PARAMETER_DOUBLE) {
+            temporalFilterSettings.resetDistance = (float)parameter.as_double();
+        } else if (parameter.get_name() == "flying_pixel_filter" && parameter.get_type() == rclcpp::PARAMETER_BOOL) {
+            flyingPixelFilterSettings.enabled = parameter.as_bool();
+        } else if (parameter.get_name() == "flying_pixel_window" && parameter.get_type() == rclcpp::PARAMETER_INTEGER) {
+            flyingPixelFilterSettings.windowSize = (uint32_t)parameter.as_int();
+        } else if (parameter.get_name() == "flying_pixel_max_depth_jump" && parameter.get_type() == rclcpp::PARAMETER_DOUBLE) {
+            flyingPixelFilterSettings.maxDepthJump = (float)parameter.as_double();
+        } else if (parameter.get_name() == "flying_pixel_min_angle" && parameter.get_type() == rclcpp::PARAMETER_DOUBLE) {
+            flyingPixelFilterSettings.minAngle = (float)parameter.as_double();
+        } else if (parameter.get_name() == "scan_min_height" && parameter.get_type() == rclcpp::PARAMETER_DOUBLE) {
+            scannerSettings.minHeight = (float)parameter.as_double();
+        } else if (parameter.get_name() == "scan_max_height" && parameter.get_type() == rclcpp::PARAMETER_DOUBLE) {
+            scannerSettings.maxHeight = (float)parameter.as_double();
+        } else if (parameter.get_name() == "scan_range_min" && parameter.get_type() == rclcpp::PARAMETER_DOUBLE) {
+            scannerSettings.rangeMin = (float)parameter.as_double();
+        } else if (parameter.get_name() == "scan_range_max" && parameter.get_type() == rclcpp::PARAMETER_DOUBLE) {
+            scannerSettings.rangeMax = (float)parameter.as_double();
+        } else if (parameter.get_name() == "reduced_mode" && parameter.get_type() == rclcpp::PARAMETER_STRING) {
+            result.successful = FrameReducer::parseMode(parameter.as_string(), reducerSettings.mode);
+            if (!result.successful) {
+                result.reason = "Unknown reduction " + parameter.as_string();
+            }
+        } else if (parameter.get_name() == "reduced_factor" && parameter.get_type() == rclcpp::PARAMETER_INTEGER) {
+            reducerSettings.factor = (uint32_t)parameter.as_int();
+        } else if (parameter.get_name() == "depth_statistics_decimation" && parameter.get_type() == rclcpp::PARAMETER_INTEGER) {
+            statisticsSettings.decimation = (uint32_t)parameter.as_int();
+        } else if (parameter.get_name() == "depth_statistics_range" && parameter.get_type() == rclcpp::PARAMETER_DOUBLE) {
+            statisticsSettings.histogramRange = (float)parameter.as_double();
+        } else if (parameter.get_name() == "compressed_cloud_precision" && parameter.get_type() == rclcpp::PARAMETER_DOUBLE) {
+            compressionPrecision = (float)parameter.as_double();
         } else if (parameter.get_name().find("exposure_time_") == 0 && parameter.get_type() == rclcpp::PARAMETER_INTEGER) {
-            auto streamIdxStr = parameter.get_name().substr(strlen("exposure_time_"));
-            auto streamIdx = stoi(streamIdxStr);
-
-            if (!m_isAutoExposureEnabled[streamIdx]) {
-                StreamId streamId = 0;
-                bool found = false;
-                for (auto curIdx : m_streamIdx) {
-                    if (curIdx.second == streamIdx) {
-                        streamId = curIdx.first;
-                        found = true;
-                    }
-                }
-                if (found) {
-                    result.successful = setExposureTime((int)parameter.as_int(), streamId);
-                }
+            auto streamIdx = (uint32_t)stoi(parameter.get_name().substr(strlen("exposure_time_")));
+            if (streamIdx < m_streams.size() && !m_streams[streamIdx]->isAutoExposureEnabled) {
+                result.successful = setExposureTime((int)parameter.as_int(), streamIdx);
             }
         } else if (parameter.get_name().find("auto_exposure_") == 0 && parameter.get_type() == rclcpp::PARAMETER_BOOL) {
-            auto streamIdxStr = parameter.get_name().substr(strlen("auto_exposure_"));
-            auto streamIdx = stoi(streamIdxStr);
-            StreamId streamId = 0;
-            bool found = false;
-            for (auto curIdx : m_streamIdx) {
-                if (curIdx.second == streamIdx) {
-                    streamId = curIdx.first;
-                    found = true;
-                }
-            }
-            if (found) {
-                result.successful = enableAutoExposure(parameter.as_bool(), streamId);
+            auto streamIdx = (uint32_t)stoi(parameter.get_name().substr(strlen("auto_exposure_")));
+            if (streamIdx < m_streams.size()) {
+                result.successful = enableAutoExposure(parameter.as_bool(), streamIdx);
             }
         }
     }
 
+    if (result.successful) {
+        m_temporalFilterSettings = temporalFilterSettings;
+        m_flyingPixelFilterSettings = flyingPixelFilterSettings;
+        m_scannerSettings = scannerSettings;
+        m_reducerSettings = reducerSettings;
+        m_statisticsSettings = statisticsSettings;
+        m_compressionPrecision = compressionPrecision;
+        for (auto &stream : m_streams) {
+            stream->temporalFilter.configure(m_temporalFilterSettings);
+            stream->flyingPixelFilter.configure(m_flyingPixelFilterSettings);
+            stream->scanner.configure(m_scannerSettings);
+            stream->reducer.configure(m_reducerSettings);
+            stream->statistics.configure(m_statisticsSettings);
+        }
+    }
+
     return result;
 }
 
-void CameraNode::onParametersSetEvent(const rcl_interfaces::msg::ParameterEvent &event) {
-    auto params = rclcpp::ParameterEventHandler::get_parameters_from_event(event);
-    for (auto &param : params) {
-        if (param.get_name() == "usecase") {
-            initUseCase();
+void CameraNode::reinitUseCase() {
+    // One shot, run once after the usecase parameter was set
+    m_reinitUseCaseTimer->cancel();
 
-            if (m_cameraDevice->registerExposureListener(this) != CameraStatus::SUCCESS) {
-                RCLCPP_ERROR(this->get_logger(), "Couldn't register exposure listener!");
-                return;
-            }
-            m_cameraDevice->startCapture();
+    if (!initUseCase()) {
+        return;
+    }
+
+    if (m_cameraDevice->registerExposureListener(this) != CameraStatus::SUCCESS) {
+        RCLCPP_ERROR(this->get_logger(), "Couldn't register exposure listener!");
+        return;
+    }
+
+    // An inactive node starts the capture when it is activated
+    if (this->get_current_state().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE) {
+        m_cameraDevice->startCapture();
+    }
+}
+
+void CameraNode::transformToTarget(Stream &stream, Frame &frame) {
+    if (!m_tfBuffer) {
+        return;
+    }
+
+    // The transform is static, so it is only looked up once
+    if (!stream.hasTargetTransform) {
+        try {
+            auto transform = m_tfBuffer->lookupTransform(m_targetFrame, stream.frameId, tf2::TimePointZero);
+            stream.targetTransform = transformMatrix(transform.transform);
+            stream.hasTargetTransform = true;
+        } catch (const tf2::TransformException &exception) {
+            RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                                 "No transform to %s yet, publishing in %s: %s", m_targetFrame.c_str(),
+                                 stream.frameId.c_str(), exception.what());
+            return;
         }
     }
+
+    auto numPoints = frame.numPoints();
+    float *xyzc = frame.xyzc();
+    stream.rowBands->run(frame.height(), [&](uint32_t firstRow, uint32_t endRow) {
+        auto begin = size_t(firstRow) * frame.width();
+        auto end = std::min(size_t(endRow) * frame.width(), size_t(numPoints));
+        transformPoints(xyzc + 4 * begin, xyzc + 4 * begin, end - begin, stream.targetTransform);
+    });
+    frame.header.frame_id = m_targetFrame;
+}
+
+void CameraNode::fillCameraInfo(const Frame &frame, sensor_msgs::msg::CameraInfo &cameraInfo) {
+    sensor_msgs::msg::RegionOfInterest roi;
+    roi.x_offset = frame.xOffset();
+    roi.y_offset = frame.yOffset();
+    roi.width = frame.width();
+    roi.height = frame.height();
+    fillCameraInfo(frame.header.frame_id, frame.header.stamp, roi, frame.fullWidth(), frame.fullHeight(), cameraInfo);
+}
+
+void CameraNode::fillCameraInfo(const std::string &frameId, const builtin_interfaces::msg::Time &stamp,
+                                const sensor_msgs::msg::RegionOfInterest &roi, uint32_t fullWidth, uint32_t fullHeight,
+                                sensor_msgs::msg::CameraInfo &cameraInfo) {
+    // Assigning keeps the capacity of a reused message
+    cameraInfo = m_cameraInfo;
+    cameraInfo.header.frame_id = frameId;
+    cameraInfo.header.stamp = stamp;
+    cameraInfo.height = fullHeight;
+    cameraInfo.width = fullWidth;
+    // An all zero roi means the full image
+    if (roi.width != fullWidth || roi.height != fullHeight) {
+        cameraInfo.roi = roi;
+    }
+}
+
+const uint8_t *CameraNode::roiMask(const Stream &stream, uint32_t width, uint32_t height) {
+    if (stream.roiMask.empty()) {
+        return nullptr;
+    }
+    if (stream.roiMaskWidth != width || stream.roiMaskHeight != height) {
+        RCLCPP_WARN_ONCE(this->get_logger(), "The roi mask doesn't match the image size of %dx%d and is ignored", width, height);
+        return nullptr;
+    }
+    return stream.roiMask.data();
 }
 
 bool CameraNode::setCameraInfo() {
@@ -521,16 +1307,17 @@ bool CameraNode::setUseCase(const std::string &useCase) {
     return true;
 }
 
-bool CameraNode::setExposureTime(int exposureTime, royale::StreamId streamId) {
-    if (m_isAutoExposureEnabled[m_streamIdx[streamId]]) {
+bool CameraNode::setExposureTime(int exposureTime, uint32_t streamIdx) {
+    auto &stream = *m_streams[streamIdx];
+    if (stream.isAutoExposureEnabled) {
         return true;
     }
 
-    RCLCPP_INFO(this->get_logger(), "Setting exposure: %d %d", (int)exposureTime, streamId);
+    RCLCPP_INFO(this->get_logger(), "Setting exposure: %d %d", (int)exposureTime, stream.id);
     int tries = 5;
     CameraStatus ret;
     do {
-        ret = m_cameraDevice->setExposureTime(exposureTime, streamId);
+        ret = m_cameraDevice->setExposureTime(exposureTime, stream.id);
         if (ret == CameraStatus::DEVICE_IS_BUSY) {
             this_thread::sleep_for(chrono::milliseconds(200));
             tries--;
@@ -546,62 +1333,394 @@ bool CameraNode::setExposureTime(int exposureTime, royale::StreamId streamId) {
     return ret == CameraStatus::SUCCESS;
 }
 
-bool CameraNode::enableAutoExposure(bool enable, royale::StreamId streamId) {
-    RCLCPP_INFO(this->get_logger(), "Setting auto exposure: %d %d", (int)enable, streamId);
-    auto result = m_cameraDevice->setExposureMode(enable ? royale::ExposureMode::AUTOMATIC : royale::ExposureMode::MANUAL, streamId);
+bool CameraNode::enableAutoExposure(bool enable, uint32_t streamIdx) {
+    auto &stream = *m_streams[streamIdx];
+    RCLCPP_INFO(this->get_logger(), "Setting auto exposure: %d %d", (int)enable, stream.id);
+    auto result = m_cameraDevice->setExposureMode(enable ? royale::ExposureMode::AUTOMATIC : royale::ExposureMode::MANUAL, stream.id);
     if (result != royale::CameraStatus::SUCCESS) {
         RCLCPP_ERROR(this->get_logger(), "Error setting auto exposure: %d", (int)enable);
         return false;
     }
-    m_isAutoExposureEnabled[m_streamIdx[streamId]] = enable;
+    stream.isAutoExposureEnabled = enable;
     return result == CameraStatus::SUCCESS;
 }
 
-void CameraNode::initUseCase() {
+bool CameraNode::setStampSource(const std::string &stampSource) {
+    if (stampSource == "device") {
+        m_stampSource = StampSource::Device;
+    } else if (stampSource == "arrival") {
+        m_stampSource = StampSource::Arrival;
+    } else if (stampSource == "synchronized") {
+        m_stampSource = StampSource::Synchronized;
+    } else {
+        RCLCPP_ERROR(this->get_logger(), "Unknown stamp source: %s", stampSource.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CameraNode::setPointCloudFields(const std::string &pointCloudFields) {
+    if (pointCloudFields == "xyz") {
+        m_cloudFields = Frame::CloudFields::Xyz;
+    } else if (pointCloudFields == "xyzc") {
+        m_cloudFields = Frame::CloudFields::Xyzc;
+    } else if (pointCloudFields == "xyzi") {
+        m_cloudFields = Frame::CloudFields::Xyzi;
+    } else if (pointCloudFields == "xyzic") {
+        m_cloudFields = Frame::CloudFields::Xyzic;
+    } else {
+        RCLCPP_ERROR(this->get_logger(), "Unknown point cloud fields: %s", pointCloudFields.c_str());
+        return false;
+    }
+    return true;
+}
+
+rclcpp::Time CameraNode::frameStamp(uint64_t deviceTimestampUs, const rclcpp::Time &arrival, bool addSample) {
+    // The clock sync is fed with every capture, so its offset and drift are also reported if it isn't used
+    auto synchronizedNs = addSample ? m_clockSync.update(deviceTimestampUs, arrival.nanoseconds())
+                                    : m_clockSync.toHost(deviceTimestampUs);
+
+    switch (m_stampSource.load()) {
+    case StampSource::Arrival:
+        return arrival;
+    case StampSource::Synchronized:
+        return rclcpp::Time(synchronizedNs, arrival.get_clock_type());
+    default:
+        return rclcpp::Time(
+            (chrono::duration_cast<chrono::nanoseconds>(chrono::microseconds(deviceTimestampUs))).count());
+    }
+}
+
+bool CameraNode::initUseCase() {
     Vector<StreamId> streamIds;
     if (m_cameraDevice->getStreams(streamIds) != CameraStatus::SUCCESS) {
         RCLCPP_ERROR(this->get_logger(), "Couldn't retrieve streams!");
-        return;
+        return false;
     }
+
+    // Drop the streams the new usecase doesn't have anymore, the remaining ones keep their topics
+    while (m_streams.size() > streamIds.size()) {
+        destroyStream(static_cast<uint32_t>(m_streams.size() - 1));
+    }
+
     m_streamIdx.clear();
     for (auto i = 0u; i < streamIds.size(); ++i) {
         m_streamIdx[streamIds[i]] = i;
     }
 
+    auto fps = nominalFps(*m_cameraDevice);
     for (auto i = 0u; i < streamIds.size(); ++i) {
-        ExposureMode expoMode;
-        m_cameraDevice->getExposureMode(expoMode, streamIds[i]);
-        m_isAutoExposureEnabled[i] = (expoMode == ExposureMode::AUTOMATIC);
+        if (i < m_streams.size()) {
+            updateStream(i, streamIds[i]);
+        } else if (!createStream(i, streamIds[i])) {
+            return false;
+        }
+        m_streams[i]->diagnostics->setNominalFps(fps);
+        m_streams[i]->scanTime = fps > 0. ? static_cast<float>(1. / fps) : 0.f;
+    }
+    m_watchdog.setStreams(m_streams.size(), fps);
 
-        this->set_parameter(rclcpp::Parameter("auto_exposure_" + std::to_string(i), m_isAutoExposureEnabled[i]));
+    publishRegistry();
+    return true;
+}
+
+void CameraNode::publishRegistry() {
+    CameraRegistryEntry entry;
+    entry.node = this->get_fully_qualified_name();
+    entry.serial = m_serial;
+    entry.model = m_model;
+    entry.usecase = this->get_parameter("usecase").as_string();
+    entry.numStreams = static_cast<uint32_t>(m_streams.size());
+    addRegistryTopic(entry, -1, m_pubCameraInfo);
+    addRegistryTopic(entry, -1, m_pubCameraInfoReduced);
+    for (auto i = 0u; i < m_streams.size(); ++i) {
+        auto &stream = *m_streams[i];
+        int idx = static_cast<int>(i);
+        addRegistryTopic(entry, idx, stream.pubCloud);
+        addRegistryTopic(entry, idx, stream.pubDepth);
+        addRegistryTopic(entry, idx, stream.pubGray);
+        addRegistryTopic(entry, idx, stream.pubScan);
+        addRegistryTopic(entry, idx, stream.pubCloudReduced);
+        addRegistryTopic(entry, idx, stream.pubDepthReduced);
+        addRegistryTopic(entry, idx, stream.pubStatistics);
+        addRegistryTopic(entry, idx, stream.pubCompressed);
+        addRegistryTopic(entry, idx, stream.pubShmNotify);
+        for (auto &output : stream.throttledOutputs) {
+            addRegistryTopic(entry, idx, output->pubCloud);
+            addRegistryTopic(entry, idx, output->pubDepth);
+        }
+    }
+
+    std_msgs::msg::String msg;
+    msg.data = entry.format();
+    m_pubRegistry->publish(msg);
+}
+
+bool CameraNode::createStream(uint32_t streamIdx, royale::StreamId streamId) {
+    auto idxStr = std::to_string(streamIdx);
+
+    m_streams.emplace_back(new Stream);
+    auto &stream = *m_streams.back();
+    stream.id = streamId;
+    stream.isPubCloud = false;
+    stream.isPubDepth = false;
+    stream.isPubGray = false;
+    stream.isPubShm = false;
+    stream.isPubScan = false;
+    stream.isPubCloudReduced = false;
+    stream.isPubDepthReduced = false;
+    stream.isPubStatistics = false;
+    stream.isPubCompressed = false;
+    stream.isPubThrottledCloud = false;
+    stream.scanTime = 0.f;
+    stream.hasTargetTransform = false;
+
+    // The frame id is read only, so it stays declared if the stream is destroyed and created again
+    if (this->has_parameter("frame_id_" + idxStr)) {
+        stream.frameId = this->get_parameter("frame_id_" + idxStr).as_string();
+    } else {
+        rcl_interfaces::msg::ParameterDescriptor frameIdParamDescriptor;
+        frameIdParamDescriptor.name = "frame_id_" + idxStr;
+        frameIdParamDescriptor.description = "Frame id of the messages of stream " + idxStr;
+        frameIdParamDescriptor.read_only = true;
+        stream.frameId = this->declare_parameter(frameIdParamDescriptor.name, std::string(this->get_name()) + "_optical_frame",
+                                                 frameIdParamDescriptor);
+    }
+
+    // The region of interest is read only as well
+    std::vector<int64_t> roi;
+    if (this->has_parameter("roi_" + idxStr)) {
+        roi = this->get_parameter("roi_" + idxStr).as_integer_array();
+    } else {
+        rcl_interfaces::msg::ParameterDescriptor roiParamDescriptor;
+        roiParamDescriptor.name = "roi_" + idxStr;
+        roiParamDescriptor.description = "Region of interest of stream " + idxStr + " as [x, y, width, height] in pixels";
+        roiParamDescriptor.additional_constraints = "Empty for the full image";
+        roiParamDescriptor.read_only = true;
+        roi = this->declare_parameter(roiParamDescriptor.name, std::vector<int64_t>(), roiParamDescriptor);
+    }
+    if (roi.size() == 4u && roi[0] >= 0 && roi[1] >= 0 && roi[2] > 0 && roi[3] > 0) {
+        stream.roi.x_offset = (uint32_t)roi[0];
+        stream.roi.y_offset = (uint32_t)roi[1];
+        stream.roi.width = (uint32_t)roi[2];
+        stream.roi.height = (uint32_t)roi[3];
+    } else if (!roi.empty()) {
+        RCLCPP_ERROR(this->get_logger(), "Invalid roi for stream %d, publishing the full image", streamIdx);
+    }
+
+    std::string roiMaskFile;
+    if (this->has_parameter("roi_mask_" + idxStr)) {
+        roiMaskFile = this->get_parameter("roi_mask_" + idxStr).as_string();
+    } else {
+        rcl_interfaces::msg::ParameterDescriptor roiMaskParamDescriptor;
+        roiMaskParamDescriptor.name = "roi_mask_" + idxStr;
+        roiMaskParamDescriptor.description = "Binary PGM image of the full sensor size, points are only published where it is not 0";
+        roiMaskParamDescriptor.read_only = true;
+        roiMaskFile = this->declare_parameter(roiMaskParamDescriptor.name, "", roiMaskParamDescriptor);
+    }
+    stream.roiMaskWidth = 0;
+    stream.roiMaskHeight = 0;
+    if (!roiMaskFile.empty() && !loadPgm(roiMaskFile, stream.roiMask, stream.roiMaskWidth, stream.roiMaskHeight)) {
+        RCLCPP_ERROR(this->get_logger(), "Couldn't load roi mask %s", roiMaskFile.c_str());
+        stream.roiMask.clear();
+    }
+
+    rcl_interfaces::msg::ParameterDescriptor enableAEParamDescriptor;
+    enableAEParamDescriptor.name = "auto_exposure_" + idxStr;
+    enableAEParamDescriptor.description = "Controls auto exposure for stream " + idxStr;
+    enableAEParamDescriptor.additional_constraints = "Cannot set the exposure_time parameter while this paramter's value is True";
+    stream.isAutoExposureEnabled = this->declare_parameter(enableAEParamDescriptor.name, true, enableAEParamDescriptor);
+    royale::ExposureMode expoMode = stream.isAutoExposureEnabled ? royale::ExposureMode::AUTOMATIC : royale::ExposureMode::MANUAL;
+    if (m_cameraDevice->setExposureMode(expoMode, streamId) != royale::CameraStatus::SUCCESS) {
+        RCLCPP_ERROR(this->get_logger(), "Could not configure exposure mode for stream %d", streamIdx);
+        return false;
+    }
+
+    // If user provided exposure_time and no auto_exposure,
+    royale::Pair<uint32_t, uint32_t> exposureLimits;
+    m_cameraDevice->getExposureLimits(exposureLimits, streamId);
+    rcl_interfaces::msg::ParameterDescriptor exposureParamDescriptor;
+    exposureParamDescriptor.name = "exposure_time_" + idxStr;
+    exposureParamDescriptor.description = "Current exposure time for stream " + idxStr;
+    exposureParamDescriptor.additional_constraints = "Cannot be set if auto_exposure is True. "
+                                                     "Must be within the integer range for the current usecase.";
+    rcl_interfaces::msg::IntegerRange exposureTimeRange;
+    exposureTimeRange.from_value = exposureLimits.first;
+    exposureTimeRange.to_value = exposureLimits.second;
+    exposureTimeRange.step = 1;
+    exposureParamDescriptor.integer_range.push_back(exposureTimeRange);
+    exposureParamDescriptor.dynamic_typing = true; // Set dynamic_typing to true only so this can be re-declared later
+    stream.exposureTime = this->declare_parameter(exposureParamDescriptor.name, (int)exposureLimits.second, exposureParamDescriptor, stream.isAutoExposureEnabled);
+    if (!stream.isAutoExposureEnabled) {
+        if (m_cameraDevice->setExposureTime((uint32_t)stream.exposureTime, streamId) != royale::CameraStatus::SUCCESS) {
+            RCLCPP_ERROR(this->get_logger(), "Could not set exposure time of %d for stream %d", (int)stream.exposureTime, streamIdx);
+            return false;
+        }
+    }
 
-        royale::Pair<uint32_t, uint32_t> exposureLimits;
-        m_cameraDevice->getExposureLimits(exposureLimits, streamIds[i]);
+    // Advertise our point cloud topic and image topics
+    stream.pubCloud = rclcpp::create_publisher<FrameAdapter>(*this, m_node_name + "/point_cloud_" + idxStr, 10);
+    stream.pubDepth = rclcpp::create_publisher<sensor_msgs::msg::Image>(*this, m_node_name + "/depth_image_" + idxStr, 10);
+    stream.pubGray = rclcpp::create_publisher<sensor_msgs::msg::Image>(*this, m_node_name + "/gray_image_" + idxStr, 10);
+    stream.pubScan = rclcpp::create_publisher<sensor_msgs::msg::LaserScan>(*this, m_node_name + "/scan_" + idxStr, 10);
+    stream.pubCloudReduced = rclcpp::create_publisher<FrameAdapter>(*this, m_node_name + "/point_cloud_" + idxStr + "/reduced", 10);
+    stream.pubDepthReduced = rclcpp::create_publisher<sensor_msgs::msg::Image>(*this, m_node_name + "/depth_image_" + idxStr + "/reduced", 10);
+    stream.pubStatistics = rclcpp::create_publisher<std_msgs::msg::Float32MultiArray>(*this, m_node_name + "/depth_statistics_" + idxStr, 10);
+    stream.pubCompressed = rclcpp::create_publisher<sensor_msgs::msg::CompressedImage>(*this, m_node_name + "/compressed_cloud_" + idxStr, 10);
+
+    stream.throttledDepthMask = 0;
+    stream.throttledReducedMask = 0;
+    for (auto &settings : m_throttledOutputs) {
+        auto bit = 1u << stream.throttledOutputs.size();
+        stream.throttledOutputs.emplace_back(new ThrottledOutput(settings));
+        auto &output = *stream.throttledOutputs.back();
+        auto topic = m_node_name + "/" + output.throttle.topic(streamIdx);
+        if (settings.output == OutputThrottle::Output::DepthImage) {
+            output.pubDepth = rclcpp::create_publisher<sensor_msgs::msg::Image>(*this, topic, 10);
+            stream.throttledDepthMask |= bit;
+        } else {
+            output.pubCloud = rclcpp::create_publisher<FrameAdapter>(*this, topic, 10);
+        }
+        if (settings.isReduced) {
+            stream.throttledReducedMask |= bit;
+        }
+    }
 
-        rcl_interfaces::msg::ParameterDescriptor exposureParamDescriptor = this->describe_parameter("exposure_time_" + std::to_string(i));
-        exposureParamDescriptor.integer_range.clear();
-        rcl_interfaces::msg::IntegerRange exposureTimeRange;
-        exposureTimeRange.from_value = exposureLimits.first;
-        exposureTimeRange.to_value = exposureLimits.second;
-        exposureTimeRange.step = 1;
-        exposureParamDescriptor.integer_range.push_back(exposureTimeRange);
-        this->undeclare_parameter("exposure_time_" + std::to_string(i));
-        this->declare_parameter("exposure_time_" + std::to_string(i), (int)exposureLimits.second, exposureParamDescriptor);
+    if (m_isShmRingEnabled) {
+        // Slots are sized for the full sensor, so they fit the frames of every usecase
+        uint16_t maxWidth = 0;
+        uint16_t maxHeight = 0;
+        m_cameraDevice->getMaxSensorWidth(maxWidth);
+        m_cameraDevice->getMaxSensorHeight(maxHeight);
+        auto shmName = shmFrameRingName(m_node_name, streamIdx);
+        stream.shmRing.reset(new ShmFrameRingWriter);
+        if (stream.shmRing->create(shmName, (uint32_t)m_shmRingSlots, (uint32_t)maxWidth * maxHeight)) {
+            RCLCPP_INFO(this->get_logger(), "Exporting stream %d to shared memory %s", streamIdx, shmName.c_str());
+        } else {
+            RCLCPP_ERROR(this->get_logger(), "Couldn't create shared memory %s", shmName.c_str());
+            stream.shmRing.reset();
+        }
+        stream.pubShmNotify = rclcpp::create_publisher<std_msgs::msg::UInt64>(
+            *this, m_node_name + "/point_cloud_" + idxStr + "/shm", 10);
     }
+
+    std::function<void(const std_msgs::msg::String::SharedPtr msg)> fcn = std::bind(&CameraNode::setProcParams, this, std::placeholders::_1, streamIdx);
+    stream.procParamsSubscription = this->create_subscription<std_msgs::msg::String>(
+        m_node_name + "/proc_params_" + idxStr, 10, fcn);
+
+    // One frame in conversion, one waiting for it, one being filled and a reduced one
+    stream.framePool.reset(new FramePool(4));
+    stream.rowBands.reset(new RowBandPool((uint32_t)m_filterThreads));
+    stream.temporalFilter.configure(m_temporalFilterSettings);
+    stream.flyingPixelFilter.configure(m_flyingPixelFilterSettings);
+    stream.scanner.configure(m_scannerSettings);
+    stream.reducer.configure(m_reducerSettings);
+    stream.statistics.configure(m_statisticsSettings);
+    stream.scanner.setIntrinsics(m_cameraInfo.k[0], m_cameraInfo.k[2]);
+
+    stream.diagnostics.reset(new StreamDiagnostics("stream " + idxStr));
+    m_diagnostics.add(*stream.diagnostics);
+
+    auto streamPtr = &stream;
+    stream.worker.reset(new FrameWorker([this, streamPtr](std::unique_ptr<Frame> frame, uint32_t throttledOutputs) {
+        processFrame(*streamPtr, std::move(frame), throttledOutputs);
+    }));
+
+    return true;
 }
 
-void CameraNode::updateDataListeners() {
-    m_isPubCloud = false;
-    m_isPubDepth = false;
-    m_isPubGray = false;
+void CameraNode::updateStream(uint32_t streamIdx, royale::StreamId streamId) {
+    auto idxStr = std::to_string(streamIdx);
+    auto &stream = *m_streams[streamIdx];
+    stream.id = streamId;
+
+    ExposureMode expoMode;
+    m_cameraDevice->getExposureMode(expoMode, streamId);
+    stream.isAutoExposureEnabled = (expoMode == ExposureMode::AUTOMATIC);
+
+    this->set_parameter(rclcpp::Parameter("auto_exposure_" + idxStr, stream.isAutoExposureEnabled));
+
+    royale::Pair<uint32_t, uint32_t> exposureLimits;
+    m_cameraDevice->getExposureLimits(exposureLimits, streamId);
+
+    rcl_interfaces::msg::ParameterDescriptor exposureParamDescriptor = this->describe_parameter("exposure_time_" + idxStr);
+    exposureParamDescriptor.integer_range.clear();
+    rcl_interfaces::msg::IntegerRange exposureTimeRange;
+    exposureTimeRange.from_value = exposureLimits.first;
+    exposureTimeRange.to_value = exposureLimits.second;
+    exposureTimeRange.step = 1;
+    exposureParamDescriptor.integer_range.push_back(exposureTimeRange);
+    this->undeclare_parameter("exposure_time_" + idxStr);
+    stream.exposureTime = this->declare_parameter("exposure_time_" + idxStr, (int)exposureLimits.second, exposureParamDescriptor);
+}
 
-    for (auto i = 0u; i < ROYALE_ROS_MAX_STREAMS; ++i) {
-        m_isPubCloud |= m_pubCloud[i]->get_subscription_count() > 0 || m_pubCloud[i]->get_intra_process_subscription_count() > 0;
-        m_isPubDepth |= m_pubDepth[i]->get_subscription_count() > 0 || m_pubDepth[i]->get_intra_process_subscription_count() > 0;
-        m_isPubGray |= m_pubGray[i]->get_subscription_count() > 0 || m_pubGray[i]->get_intra_process_subscription_count() > 0;
+void CameraNode::destroyStream(uint32_t streamIdx) {
+    auto idxStr = std::to_string(streamIdx);
+    auto &stream = *m_streams[streamIdx];
+
+    m_diagnostics.removeByName(stream.diagnostics->getName());
+    this->undeclare_parameter("auto_exposure_" + idxStr);
+    this->undeclare_parameter("exposure_time_" + idxStr);
+
+    m_streams.erase(m_streams.begin() + streamIdx);
+}
+
+void CameraNode::updateDataListeners() {
+    bool isPubCloud = false;
+    bool isPubDepth = false;
+    bool isPubGray = false;
+    bool isPubShm = false;
+    bool isPubScan = false;
+    bool isPubReduced = false;
+    bool isPubStatistics = false;
+    bool isPubCompressed = false;
+    bool isPubThrottled = false;
+    bool isPubThrottledCloud = false;
+
+    for (auto &stream : m_streams) {
+        stream->isPubCloud = stream->pubCloud->get_subscription_count() > 0 || stream->pubCloud->get_intra_process_subscription_count() > 0;
+        stream->isPubDepth = stream->pubDepth->get_subscription_count() > 0 || stream->pubDepth->get_intra_process_subscription_count() > 0;
+        stream->isPubGray = stream->pubGray->get_subscription_count() > 0 || stream->pubGray->get_intra_process_subscription_count() > 0;
+        // Shared memory readers announce themselves by subscribing to the notification topic
+        stream->isPubShm = stream->pubShmNotify && stream->pubShmNotify->get_subscription_count() > 0;
+        stream->isPubScan = stream->pubScan->get_subscription_count() > 0 || stream->pubScan->get_intra_process_subscription_count() > 0;
+        stream->isPubCloudReduced = stream->pubCloudReduced->get_subscription_count() > 0 || stream->pubCloudReduced->get_intra_process_subscription_count() > 0;
+        stream->isPubDepthReduced = stream->pubDepthReduced->get_subscription_count() > 0 || stream->pubDepthReduced->get_intra_process_subscription_count() > 0;
+        stream->isPubStatistics = stream->pubStatistics->get_subscription_count() > 0 || stream->pubStatistics->get_intra_process_subscription_count() > 0;
+        stream->isPubCompressed = stream->pubCompressed->get_subscription_count() > 0 || stream->pubCompressed->get_intra_process_subscription_count() > 0;
+
+        isPubCloud |= stream->isPubCloud;
+        isPubDepth |= stream->isPubDepth;
+        isPubGray |= stream->isPubGray;
+        isPubShm |= stream->isPubShm;
+        isPubScan |= stream->isPubScan;
+        isPubReduced |= stream->isPubCloudReduced || stream->isPubDepthReduced;
+        isPubStatistics |= stream->isPubStatistics;
+        isPubCompressed |= stream->isPubCompressed;
+
+        bool isStreamPubThrottledCloud = false;
+        for (auto &output : stream->throttledOutputs) {
+            output->isPub = output->pubCloud ? output->pubCloud->get_subscription_count() > 0 || output->pubCloud->get_intra_process_subscription_count() > 0
+                                             : output->pubDepth->get_subscription_count() > 0 || output->pubDepth->get_intra_process_subscription_count() > 0;
+            isPubThrottled |= output->isPub;
+            isStreamPubThrottledCloud |= output->isPub && output->pubCloud;
+        }
+        stream->isPubThrottledCloud = isStreamPubThrottledCloud;
+        isPubThrottledCloud |= isStreamPubThrottledCloud;
     }
 
-    bool shouldRegisterPCListener = m_isPubCloud || m_isPubDepth;
+    bool shouldRegisterPCListener = isPubCloud || isPubDepth || isPubShm || isPubScan || isPubReduced || isPubStatistics ||
+                                    isPubCompressed || isPubThrottled;
+
+    // The intensity of the clouds is the gray value of the same capture, which comes with the IR images
+    auto cloudFields = m_cloudFields.load();
+    bool hasIntensity = cloudFields == Frame::CloudFields::Xyzi || cloudFields == Frame::CloudFields::Xyzic;
+    bool shouldRegisterIRListener = isPubGray || (hasIntensity && (isPubCloud || isPubReduced || isPubThrottledCloud));
+
+    // The watchdog is waiting for a lost camera to come back, it registers the listeners again
+    if (!m_cameraDevice) {
+        return;
+    }
 
     if (!m_registeredPCListener && shouldRegisterPCListener) {
         if (m_cameraDevice->registerPointCloudListener(this) == CameraStatus::SUCCESS) {
@@ -619,14 +1738,14 @@ void CameraNode::updateDataListeners() {
         }
     }
 
-    if (!m_registeredIRListener && m_isPubGray) {
+    if (!m_registeredIRListener && shouldRegisterIRListener) {
         if (m_cameraDevice->registerIRImageListener(this) == CameraStatus::SUCCESS) {
             m_registeredIRListener = true;
             RCLCPP_DEBUG(this->get_logger(), "Registered IR data listener!");
         } else {
             RCLCPP_ERROR(this->get_logger(), "Couldn't register IR data listener!");
         }
-    } else if (m_registeredIRListener && !m_isPubGray) {
+    } else if (m_registeredIRListener && !shouldRegisterIRListener) {
         if (m_cameraDevice->unregisterIRImageListener() == CameraStatus::SUCCESS) {
             m_registeredIRListener = false;
             RCLCPP_DEBUG(this->get_logger(), "Unregistered IR data listener!");
@@ -634,6 +1753,10 @@ void CameraNode::updateDataListeners() {
             RCLCPP_ERROR(this->get_logger(), "Couldn't unregister IR data listener!");
         }
     }
+
+    for (auto &stream : m_streams) {
+        stream->diagnostics->setActive(m_registeredPCListener || m_registeredIRListener);
+    }
 }
 
 void CameraNode::setProcParams(const std_msgs::msg::String::SharedPtr parameters, uint32_t streamIdx) {
@@ -672,12 +1795,15 @@ void CameraNode::setProcParams(const std_msgs::msg::String::SharedPtr parameters
         RCLCPP_ERROR(this->get_logger(), "Processing parameter unknown : %s", params[0].c_str());
         return;
     }
-    StreamId streamId = 0;
-    for (auto curIdx : m_streamIdx) {
-        if (curIdx.second == streamIdx) {
-            streamId = curIdx.first;
-        }
+    if (streamIdx >= m_streams.size()) {
+        RCLCPP_ERROR(this->get_logger(), "Stream %d is not part of the current usecase", streamIdx);
+        return;
+    }
+    if (!m_cameraDevice) {
+        RCLCPP_ERROR(this->get_logger(), "Camera is not connected, ignoring parameter : %s", parameters->data.c_str());
+        return;
     }
+    StreamId streamId = m_streams[streamIdx]->id;
 
     royale::Vector<royale::Pair<royale::String, royale::Variant>> newParam({{params[0], value}});
     auto ret = m_cameraDevice->setProcessingParameters(newParam, streamId);
@@ -689,6 +1815,36 @@ void CameraNode::setProcParams(const std_msgs::msg::String::SharedPtr parameters
     }
 }
 
+void CameraNode::updateCameraDiagnostics(diagnostic_updater::DiagnosticStatusWrapper &stat) {
+    if (!m_cameraDevice) {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "No camera connected");
+        return;
+    }
+    stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Camera connected");
+    stat.add("Serial", m_serial);
+    stat.add("Model", m_model);
+    stat.add("Stamp source", this->get_parameter("stamp_source").as_string());
+    if (m_clockSync.sampleCount() > 0) {
+        stat.add("Clock offset (s)", m_clockSync.offset());
+        stat.add("Clock drift (ppm)", m_clockSync.drift());
+        stat.add("Clock arrival jitter (ms)", m_clockSync.jitter());
+        stat.add("Clock sync samples", m_clockSync.sampleCount());
+    }
+
+    // Royale has no dedicated temperature query, but some cameras report it in their camera info
+    royale::Vector<royale::Pair<royale::String, royale::String>> cameraInfo;
+    if (m_cameraDevice->getCameraInfo(cameraInfo) == CameraStatus::SUCCESS) {
+        for (auto &entry : cameraInfo) {
+            auto key = entry.first.toStdString();
+            auto lowerKey = key;
+            std::transform(lowerKey.begin(), lowerKey.end(), lowerKey.begin(), ::tolower);
+            if (lowerKey.find("temperature") != std::string::npos) {
+                stat.add(key, entry.second.toStdString());
+            }
+        }
+    }
+}
+
 } // namespace pmd_royale_ros_driver
 
 #include "rclcpp_components/register_node_macro.hpp"
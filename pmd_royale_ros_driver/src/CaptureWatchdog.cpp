@@ -0,0 +1,143 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <CaptureWatchdog.hpp>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+// Recovery levels, every further stall stays at the last one
+const uint32_t LEVEL_RESTART = 1;
+const uint32_t LEVEL_REOPEN = 2;
+const uint32_t LEVEL_REENUMERATE = 3;
+} // namespace
+
+CaptureWatchdog::CaptureWatchdog(const std::string &name)
+    : DiagnosticTask(name),
+      m_nominalFps(0.),
+      m_active(false),
+      m_level(0),
+      m_stalls(0),
+      m_recoveries(0),
+      m_reopens(0),
+      m_lastRecoveryTime(0.),
+      m_maxRecoveryTime(0.) {}
+
+void CaptureWatchdog::setStreams(size_t numStreams, double nominalFps) {
+    lock_guard<mutex> lock(m_mutex);
+    m_nominalFps = nominalFps;
+    m_lastFrames.resize(numStreams);
+    m_hasFrame.resize(numStreams);
+    restartTimeout(chrono::steady_clock::now());
+}
+
+void CaptureWatchdog::setActive(bool active) {
+    lock_guard<mutex> lock(m_mutex);
+    if (active != m_active) {
+        // Frames are only expected from now on, and a stall ends with the capture
+        m_active = active;
+        m_level = 0;
+        restartTimeout(chrono::steady_clock::now());
+    }
+}
+
+void CaptureWatchdog::restartTimeout() {
+    lock_guard<mutex> lock(m_mutex);
+    restartTimeout(chrono::steady_clock::now());
+}
+
+void CaptureWatchdog::onFrame(size_t streamIdx) {
+    lock_guard<mutex> lock(m_mutex);
+    if (streamIdx < m_lastFrames.size()) {
+        m_lastFrames[streamIdx] = chrono::steady_clock::now();
+        m_hasFrame[streamIdx] = true;
+    }
+}
+
+CaptureWatchdog::Action CaptureWatchdog::check() {
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_active || m_lastFrames.empty()) {
+        return Action::None;
+    }
+
+    auto now = chrono::steady_clock::now();
+    auto oldest = *min_element(m_lastFrames.begin(), m_lastFrames.end());
+    if (now - oldest < timeout()) {
+        // Recovered once every stream delivered a frame after the last action
+        if (m_level > 0 && all_of(m_hasFrame.begin(), m_hasFrame.end(), [](bool hasFrame) { return hasFrame; })) {
+            m_lastRecoveryTime = chrono::duration<double>(now - m_stallStart).count();
+            m_maxRecoveryTime = max(m_maxRecoveryTime, m_lastRecoveryTime);
+            m_recoveries++;
+            m_level = 0;
+        }
+        return Action::None;
+    }
+
+    if (m_level == 0) {
+        m_stalls++;
+        m_stallStart = oldest;
+    }
+    m_level = min(m_level + 1, LEVEL_REENUMERATE);
+    restartTimeout(now);
+
+    if (m_level == LEVEL_RESTART) {
+        return Action::RestartCapture;
+    }
+    m_reopens++;
+    return Action::ReopenDevice;
+}
+
+std::chrono::steady_clock::duration CaptureWatchdog::timeout() const {
+    chrono::steady_clock::duration timeout = MIN_TIMEOUT;
+    if (m_nominalFps > 0.) {
+        timeout = max(timeout, chrono::duration_cast<chrono::steady_clock::duration>(
+                                   chrono::duration<double>(STALL_PERIODS / m_nominalFps)));
+    }
+    return timeout;
+}
+
+void CaptureWatchdog::restartTimeout(std::chrono::steady_clock::time_point now) {
+    fill(m_lastFrames.begin(), m_lastFrames.end(), now);
+    fill(m_hasFrame.begin(), m_hasFrame.end(), false);
+}
+
+void CaptureWatchdog::run(diagnostic_updater::DiagnosticStatusWrapper &stat) {
+    lock_guard<mutex> lock(m_mutex);
+
+    if (!m_active) {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Idle, no capture");
+    } else if (m_level == LEVEL_RESTART) {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Stalled, restarted the capture");
+    } else if (m_level == LEVEL_REOPEN) {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "Stalled, reopened the camera");
+    } else if (m_level == LEVEL_REENUMERATE) {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "Stalled, waiting for the camera to be enumerated");
+    } else {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Capture running");
+    }
+
+    stat.add("Stall timeout (s)", chrono::duration<double>(timeout()).count());
+    stat.add("Stalls", m_stalls);
+    stat.add("Recoveries", m_recoveries);
+    stat.add("Camera reopens", m_reopens);
+    if (m_level > 0) {
+        stat.add("Stalled for (s)", chrono::duration<double>(chrono::steady_clock::now() - m_stallStart).count());
+    }
+    if (m_recoveries > 0) {
+        stat.add("Last recovery time (s)", m_lastRecoveryTime);
+        stat.add("Max recovery time (s)", m_maxRecoveryTime);
+    }
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,138 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <ClockSync.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+// Crystal oscillators stay well below this, a steeper fit comes from too few or too noisy samples
+const double MAX_DRIFT = 1e-3;
+// A mapping error above this means that one of the clocks jumped, e.g. the camera was reconnected
+const int64_t MAX_ERROR_NS = 1000000000;
+} // namespace
+
+ClockSync::ClockSync() {
+    reset();
+}
+
+void ClockSync::reset() {
+    lock_guard<mutex> lock(m_mutex);
+    m_samples.clear();
+    m_refDeviceUs = 0;
+    m_refArrivalNs = 0;
+    m_slope = 1.;
+    m_intercept = 0.;
+    m_jitter = 0.;
+}
+
+int64_t ClockSync::update(uint64_t deviceTimestampUs, int64_t arrivalNs) {
+    lock_guard<mutex> lock(m_mutex);
+
+    if (!m_samples.empty()) {
+        auto error = arrivalNs - map(deviceTimestampUs);
+        if (error > MAX_ERROR_NS || error < -MAX_ERROR_NS) {
+            m_samples.clear();
+        }
+    }
+
+    // The point cloud and gray image of a capture share their timestamp, one sample is enough
+    if (m_samples.empty() || m_samples.back().deviceUs != deviceTimestampUs) {
+        m_samples.push_back({deviceTimestampUs, arrivalNs});
+        if (m_samples.size() > WINDOW_SIZE) {
+            m_samples.pop_front();
+        }
+        fit();
+    }
+
+    return map(deviceTimestampUs);
+}
+
+int64_t ClockSync::toHost(uint64_t deviceTimestampUs) const {
+    lock_guard<mutex> lock(m_mutex);
+    return map(deviceTimestampUs);
+}
+
+double ClockSync::offset() const {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_samples.empty()) {
+        return 0.;
+    }
+    auto deviceUs = m_samples.back().deviceUs;
+    return (map(deviceUs) - static_cast<double>(deviceUs) * 1e3) * 1e-9;
+}
+
+double ClockSync::drift() const {
+    lock_guard<mutex> lock(m_mutex);
+    return (m_slope - 1.) * 1e6;
+}
+
+double ClockSync::jitter() const {
+    lock_guard<mutex> lock(m_mutex);
+    return m_jitter * 1e-6;
+}
+
+size_t ClockSync::sampleCount() const {
+    lock_guard<mutex> lock(m_mutex);
+    return m_samples.size();
+}
+
+void ClockSync::fit() {
+    // Work relative to the oldest sample, absolute nanoseconds don't fit into the mantissa of a double
+    m_refDeviceUs = m_samples.front().deviceUs;
+    m_refArrivalNs = m_samples.front().arrivalNs;
+
+    double n = static_cast<double>(m_samples.size());
+    double sumX = 0.;
+    double sumY = 0.;
+    for (auto &sample : m_samples) {
+        sumX += static_cast<double>(static_cast<int64_t>(sample.deviceUs - m_refDeviceUs)) * 1e3;
+        sumY += static_cast<double>(sample.arrivalNs - m_refArrivalNs);
+    }
+    double meanX = sumX / n;
+    double meanY = sumY / n;
+
+    double covXY = 0.;
+    double varX = 0.;
+    for (auto &sample : m_samples) {
+        double dx = static_cast<double>(static_cast<int64_t>(sample.deviceUs - m_refDeviceUs)) * 1e3 - meanX;
+        double dy = static_cast<double>(sample.arrivalNs - m_refArrivalNs) - meanY;
+        covXY += dx * dy;
+        varX += dx * dx;
+    }
+    m_slope = varX > 0. ? min(max(covXY / varX, 1. - MAX_DRIFT), 1. + MAX_DRIFT) : 1.;
+
+    double minResidual = numeric_limits<double>::max();
+    double maxResidual = numeric_limits<double>::lowest();
+    for (auto &sample : m_samples) {
+        double residual = static_cast<double>(sample.arrivalNs - m_refArrivalNs) -
+                          m_slope * static_cast<double>(static_cast<int64_t>(sample.deviceUs - m_refDeviceUs)) * 1e3;
+        minResidual = min(minResidual, residual);
+        maxResidual = max(maxResidual, residual);
+    }
+    m_intercept = minResidual;
+    m_jitter = maxResidual - minResidual;
+}
+
+int64_t ClockSync::map(uint64_t deviceTimestampUs) const {
+    if (m_samples.empty()) {
+        return static_cast<int64_t>(deviceTimestampUs) * 1000;
+    }
+    double x = static_cast<double>(static_cast<int64_t>(deviceTimestampUs - m_refDeviceUs)) * 1e3;
+    return m_refArrivalNs + static_cast<int64_t>(llround(m_intercept + m_slope * x));
+}
+
+} // namespace pmd_royale_ros_driver
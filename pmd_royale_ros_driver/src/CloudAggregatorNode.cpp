@@ -0,0 +1,200 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <CloudAggregatorNode.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+int64_t stampNs(const builtin_interfaces::msg::Time &stamp) {
+    return int64_t(stamp.sec) * 1000000000 + stamp.nanosec;
+}
+
+Frame::CloudFields cloudFields(bool hasIntensity, bool hasConf) {
+    if (hasIntensity) {
+        return hasConf ? Frame::CloudFields::Xyzic : Frame::CloudFields::Xyzi;
+    }
+    return hasConf ? Frame::CloudFields::Xyzc : Frame::CloudFields::Xyz;
+}
+} // namespace
+
+CloudAggregatorNode::CloudAggregatorNode(const rclcpp::NodeOptions &options)
+    : Node("pmd_royale_ros_cloud_aggregator", options),
+      m_isIntraProcess(options.use_intra_process_comms()),
+      m_syncToleranceNs(0),
+      m_framePool(3) {
+
+    rcl_interfaces::msg::ParameterDescriptor inputTopicsParameterDescriptor;
+    inputTopicsParameterDescriptor.name = "input_topics";
+    inputTopicsParameterDescriptor.description = "Point cloud topics of the cameras which are fused.";
+    inputTopicsParameterDescriptor.read_only = true;
+    auto inputTopics = this->declare_parameter("input_topics", std::vector<std::string>(), inputTopicsParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor targetFrameParameterDescriptor;
+    targetFrameParameterDescriptor.name = "target_frame";
+    targetFrameParameterDescriptor.description = "Frame the fused point cloud is published in.";
+    targetFrameParameterDescriptor.read_only = true;
+    m_targetFrame = this->declare_parameter("target_frame", "", targetFrameParameterDescriptor);
+
+    rcl_interfaces::msg::ParameterDescriptor syncToleranceParameterDescriptor;
+    syncToleranceParameterDescriptor.name = "sync_tolerance";
+    syncToleranceParameterDescriptor.description = "Maximum difference in seconds between the stamps of fused frames.";
+    syncToleranceParameterDescriptor.read_only = true;
+    double syncTolerance = this->declare_parameter("sync_tolerance", 0.01, syncToleranceParameterDescriptor);
+    m_syncToleranceNs = static_cast<int64_t>(syncTolerance * 1e9);
+
+    if (inputTopics.empty()) {
+        RCLCPP_ERROR(this->get_logger(), "No input topics given");
+        return;
+    }
+    if (m_targetFrame.empty()) {
+        RCLCPP_ERROR(this->get_logger(), "No target frame given");
+        return;
+    }
+
+    m_tfBuffer = std::make_shared<tf2_ros::Buffer>(this->get_clock());
+    m_tfListener = std::make_shared<tf2_ros::TransformListener>(*m_tfBuffer, this, true);
+
+    // The calling thread fuses one input as well
+    m_rowBands = std::make_unique<RowBandPool>(static_cast<uint32_t>(inputTopics.size() - 1));
+    m_offsets.resize(inputTopics.size() + 1);
+
+    m_pubCloud = rclcpp::create_publisher<FrameAdapter>(*this, std::string(this->get_name()) + "/fused_point_cloud", 10);
+
+    for (size_t idx = 0; idx < inputTopics.size(); ++idx) {
+        auto source = std::make_unique<Source>();
+        source->topic = inputTopics[idx];
+        source->subscription = this->create_subscription<FrameAdapter>(
+            source->topic, 10, [this, idx](std::shared_ptr<const Frame> frame) { onFrame(idx, std::move(frame)); });
+        m_sources.push_back(std::move(source));
+        RCLCPP_INFO(this->get_logger(), "Fusing %s into %s", inputTopics[idx].c_str(), m_targetFrame.c_str());
+    }
+}
+
+void CloudAggregatorNode::onFrame(size_t sourceIdx, std::shared_ptr<const Frame> frame) {
+    std::vector<std::shared_ptr<const Frame>> frames;
+    {
+        lock_guard<mutex> lock(m_queueMutex);
+        auto &queue = m_sources[sourceIdx]->frames;
+        queue.push_back(std::move(frame));
+        if (queue.size() > QUEUE_SIZE) {
+            queue.pop_front();
+        }
+        if (!takeMatchingFrames(sourceIdx, frames)) {
+            return;
+        }
+    }
+    fuse(frames);
+}
+
+bool CloudAggregatorNode::takeMatchingFrames(size_t sourceIdx, std::vector<std::shared_ptr<const Frame>> &frames) {
+    auto stamp = stampNs(m_sources[sourceIdx]->frames.back()->header.stamp);
+
+    // The closest frame of every input, which must be within the tolerance
+    std::vector<size_t> matches(m_sources.size());
+    for (size_t idx = 0; idx < m_sources.size(); ++idx) {
+        auto &queue = m_sources[idx]->frames;
+        if (queue.empty()) {
+            return false;
+        }
+        int64_t bestDiff = std::numeric_limits<int64_t>::max();
+        for (size_t i = 0; i < queue.size(); ++i) {
+            auto diff = std::abs(stampNs(queue[i]->header.stamp) - stamp);
+            if (diff < bestDiff) {
+                bestDiff = diff;
+                matches[idx] = i;
+            }
+        }
+        if (bestDiff > m_syncToleranceNs) {
+            return false;
+        }
+    }
+
+    // Frames up to the matching ones are used or too old to be matched later
+    frames.resize(m_sources.size());
+    for (size_t idx = 0; idx < m_sources.size(); ++idx) {
+        auto &queue = m_sources[idx]->frames;
+        frames[idx] = queue[matches[idx]];
+        queue.erase(queue.begin(), queue.begin() + matches[idx] + 1);
+    }
+    return true;
+}
+
+bool CloudAggregatorNode::lookupTransform(Source &source, const std::string &frameId) {
+    // The transform is static, so it is only looked up once per frame id
+    if (source.frameId == frameId) {
+        return true;
+    }
+    try {
+        auto transform = m_tfBuffer->lookupTransform(m_targetFrame, frameId, tf2::TimePointZero);
+        source.transform = transformMatrix(transform.transform);
+        source.frameId = frameId;
+        return true;
+    } catch (const tf2::TransformException &exception) {
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000, "No transform from %s to %s yet: %s",
+                             frameId.c_str(), m_targetFrame.c_str(), exception.what());
+        return false;
+    }
+}
+
+void CloudAggregatorNode::fuse(const std::vector<std::shared_ptr<const Frame>> &frames) {
+    lock_guard<mutex> lock(m_fuseMutex);
+
+    bool hasIntensity = true;
+    bool hasConf = true;
+    m_offsets[0] = 0;
+    for (size_t idx = 0; idx < frames.size(); ++idx) {
+        if (!lookupTransform(*m_sources[idx], frames[idx]->header.frame_id)) {
+            return;
+        }
+        hasIntensity = hasIntensity && frames[idx]->hasIntensityField();
+        hasConf = hasConf && frames[idx]->hasConfidenceField();
+        m_offsets[idx + 1] = m_offsets[idx] + frames[idx]->numPoints();
+    }
+
+    // The frames of the inputs keep their order, each one is written to its own range of the fused frame
+    auto fused = m_framePool.acquire();
+    fused->resize(static_cast<uint32_t>(m_offsets.back()), 1);
+    fused->setCloudFields(cloudFields(hasIntensity, hasConf));
+    fused->header.stamp = frames[0]->header.stamp;
+    fused->header.frame_id = m_targetFrame;
+    float *xyzc = fused->xyzc();
+    uint8_t *gray = hasIntensity ? fused->initGray() : nullptr;
+
+    m_rowBands->run(static_cast<uint32_t>(frames.size()), [&](uint32_t first, uint32_t end) {
+        for (auto idx = first; idx < end; ++idx) {
+            const Frame &frame = *frames[idx];
+            auto offset = m_offsets[idx];
+            transformPoints(frame.xyzc(), xyzc + 4 * offset, frame.numPoints(), m_sources[idx]->transform);
+            if (gray) {
+                if (frame.hasGray()) {
+                    ::memcpy(gray + offset, frame.gray(), frame.numPoints());
+                } else {
+                    ::memset(gray + offset, 0, frame.numPoints());
+                }
+            }
+        }
+    });
+
+    publishFrame(*m_pubCloud, m_msgCloud, m_isIntraProcess, fused);
+    m_framePool.release(std::move(fused));
+}
+
+} // namespace pmd_royale_ros_driver
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(pmd_royale_ros_driver::CloudAggregatorNode)
@@ -0,0 +1,200 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+// Measures the cloud codec on the frames of every usecase of a camera, or on a recording: the bits per point and
+// the time it takes to encode and decode a frame, and the largest error of the decoded points.
+//
+// Usage: cloud_codec_benchmark [--serial <serial> | --playback <file.rrf>] [--frames <n>] [--precision <meters>]
+//                              [--access_code <code>]
+
+#include <CloudCodec.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <royale.hpp>
+#include <royale/IReplay.hpp>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace royale;
+using namespace pmd_royale_ros_driver;
+
+namespace {
+struct CapturedFrame {
+    uint32_t width;
+    uint32_t height;
+    vector<float> xyzc;
+};
+
+// Copies the point clouds of the capture until it has enough of them
+class FrameCollector : public IPointCloudListener {
+  public:
+    explicit FrameCollector(size_t numFrames) : m_numFrames(numFrames) {}
+
+    void onNewData(const PointCloud *data) override {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_frames.size() >= m_numFrames) {
+            return;
+        }
+        size_t numPoints = size_t(data->width) * data->height;
+        m_frames.push_back({data->width, data->height, vector<float>(data->xyzcPoints, data->xyzcPoints + 4 * numPoints)});
+        if (m_frames.size() == m_numFrames) {
+            m_condition.notify_all();
+        }
+    }
+
+    vector<CapturedFrame> wait(chrono::seconds timeout) {
+        unique_lock<mutex> lock(m_mutex);
+        m_condition.wait_for(lock, timeout, [this] { return m_frames.size() >= m_numFrames; });
+        return std::move(m_frames);
+    }
+
+  private:
+    size_t m_numFrames;
+    mutex m_mutex;
+    condition_variable m_condition;
+    vector<CapturedFrame> m_frames;
+};
+
+double milliseconds(chrono::steady_clock::duration duration) {
+    return chrono::duration<double, milli>(duration).count();
+}
+
+void benchmark(const string &useCase, const vector<CapturedFrame> &frames, float precision) {
+    CloudCodec encoder;
+    CloudCodec decoder;
+    vector<uint8_t> data;
+    vector<float> decoded;
+
+    size_t totalPoints = 0;
+    size_t validPoints = 0;
+    size_t totalBytes = 0;
+    chrono::steady_clock::duration encodeTime{0};
+    chrono::steady_clock::duration decodeTime{0};
+    float maxError = 0.f;
+    bool isCorrect = true;
+
+    for (auto &frame : frames) {
+        auto start = chrono::steady_clock::now();
+        encoder.encode(frame.xyzc.data(), frame.width, frame.height, precision, data);
+        auto encoded = chrono::steady_clock::now();
+        uint32_t width = 0;
+        uint32_t height = 0;
+        isCorrect = decoder.decode(data.data(), data.size(), decoded, width, height) && isCorrect;
+        auto end = chrono::steady_clock::now();
+        encodeTime += encoded - start;
+        decodeTime += end - encoded;
+
+        auto numPoints = size_t(frame.width) * frame.height;
+        totalPoints += numPoints;
+        totalBytes += data.size();
+        isCorrect = isCorrect && width == frame.width && height == frame.height;
+        for (size_t i = 0; isCorrect && i < numPoints; ++i) {
+            if (frame.xyzc[4 * i + 3] > 0.f) {
+                validPoints++;
+                for (auto c = 0u; c < 3; ++c) {
+                    maxError = max(maxError, fabsf(frame.xyzc[4 * i + c] - decoded[4 * i + c]));
+                }
+            } else {
+                isCorrect = decoded[4 * i + 3] == 0.f;
+            }
+        }
+    }
+
+    if (frames.empty() || totalPoints == 0) {
+        printf("%-28s no frames\n", useCase.c_str());
+        return;
+    }
+    auto numFrames = frames.size();
+    printf("%-28s %4ux%-4u %6.1f%% %8.2f %8.2f %8.1f %9.3f %9.3f %10.5f %s\n", useCase.c_str(), frames.front().width,
+           frames.front().height, 100. * validPoints / totalPoints, 8. * totalBytes / totalPoints,
+           validPoints ? 8. * totalBytes / validPoints : 0., 16. * totalPoints / totalBytes,
+           milliseconds(encodeTime) / numFrames, milliseconds(decodeTime) / numFrames, maxError,
+           isCorrect ? "ok" : "FAILED");
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    string serial;
+    string playback;
+    string accessCode;
+    size_t numFrames = 30;
+    float precision = 0.001f;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--serial") {
+            serial = argv[i + 1];
+        } else if (option == "--playback") {
+            playback = argv[i + 1];
+        } else if (option == "--access_code") {
+            accessCode = argv[i + 1];
+        } else if (option == "--frames") {
+            numFrames = max(1, atoi(argv[i + 1]));
+        } else if (option == "--precision") {
+            precision = static_cast<float>(atof(argv[i + 1]));
+        } else {
+            fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    CameraManager manager(accessCode.c_str());
+    unique_ptr<ICameraDevice> cameraDevice;
+    if (!playback.empty()) {
+        cameraDevice = manager.createCamera(playback);
+        auto replay = dynamic_cast<IReplay *>(cameraDevice.get());
+        if (replay) {
+            replay->loop(true);
+            replay->useTimestamps(false);
+        }
+    } else {
+        Vector<String> cameraList(manager.getConnectedCameraList());
+        if (cameraList.empty()) {
+            fprintf(stderr, "No camera found\n");
+            return 1;
+        }
+        cameraDevice = manager.createCamera(serial.empty() ? cameraList[0] : String(serial));
+    }
+    if (!cameraDevice || cameraDevice->initialize() != CameraStatus::SUCCESS) {
+        fprintf(stderr, "Could not open the camera\n");
+        return 1;
+    }
+
+    Vector<String> useCases;
+    if (cameraDevice->getUseCases(useCases) != CameraStatus::SUCCESS) {
+        fprintf(stderr, "Could not read the usecases\n");
+        return 1;
+    }
+
+    printf("Precision %.4f m, %zu frames per usecase, %.0f bits per raw point\n", precision, numFrames, 128.);
+    printf("%-28s %-9s %7s %8s %8s %8s %9s %9s %10s\n", "usecase", "size", "valid", "bits/pt", "bits/val", "ratio",
+           "enc (ms)", "dec (ms)", "max err (m)");
+    for (auto &useCase : useCases) {
+        // A recording only has the usecase it was recorded with
+        if (cameraDevice->setUseCase(useCase) != CameraStatus::SUCCESS) {
+            continue;
+        }
+        FrameCollector collector(numFrames);
+        cameraDevice->registerPointCloudListener(&collector);
+        cameraDevice->startCapture();
+        auto frames = collector.wait(chrono::seconds(10));
+        cameraDevice->stopCapture();
+        cameraDevice->unregisterPointCloudListener();
+        benchmark(useCase.toStdString(), frames, precision);
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <DepthStatistics.hpp>
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+// Points which are reduced side by side, a multiple of the vector width of the usual targets
+const uint32_t LANES = 16;
+
+// Points which are converted at once, small enough to stay in the L1 cache
+const uint32_t CHUNK_SIZE = 512;
+} // namespace
+
+DepthStatistics::DepthStatistics() : m_settings{1, 5.f}, m_frameCount(0) {
+    m_values.fill(0.f);
+}
+
+void DepthStatistics::configure(const Settings &settings) {
+    lock_guard<mutex> lock(m_mutex);
+    m_settings = settings;
+    m_settings.decimation = max(1u, settings.decimation);
+}
+
+bool DepthStatistics::nextFrame() {
+    lock_guard<mutex> lock(m_mutex);
+    bool isDue = m_frameCount % m_settings.decimation == 0;
+    m_frameCount++;
+    return isDue;
+}
+
+void DepthStatistics::apply(const Frame &frame, float *depth) {
+    lock_guard<mutex> lock(m_mutex);
+    if (depth) {
+        accumulate<true>(frame, depth);
+    } else {
+        accumulate<false>(frame, depth);
+    }
+}
+
+template <bool WriteDepth>
+void DepthStatistics::accumulate(const Frame &frame, float *depth) {
+    auto numPoints = frame.numPoints();
+    const float *xyzc = frame.xyzc();
+    float binScale = m_settings.histogramRange > 0.f ? HISTOGRAM_BINS / m_settings.histogramRange : 0.f;
+
+    // Each lane reduces every LANES-th point, the lanes are only combined at the end
+    float laneCount[LANES];
+    float laneSum[LANES];
+    float laneMin[LANES];
+    float laneMax[LANES];
+    for (auto lane = 0u; lane < LANES; ++lane) {
+        laneCount[lane] = 0.f;
+        laneSum[lane] = 0.f;
+        laneMin[lane] = numeric_limits<float>::max();
+        laneMax[lane] = 0.f;
+    }
+    uint32_t histogram[HISTOGRAM_BINS] = {};
+
+    // The frame is taken in chunks which stay in the cache between the loops
+    float chunkDepth[CHUNK_SIZE];
+    float chunkValid[CHUNK_SIZE];
+    for (size_t chunk = 0; chunk < numPoints; chunk += CHUNK_SIZE) {
+        auto chunkSize = static_cast<uint32_t>(min(size_t(CHUNK_SIZE), numPoints - chunk));
+        const float *points = xyzc + 4 * chunk;
+        float *chunkOut = WriteDepth ? depth + chunk : chunkDepth;
+
+        for (auto i = 0u; i < chunkSize; ++i) {
+            chunkOut[i] = points[4 * i + 2];
+            chunkValid[i] = points[4 * i + 3] > 0.f ? 1.f : 0.f;
+        }
+
+        // Only arithmetic on the lanes, so full blocks become vector operations
+        auto fullSize = chunkSize - chunkSize % LANES;
+        for (auto block = 0u; block < fullSize; block += LANES) {
+            for (auto lane = 0u; lane < LANES; ++lane) {
+                float z = chunkOut[block + lane];
+                float valid = chunkValid[block + lane];
+                laneCount[lane] += valid;
+                laneSum[lane] += valid * z;
+                laneMin[lane] = min(laneMin[lane], z + (1.f - valid) * numeric_limits<float>::max());
+                laneMax[lane] = max(laneMax[lane], valid * z);
+            }
+        }
+        for (auto i = fullSize; i < chunkSize; ++i) {
+            float z = chunkOut[i];
+            float valid = chunkValid[i];
+            auto lane = i - fullSize;
+            laneCount[lane] += valid;
+            laneSum[lane] += valid * z;
+            laneMin[lane] = min(laneMin[lane], z + (1.f - valid) * numeric_limits<float>::max());
+            laneMax[lane] = max(laneMax[lane], valid * z);
+        }
+
+        // The histogram scatters, it is the only scalar loop
+        for (auto i = 0u; i < chunkSize; ++i) {
+            if (chunkValid[i] > 0.f) {
+                auto bin = min(static_cast<uint32_t>(max(chunkOut[i], 0.f) * binScale), HISTOGRAM_BINS - 1);
+                histogram[bin]++;
+            }
+        }
+    }
+
+    double count = 0.;
+    double sum = 0.;
+    float minDepth = numeric_limits<float>::max();
+    float maxDepth = 0.f;
+    for (auto lane = 0u; lane < LANES; ++lane) {
+        count += laneCount[lane];
+        sum += laneSum[lane];
+        minDepth = min(minDepth, laneMin[lane]);
+        maxDepth = max(maxDepth, laneMax[lane]);
+    }
+
+    m_values[0] = numPoints ? static_cast<float>(count / numPoints) : 0.f;
+    m_values[1] = count > 0. ? minDepth : 0.f;
+    m_values[2] = maxDepth;
+    m_values[3] = count > 0. ? static_cast<float>(sum / count) : 0.f;
+    for (auto bin = 0u; bin < HISTOGRAM_BINS; ++bin) {
+        m_values[4 + bin] = count > 0. ? static_cast<float>(histogram[bin] / count) : 0.f;
+    }
+}
+
+void DepthStatistics::fill(std_msgs::msg::Float32MultiArray &msg) const {
+    if (msg.layout.dim.empty()) {
+        msg.layout.dim.resize(1);
+        msg.layout.dim[0].label = "valid_ratio,min,max,mean,histogram";
+        msg.layout.dim[0].size = NUM_VALUES;
+        msg.layout.dim[0].stride = NUM_VALUES;
+    }
+    msg.data.assign(m_values.begin(), m_values.end());
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,162 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <FlyingPixelFilter.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "FrameConversions.hpp"
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+// Count the valid and the suspicious neighbors at one offset for the columns of a row. The planes are passed as
+// restrict pointers: the compiler can't tell otherwise that the counters don't overlap the coordinates and doesn't
+// vectorize the loop.
+template <int Width>
+void countNeighbors(const float *__restrict x, const float *__restrict y, const float *__restrict z,
+                    const float *__restrict valid, ptrdiff_t offset, int dx, int rowWidth, float maxDepthJump,
+                    float cosMinAngleSq, float *__restrict suspicious, float *__restrict neighbors) {
+    const int width = Width ? Width : rowWidth;
+    const float *nx = x + offset;
+    const float *ny = y + offset;
+    const float *nz = z + offset;
+    const float *nvalid = valid + offset;
+    const int firstCol = max(0, -dx);
+    const int endCol = min(width, width - dx);
+
+    for (int col = firstCol; col < endCol; ++col) {
+        float vx = nx[col] - x[col];
+        float vy = ny[col] - y[col];
+        float vz = nz[col] - z[col];
+        float dot = vx * x[col] + vy * y[col] + vz * z[col];
+        float lengthSq = vx * vx + vy * vy + vz * vz;
+        float raySq = x[col] * x[col] + y[col] * y[col] + z[col] * z[col];
+
+        bool jump = fabsf(vz) > maxDepthJump * z[col];
+        // The angle between the neighbor and the ray is below minAngle if its cosine is above cos(minAngle)
+        bool grazing = dot * dot > cosMinAngleSq * lengthSq * raySq;
+        float isNeighbor = valid[col] * nvalid[col];
+        neighbors[col] += isNeighbor;
+        suspicious[col] += (jump || grazing) ? isNeighbor : 0.f;
+    }
+}
+} // namespace
+
+FlyingPixelFilter::FlyingPixelFilter() : m_width(0), m_height(0) {
+    configure({false, 3, 0.03f, 10.f});
+}
+
+void FlyingPixelFilter::configure(const Settings &settings) {
+    lock_guard<mutex> lock(m_mutex);
+    m_settings = settings;
+    m_settings.windowSize = settings.windowSize >= 5 ? 5 : 3;
+    float cosMinAngle = cosf(settings.minAngle * static_cast<float>(M_PI) / 180.f);
+    m_cosMinAngleSq = cosMinAngle * cosMinAngle;
+}
+
+void FlyingPixelFilter::apply(Frame &frame, RowBandPool &pool) {
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_settings.enabled) {
+        return;
+    }
+
+    auto numPoints = frame.numPoints();
+    if (frame.width() != m_width || frame.height() != m_height) {
+        m_width = frame.width();
+        m_height = frame.height();
+        m_x.resize(numPoints);
+        m_y.resize(numPoints);
+        m_z.resize(numPoints);
+        m_valid.resize(numPoints);
+        m_suspicious.resize(numPoints);
+        m_neighbors.resize(numPoints);
+    }
+
+    // The neighbors have to be read unfiltered, so all bands are copied before any of them is filtered
+    pool.run(m_height, [&](uint32_t firstRow, uint32_t endRow) {
+        const float *xyzc = frame.xyzc();
+        for (auto i = firstRow * m_width; i < endRow * m_width; ++i) {
+            m_x[i] = xyzc[4 * i];
+            m_y[i] = xyzc[4 * i + 1];
+            m_z[i] = xyzc[4 * i + 2];
+            m_valid[i] = xyzc[4 * i + 3] > 0.f && xyzc[4 * i + 2] > 0.f ? 1.f : 0.f;
+        }
+    });
+
+    pool.run(m_height, [&](uint32_t firstRow, uint32_t endRow) {
+        filterRows(frame, firstRow, endRow);
+    });
+}
+
+void FlyingPixelFilter::filterRows(Frame &frame, uint32_t firstRow, uint32_t endRow) {
+    switch (m_width) {
+    case FLEXX2_WIDTH:
+        filterRowsOfWidth<FLEXX2_WIDTH>(frame, firstRow, endRow);
+        break;
+    case FLEXX2_VGA_WIDTH:
+        filterRowsOfWidth<FLEXX2_VGA_WIDTH>(frame, firstRow, endRow);
+        break;
+    default:
+        filterRowsOfWidth<0>(frame, firstRow, endRow);
+        break;
+    }
+}
+
+template <int Width>
+void FlyingPixelFilter::filterRowsOfWidth(Frame &frame, uint32_t firstRow, uint32_t endRow) {
+    const int radius = static_cast<int>(m_settings.windowSize / 2);
+    const int width = Width ? Width : static_cast<int>(m_width);
+    const int height = static_cast<int>(m_height);
+    const float maxDepthJump = m_settings.maxDepthJump;
+    const float cosMinAngleSq = m_cosMinAngleSq;
+
+    for (int row = static_cast<int>(firstRow); row < static_cast<int>(endRow); ++row) {
+        const size_t rowStart = size_t(row) * width;
+        const float *x = m_x.data() + rowStart;
+        const float *y = m_y.data() + rowStart;
+        const float *z = m_z.data() + rowStart;
+        const float *valid = m_valid.data() + rowStart;
+        float *suspicious = m_suspicious.data() + rowStart;
+        float *neighbors = m_neighbors.data() + rowStart;
+
+        for (int col = 0; col < width; ++col) {
+            suspicious[col] = 0.f;
+            neighbors[col] = 0.f;
+        }
+
+        for (int dy = -radius; dy <= radius; ++dy) {
+            if (row + dy < 0 || row + dy >= height) {
+                continue;
+            }
+            for (int dx = -radius; dx <= radius; ++dx) {
+                if (dx == 0 && dy == 0) {
+                    continue;
+                }
+                countNeighbors<Width>(x, y, z, valid, ptrdiff_t(dy) * width + dx, dx, width, maxDepthJump,
+                                      cosMinAngleSq, suspicious, neighbors);
+            }
+        }
+
+        float *xyzc = frame.xyzc() + 4 * rowStart;
+        for (int col = 0; col < width; ++col) {
+            float keep = 2.f * suspicious[col] > neighbors[col] ? 0.f : 1.f;
+            xyzc[4 * col] *= keep;
+            xyzc[4 * col + 1] *= keep;
+            xyzc[4 * col + 2] *= keep;
+            xyzc[4 * col + 3] *= keep;
+        }
+    }
+}
+
+} // namespace pmd_royale_ros_driver
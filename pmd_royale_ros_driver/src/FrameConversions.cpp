@@ -0,0 +1,111 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <FrameConversions.hpp>
+
+#include <algorithm>
+
+#include <sensor_msgs/image_encodings.hpp>
+
+#include "DepthStatistics.hpp"
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+// The row kernels take the width as template parameter, 0 for the generic instantiation which reads it from the
+// region
+
+template <uint32_t Width>
+void copyRows(const float *src, uint32_t srcWidth, const sensor_msgs::msg::RegionOfInterest &roi, const uint8_t *mask,
+              float *dst) {
+    const uint32_t width = Width ? Width : roi.width;
+    for (auto row = 0u; row < roi.height; ++row) {
+        auto srcIdx = size_t(roi.y_offset + row) * srcWidth + roi.x_offset;
+        const float *srcRow = src + 4 * srcIdx;
+        float *dstRow = dst + 4 * size_t(row) * width;
+        if (mask) {
+            const uint8_t *maskRow = mask + srcIdx;
+            // The points are selected with a bit mask on their raw bits rather than a float select, which the
+            // compiler doesn't vectorize. The bits of 0.f are all zero.
+            for (auto col = 0u; col < width; ++col) {
+                uint32_t keep = maskRow[col] ? 0xffffffffu : 0u;
+                for (auto c = 0u; c < 4; ++c) {
+                    uint32_t bits;
+                    ::memcpy(&bits, srcRow + 4 * col + c, sizeof(bits));
+                    bits &= keep;
+                    ::memcpy(dstRow + 4 * col + c, &bits, sizeof(bits));
+                }
+            }
+        } else {
+            ::memcpy(dstRow, srcRow, 4 * sizeof(float) * width);
+        }
+    }
+}
+} // namespace
+
+sensor_msgs::msg::RegionOfInterest clampRoi(const sensor_msgs::msg::RegionOfInterest &roi, uint32_t width,
+                                            uint32_t height) {
+    sensor_msgs::msg::RegionOfInterest clamped;
+    clamped.x_offset = std::min(roi.x_offset, width - 1);
+    clamped.y_offset = std::min(roi.y_offset, height - 1);
+    clamped.width = roi.width ? std::min(roi.width, width - clamped.x_offset) : width - clamped.x_offset;
+    clamped.height = roi.height ? std::min(roi.height, height - clamped.y_offset) : height - clamped.y_offset;
+    return clamped;
+}
+
+void copyRoi(const float *src, uint32_t srcWidth, const sensor_msgs::msg::RegionOfInterest &roi, const uint8_t *mask,
+             float *dst) {
+    switch (roi.width) {
+    case FLEXX2_WIDTH:
+        copyRows<FLEXX2_WIDTH>(src, srcWidth, roi, mask, dst);
+        break;
+    case FLEXX2_VGA_WIDTH:
+        copyRows<FLEXX2_VGA_WIDTH>(src, srcWidth, roi, mask, dst);
+        break;
+    default:
+        copyRows<0>(src, srcWidth, roi, mask, dst);
+        break;
+    }
+}
+
+void copyGrayRoi(const uint8_t *src, uint32_t srcWidth, const sensor_msgs::msg::RegionOfInterest &roi, uint8_t *dst) {
+    // A row of the gray image is contiguous, so it is a plain copy for any width
+    for (auto row = 0u; row < roi.height; ++row) {
+        ::memcpy(dst + size_t(row) * roi.width, src + size_t(roi.y_offset + row) * srcWidth + roi.x_offset, roi.width);
+    }
+}
+
+void fillDepthImage(const Frame &frame, sensor_msgs::msg::Image &msgDepthImage, DepthStatistics *statistics) {
+    auto numPoints = frame.numPoints();
+
+    msgDepthImage.header = frame.header;
+    msgDepthImage.width = frame.width();
+    msgDepthImage.height = frame.height();
+    msgDepthImage.is_bigendian = false;
+    msgDepthImage.encoding = sensor_msgs::image_encodings::TYPE_32FC1;
+    msgDepthImage.step = static_cast<uint32_t>(sizeof(float) * frame.width());
+    msgDepthImage.data.resize(sizeof(float) * numPoints);
+
+    float *iterDepth = (float *)msgDepthImage.data.data();
+    if (statistics) {
+        statistics->apply(frame, iterDepth);
+        return;
+    }
+    const float *xyzc = frame.xyzc();
+
+    // Iterate over all the points of the frame
+    for (auto i = 0u; i < numPoints; ++i) {
+        *iterDepth++ = xyzc[i * 4 + 2];
+    }
+}
+
+} // namespace pmd_royale_ros_driver
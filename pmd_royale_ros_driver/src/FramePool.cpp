@@ -0,0 +1,77 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <FramePool.hpp>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+FramePool::PlaneRecycler::PlaneRecycler(size_t maxPlanes) : m_maxPlanes(maxPlanes) {
+    // Reserved up front, so recycling never allocates
+    m_xyzc.reserve(maxPlanes);
+    m_gray.reserve(maxPlanes);
+}
+
+void FramePool::PlaneRecycler::recycle(vector<float> &&xyzc, vector<uint8_t> &&gray) {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_xyzc.size() < m_maxPlanes && xyzc.capacity()) {
+        m_xyzc.push_back(std::move(xyzc));
+        m_gray.push_back(std::move(gray));
+    }
+}
+
+bool FramePool::PlaneRecycler::take(Frame &frame) {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_xyzc.empty()) {
+        return false;
+    }
+    frame.swapPlanes(m_xyzc.back(), m_gray.back());
+    m_xyzc.pop_back();
+    m_gray.pop_back();
+    return true;
+}
+
+FramePool::FramePool(size_t maxFrames) : m_maxFrames(maxFrames), m_recycler(make_shared<PlaneRecycler>(maxFrames)) {
+    // Reserved up front, so releasing a frame never allocates
+    m_frames.reserve(maxFrames);
+}
+
+unique_ptr<Frame> FramePool::acquire() {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_frames.empty()) {
+            auto frame = std::move(m_frames.back());
+            m_frames.pop_back();
+            return frame;
+        }
+    }
+    unique_ptr<Frame> frame(new Frame);
+    m_recycler->take(*frame);
+    frame->setRecycler(m_recycler);
+    return frame;
+}
+
+void FramePool::release(unique_ptr<Frame> frame) {
+    if (!frame) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_frames.size() < m_maxFrames) {
+            m_frames.push_back(std::move(frame));
+            return;
+        }
+    }
+    // Destroyed outside the lock, the planes go to the recycler
+    frame.reset();
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,173 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+// Measures the conversions and filters of the frame processing library on synthetic frames of the Flexx2 usecases
+// and of an odd width which takes the generic instantiation of the row kernels: the time per frame and per point of
+// each stage. No camera is needed.
+//
+// Usage: frame_processing_benchmark [--frames <n>] [--threads <n>]
+
+#include <DepthStatistics.hpp>
+#include <FlyingPixelFilter.hpp>
+#include <FrameConversions.hpp>
+#include <FrameReducer.hpp>
+#include <TemporalFilter.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace pmd_royale_ros_driver;
+
+namespace {
+// A scene of a few planes at different depths with noise, so the filters find edges, and some invalid pixels
+Frame makeFrame(uint32_t width, uint32_t height, uint32_t seed) {
+    mt19937 random(seed);
+    uniform_real_distribution<float> noise(-0.01f, 0.01f);
+    Frame frame(width, height);
+    uint8_t *gray = frame.initGray();
+    for (auto row = 0u; row < height; ++row) {
+        for (auto col = 0u; col < width; ++col) {
+            auto i = size_t(row) * width + col;
+            float z = (col / 17 + row / 5) % 3 + 1.f + noise(random);
+            bool isValid = random() % 7 != 0;
+            float *point = frame.xyzc() + 4 * i;
+            point[0] = (col - width * 0.5f) * 0.004f * z;
+            point[1] = (row - height * 0.5f) * 0.004f * z;
+            point[2] = isValid ? z : 0.f;
+            point[3] = isValid ? 0.2f + (random() % 80) * 0.01f : 0.f;
+            gray[i] = static_cast<uint8_t>(random());
+        }
+    }
+    return frame;
+}
+
+class StageTimer {
+  public:
+    explicit StageTimer(const vector<Frame> &frames) : m_frames(frames) {}
+
+    // Time run on every frame. The filters work in place, so they get a copy of the frame which isn't timed.
+    void measure(const string &stage, const function<void(Frame &)> &run) {
+        chrono::steady_clock::duration duration{0};
+        for (auto &frame : m_frames) {
+            Frame work = frame;
+            auto start = chrono::steady_clock::now();
+            run(work);
+            duration += chrono::steady_clock::now() - start;
+        }
+        auto numFrames = m_frames.size();
+        double ms = chrono::duration<double, milli>(duration).count() / numFrames;
+        printf("  %-28s %9.3f %9.2f\n", stage.c_str(), ms, 1e6 * ms / m_frames.front().numPoints());
+    }
+
+  private:
+    const vector<Frame> &m_frames;
+};
+
+void benchmark(uint32_t width, uint32_t height, size_t numFrames, RowBandPool &pool) {
+    vector<Frame> frames;
+    for (auto i = 0u; i < numFrames; ++i) {
+        frames.push_back(makeFrame(width, height, i));
+    }
+    auto numPoints = frames.front().numPoints();
+
+    printf("%ux%u%s\n", width, height, width == FLEXX2_WIDTH || width == FLEXX2_VGA_WIDTH ? "" : " (generic width)");
+    printf("  %-28s %9s %9s\n", "stage", "ms/frame", "ns/point");
+    StageTimer timer(frames);
+
+    // The region of interest is the whole frame, so the row kernel of the frame width is taken
+    sensor_msgs::msg::RegionOfInterest roi = clampRoi(sensor_msgs::msg::RegionOfInterest(), width, height);
+    vector<uint8_t> mask(numPoints);
+    for (auto i = 0u; i < numPoints; ++i) {
+        mask[i] = i % 5 != 0;
+    }
+    vector<float> xyzc(4 * numPoints);
+    vector<uint8_t> gray(numPoints);
+    timer.measure("copy roi", [&](Frame &frame) { copyRoi(frame.xyzc(), width, roi, nullptr, xyzc.data()); });
+    timer.measure("copy roi masked",
+                  [&](Frame &frame) { copyRoi(frame.xyzc(), width, roi, mask.data(), xyzc.data()); });
+    timer.measure("copy gray roi", [&](Frame &frame) { copyGrayRoi(frame.gray(), width, roi, gray.data()); });
+
+    sensor_msgs::msg::Image depthImage;
+    DepthStatistics statistics;
+    timer.measure("depth image", [&](Frame &frame) { fillDepthImage(frame, depthImage); });
+    timer.measure("depth image and statistics",
+                  [&](Frame &frame) { fillDepthImage(frame, depthImage, &statistics); });
+    timer.measure("depth statistics", [&](Frame &frame) { statistics.apply(frame, nullptr); });
+
+    vector<float> points(5 * numPoints);
+    const pair<const char *, pair<bool, bool>> layouts[] = {{"pack xyz", {false, false}},
+                                                            {"pack xyzc", {false, true}},
+                                                            {"pack xyzi", {true, false}},
+                                                            {"pack xyzic", {true, true}}};
+    for (auto &layout : layouts) {
+        timer.measure(layout.first, [&](Frame &frame) {
+            packCloud(frame.xyzc(), frame.gray(), numPoints, layout.second.first, layout.second.second, points.data());
+        });
+    }
+
+    FlyingPixelFilter flyingPixelFilter;
+    for (auto windowSize : {3u, 5u}) {
+        flyingPixelFilter.configure({true, windowSize, 0.05f, 10.f});
+        timer.measure("flying pixels " + to_string(windowSize) + "x" + to_string(windowSize),
+                      [&](Frame &frame) { flyingPixelFilter.apply(frame, pool); });
+    }
+
+    // The history is filled by the frames before, the first ones only have a shorter history
+    for (auto mode : {TemporalFilter::Mode::Mean, TemporalFilter::Mode::Median}) {
+        TemporalFilter temporalFilter;
+        temporalFilter.configure({mode, 4, 0.05f});
+        timer.measure(mode == TemporalFilter::Mode::Mean ? "temporal mean 4" : "temporal median 4",
+                      [&](Frame &frame) { temporalFilter.apply(frame, pool); });
+    }
+
+    FrameReducer reducer;
+    Frame reduced(width, height);
+    const pair<const char *, FrameReducer::Mode> modes[] = {{"mean", FrameReducer::Mode::Mean},
+                                                            {"median", FrameReducer::Mode::Median},
+                                                            {"nearest", FrameReducer::Mode::Nearest}};
+    for (auto &mode : modes) {
+        for (auto factor : {2u, 4u}) {
+            reducer.configure({mode.second, factor});
+            timer.measure("reduce " + string(mode.first) + " " + to_string(factor),
+                          [&](Frame &frame) { reducer.apply(frame, reduced, pool); });
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t numFrames = 100;
+    uint32_t numThreads = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--frames") {
+            numFrames = max(1, atoi(argv[i + 1]));
+        } else if (option == "--threads") {
+            numThreads = static_cast<uint32_t>(max(0, atoi(argv[i + 1])));
+        } else {
+            fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    RowBandPool pool(numThreads);
+    printf("%zu frames per size, %u filter threads besides the calling one\n", numFrames, numThreads);
+    benchmark(FLEXX2_WIDTH, 172, numFrames, pool);
+    benchmark(FLEXX2_VGA_WIDTH, 480, numFrames, pool);
+    benchmark(227, 171, numFrames, pool);
+    return 0;
+}
@@ -0,0 +1,230 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <FrameReducer.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+// The block size is a template parameter, so the loops over a block are unrolled and the compiler vectorizes
+// over the output columns
+
+template <uint32_t F>
+void reduceMean(const float *in, uint32_t inWidth, float *out, uint32_t outWidth) {
+    for (auto col = 0u; col < outWidth; ++col) {
+        float sum[4] = {0.f, 0.f, 0.f, 0.f};
+        float count = 0.f;
+        for (auto by = 0u; by < F; ++by) {
+            const float *block = in + 4 * (size_t(by) * inWidth + size_t(col) * F);
+            for (auto bx = 0u; bx < F; ++bx) {
+                const float *point = block + 4 * bx;
+                float valid = point[3] > 0.f && point[2] > 0.f ? 1.f : 0.f;
+                sum[0] += valid * point[0];
+                sum[1] += valid * point[1];
+                sum[2] += valid * point[2];
+                sum[3] += valid * point[3];
+                count += valid;
+            }
+        }
+        float scale = count > 0.f ? 1.f / count : 0.f;
+        for (auto i = 0u; i < 4; ++i) {
+            out[4 * col + i] = sum[i] * scale;
+        }
+    }
+}
+
+template <uint32_t F>
+void reduceMedian(const float *in, uint32_t inWidth, float *out, uint32_t outWidth) {
+    const float invalid = numeric_limits<float>::max();
+    for (auto col = 0u; col < outWidth; ++col) {
+        const float *samples[F * F];
+        float depth[F * F];
+        float count = 0.f;
+        for (auto by = 0u; by < F; ++by) {
+            for (auto bx = 0u; bx < F; ++bx) {
+                const float *point = in + 4 * (size_t(by) * inWidth + size_t(col) * F + bx);
+                bool valid = point[3] > 0.f && point[2] > 0.f;
+                samples[by * F + bx] = point;
+                depth[by * F + bx] = valid ? point[2] : invalid;
+                count += valid ? 1.f : 0.f;
+            }
+        }
+
+        // The median has (count - 1) / 2 smaller samples, ties are broken by the position in the block
+        float target = static_cast<float>(static_cast<int>(count - 1.f) / 2);
+        uint32_t median = 0;
+        for (auto k = 0u; k < F * F; ++k) {
+            float rank = 0.f;
+            for (auto j = 0u; j < F * F; ++j) {
+                rank += (depth[j] < depth[k] || (j < k && depth[j] == depth[k])) ? 1.f : 0.f;
+            }
+            median = rank == target && depth[k] < invalid ? k : median;
+        }
+
+        for (auto i = 0u; i < 4; ++i) {
+            out[4 * col + i] = count > 0.f ? samples[median][i] : 0.f;
+        }
+    }
+}
+
+template <uint32_t F>
+void reduceNearest(const float *in, uint32_t inWidth, float *out, uint32_t outWidth, const uint32_t *blockOrder) {
+    for (auto col = 0u; col < outWidth; ++col) {
+        float point[4] = {0.f, 0.f, 0.f, 0.f};
+        // Valid pixels closer to the center overwrite the ones further out
+        for (auto k = 0u; k < F * F; ++k) {
+            auto by = blockOrder[k] / F;
+            auto bx = blockOrder[k] % F;
+            const float *sample = in + 4 * (size_t(by) * inWidth + size_t(col) * F + bx);
+            bool valid = sample[3] > 0.f && sample[2] > 0.f;
+            for (auto i = 0u; i < 4; ++i) {
+                point[i] = valid ? sample[i] : point[i];
+            }
+        }
+        for (auto i = 0u; i < 4; ++i) {
+            out[4 * col + i] = point[i];
+        }
+    }
+}
+
+template <uint32_t F>
+void reduceRow(FrameReducer::Mode mode, const float *in, uint32_t inWidth, float *out, uint32_t outWidth,
+               const uint32_t *blockOrder) {
+    switch (mode) {
+    case FrameReducer::Mode::Mean:
+        reduceMean<F>(in, inWidth, out, outWidth);
+        break;
+    case FrameReducer::Mode::Median:
+        reduceMedian<F>(in, inWidth, out, outWidth);
+        break;
+    case FrameReducer::Mode::Nearest:
+        reduceNearest<F>(in, inWidth, out, outWidth, blockOrder);
+        break;
+    }
+}
+} // namespace
+
+bool FrameReducer::parseMode(const std::string &name, Mode &mode) {
+    if (name == "mean") {
+        mode = Mode::Mean;
+    } else if (name == "median") {
+        mode = Mode::Median;
+    } else if (name == "nearest") {
+        mode = Mode::Nearest;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+FrameReducer::FrameReducer() {
+    configure({Mode::Mean, 2});
+}
+
+void FrameReducer::configure(const Settings &settings) {
+    lock_guard<mutex> lock(m_mutex);
+    m_settings = settings;
+    m_settings.factor = settings.factor >= 4 ? 4 : 2;
+
+    auto factor = m_settings.factor;
+    float center = (factor - 1) * 0.5f;
+    auto distance = [&](uint32_t k) {
+        float dx = k % factor - center;
+        float dy = k / factor - center;
+        return dx * dx + dy * dy;
+    };
+    iota(m_blockOrder, m_blockOrder + factor * factor, 0u);
+    stable_sort(m_blockOrder, m_blockOrder + factor * factor,
+                [&](uint32_t a, uint32_t b) { return distance(a) > distance(b); });
+}
+
+uint32_t FrameReducer::apply(const Frame &frame, Frame &reduced, RowBandPool &pool) {
+    lock_guard<mutex> lock(m_mutex);
+    auto factor = m_settings.factor;
+    reduced.resize(frame.width() / factor, frame.height() / factor);
+    reduced.setRegion(frame.xOffset() / factor, frame.yOffset() / factor, frame.fullWidth() / factor,
+                      frame.fullHeight() / factor);
+    reduced.header = frame.header;
+    reduced.setCloudFields(frame.cloudFields());
+
+    pool.run(reduced.height(), [&](uint32_t firstRow, uint32_t endRow) {
+        reduceRows(frame, reduced, firstRow, endRow);
+    });
+
+    if (frame.hasGray() && frame.hasIntensityField()) {
+        reduceGray(frame, reduced);
+    }
+    return factor;
+}
+
+void FrameReducer::reduceRows(const Frame &frame, Frame &reduced, uint32_t firstRow, uint32_t endRow) {
+    auto factor = m_settings.factor;
+    for (auto row = firstRow; row < endRow; ++row) {
+        const float *in = frame.xyzc() + 4 * size_t(row) * factor * frame.width();
+        float *out = reduced.xyzc() + 4 * size_t(row) * reduced.width();
+        if (factor == 4) {
+            reduceRow<4>(m_settings.mode, in, frame.width(), out, reduced.width(), m_blockOrder);
+        } else {
+            reduceRow<2>(m_settings.mode, in, frame.width(), out, reduced.width(), m_blockOrder);
+        }
+    }
+}
+
+void FrameReducer::reduceGray(const Frame &frame, Frame &reduced) {
+    auto factor = m_settings.factor;
+    m_gray.resize(reduced.numPoints());
+    for (auto row = 0u; row < reduced.height(); ++row) {
+        for (auto col = 0u; col < reduced.width(); ++col) {
+            uint32_t sum = 0;
+            for (auto by = 0u; by < factor; ++by) {
+                const uint8_t *block = frame.gray() + (size_t(row) * factor + by) * frame.width() + size_t(col) * factor;
+                for (auto bx = 0u; bx < factor; ++bx) {
+                    sum += block[bx];
+                }
+            }
+            m_gray[size_t(row) * reduced.width() + col] = static_cast<uint8_t>(sum / (factor * factor));
+        }
+    }
+    reduced.setGray(m_gray.data());
+}
+
+void FrameReducer::reduceCameraInfo(uint32_t factor, sensor_msgs::msg::CameraInfo &cameraInfo) {
+
+    // The blocks start at the origin of the region, so reduced pixel u of the region covers the pixels from
+    // x_offset + factor * u on, its center lies at x_offset + factor * u + (factor - 1) / 2. The region of the
+    // reduced image starts at x_offset / factor, rounded down, which leaves the remainder of the offset in the shift
+    // of the principal point.
+    double scale = factor;
+    double shiftX = cameraInfo.roi.x_offset % factor + (scale - 1.) * 0.5;
+    double shiftY = cameraInfo.roi.y_offset % factor + (scale - 1.) * 0.5;
+    cameraInfo.k[0] /= scale;
+    cameraInfo.k[2] = (cameraInfo.k[2] - shiftX) / scale;
+    cameraInfo.k[4] /= scale;
+    cameraInfo.k[5] = (cameraInfo.k[5] - shiftY) / scale;
+    cameraInfo.p[0] /= scale;
+    cameraInfo.p[2] = (cameraInfo.p[2] - shiftX) / scale;
+    cameraInfo.p[5] /= scale;
+    cameraInfo.p[6] = (cameraInfo.p[6] - shiftY) / scale;
+
+    cameraInfo.width /= factor;
+    cameraInfo.height /= factor;
+    cameraInfo.roi.x_offset /= factor;
+    cameraInfo.roi.y_offset /= factor;
+    cameraInfo.roi.width /= factor;
+    cameraInfo.roi.height /= factor;
+}
+
+} // namespace pmd_royale_ros_driver
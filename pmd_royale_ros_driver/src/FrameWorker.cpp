@@ -0,0 +1,58 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <FrameWorker.hpp>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+FrameWorker::FrameWorker(Handler handler) : m_handler(std::move(handler)), m_pendingOutputs(0), m_stop(false) {
+    m_thread = thread(&FrameWorker::run, this);
+}
+
+FrameWorker::~FrameWorker() {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+}
+
+unique_ptr<Frame> FrameWorker::post(unique_ptr<Frame> frame, uint32_t throttledOutputs) {
+    unique_ptr<Frame> dropped;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        dropped = std::move(m_pending);
+        m_pending = std::move(frame);
+        m_pendingOutputs = (dropped ? m_pendingOutputs : 0) | throttledOutputs;
+    }
+    m_condition.notify_one();
+    return dropped;
+}
+
+void FrameWorker::run() {
+    unique_lock<mutex> lock(m_mutex);
+    while (true) {
+        m_condition.wait(lock, [this] { return m_stop || m_pending; });
+        if (m_stop) {
+            break;
+        }
+        auto frame = std::move(m_pending);
+        auto throttledOutputs = m_pendingOutputs;
+        m_pendingOutputs = 0;
+        lock.unlock();
+        m_handler(std::move(frame), throttledOutputs);
+        lock.lock();
+    }
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,69 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <GrayPairing.hpp>
+
+#include "FrameConversions.hpp"
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+GrayPairing::GrayPairing() : m_grayTimestamp(0), m_heldTimestamp(0) {}
+
+GrayPairing::Result GrayPairing::addFrame(unique_ptr<Frame> frame, uint64_t timestamp, uint32_t throttledOutputs,
+                                          bool needsGray) {
+    lock_guard<mutex> lock(m_mutex);
+    Result result;
+
+    // The gray image of the held frame would have come before the next capture
+    result.withoutGray = std::move(m_held);
+    m_held = Handoff();
+
+    if (attachGray(*frame, timestamp) || !needsGray) {
+        result.complete = Handoff{std::move(frame), throttledOutputs};
+    } else {
+        m_held = Handoff{std::move(frame), throttledOutputs};
+        m_heldTimestamp = timestamp;
+    }
+    return result;
+}
+
+GrayPairing::Result GrayPairing::addGray(const uint8_t *gray, uint32_t width,
+                                         const sensor_msgs::msg::RegionOfInterest &roi, uint64_t timestamp) {
+    lock_guard<mutex> lock(m_mutex);
+    // Resizing keeps the capacity, so this only allocates for the first image or a larger region
+    m_gray.resize(size_t(roi.width) * roi.height);
+    copyGrayRoi(gray, width, roi, m_gray.data());
+    m_grayTimestamp = timestamp;
+
+    // A gray image of an earlier capture leaves the held frame waiting, one of a later capture means that the gray
+    // image of the held frame was lost
+    Result result;
+    if (m_held.frame && timestamp >= m_heldTimestamp) {
+        if (attachGray(*m_held.frame, m_heldTimestamp)) {
+            result.complete = std::move(m_held);
+        } else {
+            result.withoutGray = std::move(m_held);
+        }
+        m_held = Handoff();
+    }
+    return result;
+}
+
+bool GrayPairing::attachGray(Frame &frame, uint64_t timestamp) const {
+    if (m_grayTimestamp != timestamp || m_gray.size() != frame.numPoints()) {
+        return false;
+    }
+    frame.setGray(m_gray.data());
+    return true;
+}
+
+} // namespace pmd_royale_ros_driver
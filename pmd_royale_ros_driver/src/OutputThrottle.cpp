@@ -0,0 +1,111 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <OutputThrottle.hpp>
+
+#include <cstdlib>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+// Parse a positive number which takes up the whole string
+bool parseNumber(const string &text, double &value) {
+    if (text.empty()) {
+        return false;
+    }
+    char *end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && value > 0.;
+}
+
+bool endsWith(const string &text, const string &suffix) {
+    return text.size() > suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+} // namespace
+
+bool OutputThrottle::parse(const string &description, Settings &settings) {
+    auto slash = description.find('/');
+    auto colon = description.find(':');
+    if (slash == string::npos || colon == string::npos || colon < slash) {
+        return false;
+    }
+
+    auto output = description.substr(0, slash);
+    if (output == "point_cloud") {
+        settings.output = Output::PointCloud;
+    } else if (output == "depth_image") {
+        settings.output = Output::DepthImage;
+    } else {
+        return false;
+    }
+
+    // The other sub-topics of the stream outputs are taken
+    settings.name = description.substr(slash + 1, colon - slash - 1);
+    if (settings.name.empty() || settings.name.find_first_of("/:") != string::npos || settings.name == "reduced" ||
+        settings.name == "shm") {
+        return false;
+    }
+
+    auto policy = description.substr(colon + 1);
+    settings.isReduced = endsWith(policy, ":reduced");
+    if (settings.isReduced) {
+        policy.resize(policy.size() - 8);
+    }
+
+    double value = 0.;
+    if (endsWith(policy, "hz") && parseNumber(policy.substr(0, policy.size() - 2), value)) {
+        settings.policy = Policy::Rate;
+        settings.rate = value;
+        settings.every = 1;
+    } else if (policy.compare(0, 6, "every_") == 0 && parseNumber(policy.substr(6), value) && value == uint32_t(value)) {
+        settings.policy = Policy::EveryNth;
+        settings.rate = 0.;
+        settings.every = uint32_t(value);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+OutputThrottle::OutputThrottle(const Settings &settings)
+    : m_settings(settings),
+      m_periodNs(settings.policy == Policy::Rate ? int64_t(1e9 / settings.rate) : 0),
+      m_nextNs(0),
+      m_frameCount(0) {}
+
+string OutputThrottle::topic(uint32_t streamIdx) const {
+    auto output = m_settings.output == Output::PointCloud ? "point_cloud_" : "depth_image_";
+    return output + to_string(streamIdx) + "/" + m_settings.name;
+}
+
+bool OutputThrottle::nextFrame(int64_t stampNs) {
+    if (m_settings.policy == Policy::EveryNth) {
+        bool isDue = m_frameCount == 0;
+        m_frameCount = (m_frameCount + 1) % m_settings.every;
+        return isDue;
+    }
+
+    // A frame up to a quarter period early is taken, so jitter of the stamps doesn't skip the frame which is due.
+    // The next stamp is advanced by the period to keep the rate, unless the stamps jumped, e.g. after a gap in the
+    // capture or when a recording starts over.
+    if (stampNs < m_nextNs - m_periodNs / 4 && stampNs > m_nextNs - 2 * m_periodNs) {
+        return false;
+    }
+    if (stampNs - m_nextNs >= m_periodNs || stampNs < m_nextNs - m_periodNs) {
+        m_nextNs = stampNs + m_periodNs;
+    } else {
+        m_nextNs += m_periodNs;
+    }
+    return true;
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,45 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <PointTransform.hpp>
+
+namespace pmd_royale_ros_driver {
+
+PointTransform transformMatrix(const geometry_msgs::msg::Transform &transform) {
+    double x = transform.rotation.x;
+    double y = transform.rotation.y;
+    double z = transform.rotation.z;
+    double w = transform.rotation.w;
+    return {static_cast<float>(1. - 2. * (y * y + z * z)), static_cast<float>(2. * (x * y - z * w)),
+            static_cast<float>(2. * (x * z + y * w)), static_cast<float>(transform.translation.x),
+            static_cast<float>(2. * (x * y + z * w)), static_cast<float>(1. - 2. * (x * x + z * z)),
+            static_cast<float>(2. * (y * z - x * w)), static_cast<float>(transform.translation.y),
+            static_cast<float>(2. * (x * z - y * w)), static_cast<float>(2. * (y * z + x * w)),
+            static_cast<float>(1. - 2. * (x * x + y * y)), static_cast<float>(transform.translation.z)};
+}
+
+void transformPoints(const float *in, float *out, size_t numPoints, const PointTransform &m) {
+    for (size_t i = 0; i < numPoints; ++i) {
+        const float *src = in + 4 * i;
+        float *dst = out + 4 * i;
+        // Read completely before writing, so in and out may alias
+        float x = src[0];
+        float y = src[1];
+        float z = src[2];
+        float conf = src[3];
+        float valid = conf > 0.f ? 1.f : 0.f;
+        dst[0] = valid * (m[0] * x + m[1] * y + m[2] * z + m[3]);
+        dst[1] = valid * (m[4] * x + m[5] * y + m[6] * z + m[7]);
+        dst[2] = valid * (m[8] * x + m[9] * y + m[10] * z + m[11]);
+        dst[3] = conf;
+    }
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,100 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <RowBandPool.hpp>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+// Bands per thread, a few more than one evens out threads which start late
+const uint32_t BANDS_PER_THREAD = 4;
+} // namespace
+
+RowBandPool::RowBandPool(uint32_t numThreads)
+    : m_stop(false),
+      m_generation(0),
+      m_busyThreads(0),
+      m_fn(nullptr),
+      m_numRows(0),
+      m_bandRows(0),
+      m_nextRow(0) {
+    for (auto i = 0u; i < numThreads; ++i) {
+        m_threads.emplace_back(&RowBandPool::worker, this);
+    }
+}
+
+RowBandPool::~RowBandPool() {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_startCondition.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void RowBandPool::run(uint32_t numRows, const BandFunction &fn) {
+    if (m_threads.empty() || numRows < 2) {
+        fn(0, numRows);
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_fn = &fn;
+        m_numRows = numRows;
+        m_bandRows = max(1u, numRows / ((numThreads() + 1) * BANDS_PER_THREAD));
+        m_nextRow = 0;
+        m_busyThreads = numThreads();
+        m_generation++;
+    }
+    m_startCondition.notify_all();
+
+    processBands();
+
+    unique_lock<mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this] { return m_busyThreads == 0; });
+    m_fn = nullptr;
+}
+
+void RowBandPool::worker() {
+    uint64_t generation = 0;
+    unique_lock<mutex> lock(m_mutex);
+    while (true) {
+        m_startCondition.wait(lock, [&] { return m_stop || m_generation != generation; });
+        if (m_stop) {
+            break;
+        }
+        generation = m_generation;
+        lock.unlock();
+        processBands();
+        lock.lock();
+        if (--m_busyThreads == 0) {
+            m_doneCondition.notify_one();
+        }
+    }
+}
+
+void RowBandPool::processBands() {
+    while (true) {
+        auto firstRow = m_nextRow.fetch_add(m_bandRows);
+        if (firstRow >= m_numRows) {
+            break;
+        }
+        (*m_fn)(firstRow, min(firstRow + m_bandRows, m_numRows));
+    }
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,119 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <ShmFrameRingWriter.hpp>
+
+#include <cstring>
+#include <new>
+
+namespace pmd_royale_ros_driver {
+
+ShmFrameRingWriter::ShmFrameRingWriter() : m_base(nullptr), m_size(0), m_sequence(0) {}
+
+ShmFrameRingWriter::~ShmFrameRingWriter() {
+    destroy();
+}
+
+bool ShmFrameRingWriter::create(const std::string &name, uint32_t slotCount, uint32_t maxPoints) {
+    destroy();
+
+    uint32_t payloadSize = shmAlign(maxPoints * (4 * sizeof(float) + 1));
+    uint32_t slotStride = shmAlign(sizeof(ShmSlotHeader)) + payloadSize;
+    size_t size = shmAlign(sizeof(ShmRingHeader)) + static_cast<size_t>(slotCount) * slotStride;
+
+    // Readers which still map an old ring keep their mapping, new readers get the new object
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (::ftruncate(fd, size) != 0) {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+    void *base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    m_name = name;
+    m_base = static_cast<uint8_t *>(base);
+    m_size = size;
+    m_sequence = 0;
+
+    auto ringHeader = new (m_base) ShmRingHeader;
+    ringHeader->slotCount = slotCount;
+    ringHeader->slotStride = slotStride;
+    ringHeader->payloadSize = payloadSize;
+    ringHeader->reserved = 0;
+    ringHeader->lastSequence.store(0, std::memory_order_relaxed);
+    for (auto i = 0u; i < slotCount; ++i) {
+        auto slot = new (slotHeader(i)) ShmSlotHeader;
+        slot->lock.store(0, std::memory_order_relaxed);
+        slot->sequence = 0;
+    }
+    ringHeader->version = SHM_RING_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    ringHeader->magic = SHM_RING_MAGIC;
+
+    return true;
+}
+
+void ShmFrameRingWriter::destroy() {
+    if (m_base) {
+        ::munmap(m_base, m_size);
+        ::shm_unlink(m_name.c_str());
+        m_base = nullptr;
+        m_size = 0;
+    }
+}
+
+uint64_t ShmFrameRingWriter::write(const Frame &frame) {
+    size_t xyzcSize = 4 * sizeof(float) * frame.numPoints();
+    size_t graySize = frame.hasGray() ? frame.numPoints() : 0;
+    if (!m_base || xyzcSize + graySize > header()->payloadSize) {
+        return 0;
+    }
+
+    auto sequence = ++m_sequence;
+    auto slot = slotHeader(sequence % header()->slotCount);
+    auto lock = slot->lock.load(std::memory_order_relaxed);
+    slot->lock.store(lock + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->sequence = sequence;
+    slot->stamp = static_cast<int64_t>(frame.header.stamp.sec) * 1000000000 + frame.header.stamp.nanosec;
+    slot->width = frame.width();
+    slot->height = frame.height();
+    slot->hasGray = graySize > 0;
+    uint8_t *payload = reinterpret_cast<uint8_t *>(slot) + shmAlign(sizeof(ShmSlotHeader));
+    ::memcpy(payload, frame.xyzc(), xyzcSize);
+    if (graySize) {
+        ::memcpy(payload + xyzcSize, frame.gray(), graySize);
+    }
+
+    slot->lock.store(lock + 2, std::memory_order_release);
+    header()->lastSequence.store(sequence, std::memory_order_release);
+    return sequence;
+}
+
+ShmRingHeader *ShmFrameRingWriter::header() {
+    return reinterpret_cast<ShmRingHeader *>(m_base);
+}
+
+ShmSlotHeader *ShmFrameRingWriter::slotHeader(uint32_t idx) {
+    return reinterpret_cast<ShmSlotHeader *>(m_base + shmAlign(sizeof(ShmRingHeader)) +
+                                             static_cast<size_t>(idx) * header()->slotStride);
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,149 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <StreamDiagnostics.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+namespace {
+// Accepted deviation of the measured frame rate from the nominal one
+const double FPS_TOLERANCE = 0.1;
+// A device timestamp difference above this many frame periods counts as a gap
+const double GAP_THRESHOLD = 1.5;
+
+double toMilliseconds(chrono::steady_clock::duration duration) {
+    return chrono::duration<double, milli>(duration).count();
+}
+} // namespace
+
+StreamDiagnostics::StreamDiagnostics(const std::string &name)
+    : DiagnosticTask(name),
+      m_nominalFps(0.),
+      m_active(false),
+      m_frameCount(0),
+      m_lastDeviceTimestamp(0),
+      m_timestampGaps(0),
+      m_missedFrames(0),
+      m_droppedFrames(0),
+      m_framesWithoutGray(0),
+      m_processingTimeSum(0),
+      m_processingTimeMax(0),
+      m_processingTimeCount(0),
+      m_conversionTimeSum(0),
+      m_conversionTimeMax(0),
+      m_conversionTimeCount(0),
+      m_windowIdx(0),
+      m_windowFill(0) {}
+
+void StreamDiagnostics::setNominalFps(double fps) {
+    lock_guard<mutex> lock(m_mutex);
+    m_nominalFps = fps;
+    m_lastDeviceTimestamp = 0;
+}
+
+void StreamDiagnostics::setActive(bool active) {
+    lock_guard<mutex> lock(m_mutex);
+    if (active != m_active) {
+        // Don't let the idle time count into the frame rate
+        m_active = active;
+        m_windowFill = 0;
+        m_lastDeviceTimestamp = 0;
+    }
+}
+
+void StreamDiagnostics::onFrame(uint64_t deviceTimestampUs, chrono::steady_clock::duration processingTime) {
+    lock_guard<mutex> lock(m_mutex);
+    m_frameCount++;
+
+    if (m_lastDeviceTimestamp != 0 && m_nominalFps > 0. && deviceTimestampUs > m_lastDeviceTimestamp) {
+        double periods = (deviceTimestampUs - m_lastDeviceTimestamp) * m_nominalFps * 1e-6;
+        if (periods > GAP_THRESHOLD) {
+            m_timestampGaps++;
+            m_missedFrames += static_cast<uint64_t>(llround(periods)) - 1;
+        }
+    }
+    m_lastDeviceTimestamp = deviceTimestampUs;
+
+    m_processingTimeSum += processingTime;
+    m_processingTimeMax = max(m_processingTimeMax, processingTime);
+    m_processingTimeCount++;
+}
+
+void StreamDiagnostics::onFrameDropped() {
+    lock_guard<mutex> lock(m_mutex);
+    m_droppedFrames++;
+}
+
+void StreamDiagnostics::onFrameWithoutGray() {
+    lock_guard<mutex> lock(m_mutex);
+    m_framesWithoutGray++;
+}
+
+void StreamDiagnostics::onFrameConverted(chrono::steady_clock::duration conversionTime) {
+    lock_guard<mutex> lock(m_mutex);
+    m_conversionTimeSum += conversionTime;
+    m_conversionTimeMax = max(m_conversionTimeMax, conversionTime);
+    m_conversionTimeCount++;
+}
+
+void StreamDiagnostics::run(diagnostic_updater::DiagnosticStatusWrapper &stat) {
+    lock_guard<mutex> lock(m_mutex);
+
+    auto now = chrono::steady_clock::now();
+    m_windowTimes[m_windowIdx] = now;
+    m_windowCounts[m_windowIdx] = m_frameCount;
+    m_windowFill = min(m_windowFill + 1, WINDOW_SIZE);
+    auto oldestIdx = m_windowFill < WINDOW_SIZE ? 0 : (m_windowIdx + 1) % WINDOW_SIZE;
+    double elapsed = chrono::duration<double>(now - m_windowTimes[oldestIdx]).count();
+    double fps = elapsed > 0. ? (m_frameCount - m_windowCounts[oldestIdx]) / elapsed : 0.;
+    m_windowIdx = (m_windowIdx + 1) % WINDOW_SIZE;
+
+    if (!m_active) {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Idle, no subscribers");
+    } else if (elapsed <= 0.) {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Collecting statistics");
+    } else if (fps == 0.) {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::ERROR, "No frames received");
+    } else if (m_nominalFps > 0. && fabs(fps - m_nominalFps) > FPS_TOLERANCE * m_nominalFps) {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Frame rate differs from usecase");
+    } else {
+        stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "Frame rate ok");
+    }
+
+    stat.add("Frame rate (Hz)", fps);
+    stat.add("Nominal frame rate (Hz)", m_nominalFps);
+    stat.add("Frames", m_frameCount);
+    stat.add("Timestamp gaps", m_timestampGaps);
+    stat.add("Missed frames", m_missedFrames);
+    stat.add("Dropped frames", m_droppedFrames);
+    stat.add("Clouds without intensity", m_framesWithoutGray);
+    if (m_processingTimeCount > 0) {
+        stat.add("Processing time mean (ms)", toMilliseconds(m_processingTimeSum) / m_processingTimeCount);
+        stat.add("Processing time max (ms)", toMilliseconds(m_processingTimeMax));
+    }
+    if (m_conversionTimeCount > 0) {
+        stat.add("Conversion time mean (ms)", toMilliseconds(m_conversionTimeSum) / m_conversionTimeCount);
+        stat.add("Conversion time max (ms)", toMilliseconds(m_conversionTimeMax));
+    }
+
+    m_processingTimeSum = chrono::steady_clock::duration(0);
+    m_processingTimeMax = chrono::steady_clock::duration(0);
+    m_processingTimeCount = 0;
+    m_conversionTimeSum = chrono::steady_clock::duration(0);
+    m_conversionTimeMax = chrono::steady_clock::duration(0);
+    m_conversionTimeCount = 0;
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,191 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <TemporalFilter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+bool TemporalFilter::parseMode(const std::string &name, Mode &mode) {
+    if (name == "off") {
+        mode = Mode::Off;
+    } else if (name == "mean") {
+        mode = Mode::Mean;
+    } else if (name == "median") {
+        mode = Mode::Median;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+TemporalFilter::TemporalFilter() : m_settings{Mode::Off, 4, 0.05f}, m_width(0), m_height(0), m_head(0), m_fill(0) {}
+
+void TemporalFilter::configure(const Settings &settings) {
+    lock_guard<mutex> lock(m_mutex);
+    if (settings.mode != m_settings.mode || settings.numFrames != m_settings.numFrames) {
+        m_fill = 0;
+    }
+    m_settings = settings;
+    m_settings.numFrames = min(max(m_settings.numFrames, 1u), MAX_FRAMES);
+}
+
+void TemporalFilter::apply(Frame &frame, RowBandPool &pool) {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_settings.mode == Mode::Off) {
+        m_fill = 0;
+        return;
+    }
+
+    auto numPoints = frame.numPoints();
+    auto numFrames = m_settings.numFrames;
+    if (frame.width() != m_width || frame.height() != m_height || m_depth.size() != size_t(numFrames) * numPoints) {
+        m_width = frame.width();
+        m_height = frame.height();
+        m_depth.assign(size_t(numFrames) * numPoints, 0.f);
+        m_confidence.assign(size_t(numFrames) * numPoints, 0.f);
+        m_sum.resize(numPoints);
+        m_weightedSum.resize(numPoints);
+        m_rank.resize(numPoints);
+        m_values.resize(size_t(numFrames) * numPoints);
+        m_fill = 0;
+    }
+    m_head = (m_head + 1) % numFrames;
+    m_fill = min(m_fill + 1, numFrames);
+
+    pool.run(m_height, [&](uint32_t firstRow, uint32_t endRow) {
+        auto begin = firstRow * m_width;
+        auto end = endRow * m_width;
+
+        // Deinterleave the new frame into the head of the ring
+        const float *xyzc = frame.xyzc();
+        float *depth = m_depth.data() + size_t(m_head) * numPoints;
+        float *confidence = m_confidence.data() + size_t(m_head) * numPoints;
+        for (auto i = begin; i < end; ++i) {
+            depth[i] = xyzc[4 * i + 2];
+            confidence[i] = xyzc[4 * i + 3];
+        }
+
+        if (m_settings.mode == Mode::Mean) {
+            filterMean(frame, begin, end);
+        } else {
+            filterMedian(frame, begin, end);
+        }
+    });
+}
+
+const float *TemporalFilter::depthPlane(uint32_t age) const {
+    auto numFrames = m_settings.numFrames;
+    return m_depth.data() + size_t((m_head + numFrames - age) % numFrames) * m_width * m_height;
+}
+
+const float *TemporalFilter::confidencePlane(uint32_t age) const {
+    auto numFrames = m_settings.numFrames;
+    return m_confidence.data() + size_t((m_head + numFrames - age) % numFrames) * m_width * m_height;
+}
+
+void TemporalFilter::filterMean(Frame &frame, uint32_t begin, uint32_t end) {
+    const float *depth0 = depthPlane(0);
+    const float resetDistance = m_settings.resetDistance;
+    float *sumWeights = m_sum.data();
+    float *sumDepths = m_weightedSum.data();
+
+    for (auto i = begin; i < end; ++i) {
+        sumWeights[i] = 0.f;
+        sumDepths[i] = 0.f;
+    }
+
+    for (auto age = 0u; age < m_fill; ++age) {
+        const float *depth = depthPlane(age);
+        const float *confidence = confidencePlane(age);
+        for (auto i = begin; i < end; ++i) {
+            bool use = confidence[i] > 0.f && fabsf(depth[i] - depth0[i]) <= resetDistance;
+            float weight = use ? confidence[i] : 0.f;
+            sumWeights[i] += weight;
+            sumDepths[i] += weight * depth[i];
+        }
+    }
+
+    float *xyzc = frame.xyzc();
+    for (auto i = begin; i < end; ++i) {
+        // The current sample always counts for valid pixels, so sumWeights is only 0 for invalid ones
+        float filtered = sumWeights[i] > 0.f ? sumDepths[i] / sumWeights[i] : depth0[i];
+        float scale = depth0[i] > 0.f ? filtered / depth0[i] : 1.f;
+        xyzc[4 * i] *= scale;
+        xyzc[4 * i + 1] *= scale;
+        xyzc[4 * i + 2] *= scale;
+    }
+}
+
+void TemporalFilter::filterMedian(Frame &frame, uint32_t begin, uint32_t end) {
+    const float *depth0 = depthPlane(0);
+    const float resetDistance = m_settings.resetDistance;
+    const float invalid = numeric_limits<float>::max();
+    const size_t numPoints = size_t(m_width) * m_height;
+    float *numValid = m_sum.data();
+    float *median = m_weightedSum.data();
+    float *rank = m_rank.data();
+
+    // Samples which are not used get a value which sorts behind all others
+    for (auto i = begin; i < end; ++i) {
+        numValid[i] = 0.f;
+        median[i] = depth0[i];
+    }
+    for (auto age = 0u; age < m_fill; ++age) {
+        const float *depth = depthPlane(age);
+        const float *confidence = confidencePlane(age);
+        float *values = m_values.data() + age * numPoints;
+        for (auto i = begin; i < end; ++i) {
+            bool use = confidence[i] > 0.f && fabsf(depth[i] - depth0[i]) <= resetDistance;
+            values[i] = use ? depth[i] : invalid;
+            numValid[i] += use ? 1.f : 0.f;
+        }
+    }
+
+    // Branch free selection: the median is the sample with (numValid - 1) / 2 smaller samples before it. Ties are
+    // broken by age, so exactly one sample matches.
+    for (auto candidate = 0u; candidate < m_fill; ++candidate) {
+        const float *candidateValues = m_values.data() + candidate * numPoints;
+        for (auto i = begin; i < end; ++i) {
+            rank[i] = 0.f;
+        }
+        for (auto age = 0u; age < m_fill; ++age) {
+            const float *values = m_values.data() + age * numPoints;
+            if (age < candidate) {
+                for (auto i = begin; i < end; ++i) {
+                    rank[i] += values[i] <= candidateValues[i] ? 1.f : 0.f;
+                }
+            } else if (age > candidate) {
+                for (auto i = begin; i < end; ++i) {
+                    rank[i] += values[i] < candidateValues[i] ? 1.f : 0.f;
+                }
+            }
+        }
+        for (auto i = begin; i < end; ++i) {
+            bool isMedian = candidateValues[i] < invalid && rank[i] == floorf((numValid[i] - 1.f) * 0.5f);
+            median[i] = isMedian ? candidateValues[i] : median[i];
+        }
+    }
+
+    float *xyzc = frame.xyzc();
+    for (auto i = begin; i < end; ++i) {
+        float scale = depth0[i] > 0.f ? median[i] / depth0[i] : 1.f;
+        xyzc[4 * i] *= scale;
+        xyzc[4 * i + 1] *= scale;
+        xyzc[4 * i + 2] *= scale;
+    }
+}
+
+} // namespace pmd_royale_ros_driver
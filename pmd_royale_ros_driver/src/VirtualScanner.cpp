@@ -0,0 +1,112 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <VirtualScanner.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace pmd_royale_ros_driver {
+
+VirtualScanner::VirtualScanner()
+    : m_settings{-0.1f, 0.1f, 0.1f, 6.f},
+      m_fx(0.),
+      m_cx(0.),
+      m_width(0),
+      m_xOffset(0),
+      m_angleMin(0.f),
+      m_angleIncrement(0.f) {}
+
+void VirtualScanner::configure(const Settings &settings) {
+    lock_guard<mutex> lock(m_mutex);
+    m_settings = settings;
+}
+
+void VirtualScanner::setIntrinsics(double fx, double cx) {
+    lock_guard<mutex> lock(m_mutex);
+    if (fx != m_fx || cx != m_cx) {
+        m_fx = fx;
+        m_cx = cx;
+        m_width = 0;
+    }
+}
+
+void VirtualScanner::updateTables(uint32_t width, uint32_t xOffset) {
+    m_width = width;
+    m_xOffset = xOffset;
+    m_columnBin.resize(width);
+    m_columnMin.resize(width);
+    m_columnRange.resize(width);
+
+    // Column 0 looks to the left, which is the largest angle of a scan with z up
+    auto columnAngle = [this](uint32_t col) { return static_cast<float>(atan2(m_cx - m_xOffset - col, m_fx)); };
+    float angleMax = columnAngle(0);
+    m_angleMin = columnAngle(width - 1);
+    m_angleIncrement = width > 1 ? (angleMax - m_angleMin) / (width - 1) : 0.f;
+
+    for (auto col = 0u; col < width; ++col) {
+        float bin = m_angleIncrement > 0.f ? (columnAngle(col) - m_angleMin) / m_angleIncrement : 0.f;
+        m_columnBin[col] = min(static_cast<uint32_t>(lroundf(bin)), width - 1);
+    }
+}
+
+void VirtualScanner::apply(const Frame &frame, sensor_msgs::msg::LaserScan &scan) {
+    lock_guard<mutex> lock(m_mutex);
+    auto width = frame.width();
+    if (width != m_width || frame.xOffset() != m_xOffset) {
+        updateTables(width, frame.xOffset());
+    }
+
+    const float inf = numeric_limits<float>::infinity();
+    const float minHeight = m_settings.minHeight;
+    const float maxHeight = m_settings.maxHeight;
+    const float rangeMinSq = m_settings.rangeMin * m_settings.rangeMin;
+    float *columnMin = m_columnMin.data();
+    float *columnRange = m_columnRange.data();
+
+    // Minimum of the squared horizontal distance per column, the root is only taken once per column
+    for (auto col = 0u; col < width; ++col) {
+        columnMin[col] = inf;
+    }
+    for (auto row = 0u; row < frame.height(); ++row) {
+        const float *xyzc = frame.xyzc() + 4 * size_t(row) * width;
+        for (auto col = 0u; col < width; ++col) {
+            float x = xyzc[4 * col];
+            float height = -xyzc[4 * col + 1];
+            float z = xyzc[4 * col + 2];
+            float rangeSq = x * x + z * z;
+            bool use = xyzc[4 * col + 3] > 0.f && height >= minHeight && height <= maxHeight && rangeSq >= rangeMinSq;
+            columnRange[col] = use ? rangeSq : inf;
+        }
+        for (auto col = 0u; col < width; ++col) {
+            columnMin[col] = min(columnMin[col], columnRange[col]);
+        }
+    }
+
+    scan.angle_min = m_angleMin;
+    scan.angle_max = m_angleMin + m_angleIncrement * (width - 1);
+    scan.angle_increment = m_angleIncrement;
+    scan.time_increment = 0.f;
+    scan.range_min = m_settings.rangeMin;
+    scan.range_max = m_settings.rangeMax;
+    scan.ranges.assign(width, inf);
+    scan.intensities.clear();
+
+    for (auto col = 0u; col < width; ++col) {
+        float range = sqrtf(columnMin[col]);
+        auto &binRange = scan.ranges[m_columnBin[col]];
+        binRange = range <= m_settings.rangeMax ? min(binRange, range) : binRange;
+    }
+}
+
+} // namespace pmd_royale_ros_driver
@@ -0,0 +1,123 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <CloudCodec.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace pmd_royale_ros_driver;
+
+namespace {
+// Organized cloud of a tilted wall with a box in front of it, so the predictor sees planes and depth edges, plus
+// noise. Every 7th pixel and a band along the left border are invalid, with leftover coordinates like the ones of
+// flying pixels.
+std::vector<float> makeCloud(uint32_t width, uint32_t height) {
+    std::mt19937 random(width);
+    std::normal_distribution<float> noise(0.f, 0.002f);
+    std::vector<float> xyzc(size_t(4) * width * height);
+    for (auto y = 0u; y < height; ++y) {
+        for (auto x = 0u; x < width; ++x) {
+            float *point = xyzc.data() + 4 * (size_t(y) * width + x);
+            bool isBox = x > width / 3 && x < width / 2 && y > height / 4 && y < height / 2;
+            float z = (isBox ? 0.8f : 2.f + 0.002f * x) + noise(random);
+            point[0] = (float(x) - width / 2.f) / width * z;
+            point[1] = (float(y) - height / 2.f) / width * z;
+            point[2] = z;
+            point[3] = 100.f + float((x + y) % 150);
+            if ((size_t(y) * width + x) % 7 == 0 || x < 5) {
+                point[0] = 0.3f;
+                point[1] = -0.1f;
+                point[3] = 0.f;
+            }
+        }
+    }
+    return xyzc;
+}
+
+void expectRoundTrip(uint32_t width, uint32_t height, float precision) {
+    auto xyzc = makeCloud(width, height);
+    CloudCodec codec;
+    std::vector<uint8_t> data;
+    codec.encode(xyzc.data(), width, height, precision, data);
+    EXPECT_LT(data.size(), xyzc.size() * sizeof(float) / 2);
+
+    std::vector<float> decoded;
+    uint32_t decodedWidth = 0;
+    uint32_t decodedHeight = 0;
+    ASSERT_TRUE(CloudCodec().decode(data.data(), data.size(), decoded, decodedWidth, decodedHeight));
+    ASSERT_EQ(decodedWidth, width);
+    ASSERT_EQ(decodedHeight, height);
+    ASSERT_EQ(decoded.size(), xyzc.size());
+
+    // The confidence is quantized to 8 bits of the largest one
+    float confidenceStep = 249.f / 255.f;
+    for (size_t i = 0; i < size_t(width) * height; ++i) {
+        const float *in = xyzc.data() + 4 * i;
+        const float *out = decoded.data() + 4 * i;
+        if (in[3] == 0.f) {
+            ASSERT_EQ(out[0], 0.f) << "pixel " << i;
+            ASSERT_EQ(out[1], 0.f) << "pixel " << i;
+            ASSERT_EQ(out[2], 0.f) << "pixel " << i;
+            ASSERT_EQ(out[3], 0.f) << "pixel " << i;
+            continue;
+        }
+        for (auto c = 0u; c < 3; ++c) {
+            // Some slack for the rounding of the float multiplications
+            ASSERT_NEAR(out[c], in[c], precision / 2 * 1.001f) << "pixel " << i << " channel " << c;
+        }
+        ASSERT_GT(out[3], 0.f) << "pixel " << i;
+        ASSERT_NEAR(out[3], in[3], confidenceStep / 2 * 1.001f) << "pixel " << i;
+    }
+}
+} // namespace
+
+TEST(CloudCodec, RoundTripFlexx2) {
+    expectRoundTrip(224, 172, 0.001f);
+}
+
+TEST(CloudCodec, RoundTripVga) {
+    expectRoundTrip(640, 480, 0.001f);
+}
+
+TEST(CloudCodec, RoundTripCoarsePrecision) {
+    expectRoundTrip(224, 172, 0.01f);
+}
+
+TEST(CloudCodec, ReusedCodecChangesWidth) {
+    CloudCodec codec;
+    std::vector<uint8_t> data;
+    std::vector<float> decoded;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    for (auto frameWidth : {640u, 224u, 640u}) {
+        auto xyzc = makeCloud(frameWidth, 8);
+        codec.encode(xyzc.data(), frameWidth, 8, 0.001f, data);
+        ASSERT_TRUE(codec.decode(data.data(), data.size(), decoded, width, height));
+        EXPECT_EQ(width, frameWidth);
+        EXPECT_NEAR(decoded[4 * (width + 5) + 2], xyzc[4 * (width + 5) + 2], 0.0005f);
+    }
+}
+
+TEST(CloudCodec, RejectsTruncatedData) {
+    auto xyzc = makeCloud(224, 172);
+    std::vector<uint8_t> data;
+    CloudCodec codec;
+    codec.encode(xyzc.data(), 224, 172, 0.001f, data);
+
+    std::vector<float> decoded;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    EXPECT_FALSE(codec.decode(data.data(), data.size() / 2, decoded, width, height));
+    EXPECT_FALSE(codec.decode(data.data(), sizeof(CloudCodecHeader) - 1, decoded, width, height));
+    data[0] ^= 0xff;
+    EXPECT_FALSE(codec.decode(data.data(), data.size(), decoded, width, height));
+}
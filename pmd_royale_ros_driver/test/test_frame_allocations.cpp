@@ -0,0 +1,142 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <FrameConversions.hpp>
+#include <FramePool.hpp>
+#include <PublishMessage.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace pmd_royale_ros_driver;
+
+// Every allocation of the test binary is counted, the tests compare the counts before and after the frame path.
+// The operators are not inlined, so the compiler doesn't pair the malloc and free with new and delete.
+namespace {
+std::atomic<size_t> allocationCount{0};
+std::atomic<size_t> largestAllocation{0};
+} // namespace
+
+[[gnu::noinline]] void *operator new(size_t size) {
+    allocationCount++;
+    auto largest = largestAllocation.load();
+    while (size > largest && !largestAllocation.compare_exchange_weak(largest, size)) {
+    }
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+constexpr uint32_t WIDTH = 224;
+constexpr uint32_t HEIGHT = 172;
+
+// Stands in for rclcpp::Publisher, the serialization of the middleware is not part of the measured path.
+// Messages which are handed over are dropped right away, like by a subscriber which is done with them.
+struct DroppingPublisher {
+    template <typename MessageT>
+    void publish(const MessageT &) {
+        ++published;
+    }
+
+    template <typename MessageT>
+    void publish(std::unique_ptr<MessageT> message) {
+        message.reset();
+        ++published;
+    }
+
+    uint32_t published = 0;
+};
+
+class FrameAllocations : public ::testing::Test {
+  protected:
+    FrameAllocations() : pool(4), xyzc(4 * WIDTH * HEIGHT, 1.f), gray(WIDTH * HEIGHT, 128), mask(WIDTH * HEIGHT, 1) {
+        roi.width = WIDTH;
+        roi.height = HEIGHT;
+        frameId = "royale_cam0_optical_frame";
+    }
+
+    // The path of a captured frame through the camera node: acquire and fill the frame, fill the depth image, pack
+    // and publish the cloud, and give the frame back
+    void processFrame(bool isIntraProcess) {
+        auto frame = pool.acquire();
+        frame->resize(WIDTH, HEIGHT);
+        frame->header.frame_id = frameId;
+        frame->setCloudFields(Frame::CloudFields::Xyzic);
+        copyRoi(xyzc.data(), WIDTH, roi, mask.data(), frame->xyzc());
+        frame->setGray(gray.data());
+
+        publishMessage(pubDepth, msgDepth, false,
+                       [&](sensor_msgs::msg::Image &msg) { fillDepthImage(*frame, msg); });
+        publishFrame(pubCloud, msgCloud, isIntraProcess, frame);
+        pool.release(std::move(frame));
+    }
+
+    // Allocations of count runs of the frame path, after it was warmed up
+    size_t countAllocations(bool isIntraProcess, uint32_t count) {
+        for (auto i = 0; i < 8; ++i) {
+            processFrame(isIntraProcess);
+        }
+        largestAllocation = 0;
+        auto before = allocationCount.load();
+        for (auto i = 0u; i < count; ++i) {
+            processFrame(isIntraProcess);
+        }
+        return allocationCount.load() - before;
+    }
+
+    FramePool pool;
+    std::vector<float> xyzc;
+    std::vector<uint8_t> gray;
+    std::vector<uint8_t> mask;
+    sensor_msgs::msg::RegionOfInterest roi;
+    std::string frameId;
+
+    sensor_msgs::msg::Image msgDepth;
+    sensor_msgs::msg::PointCloud2 msgCloud;
+    DroppingPublisher pubDepth;
+    DroppingPublisher pubCloud;
+};
+} // namespace
+
+TEST_F(FrameAllocations, ReusedMessagesDontAllocate) {
+    EXPECT_EQ(countAllocations(false, 100), 0u);
+    EXPECT_EQ(pubCloud.published, 108u);
+    EXPECT_EQ(msgCloud.data.size(), 5 * sizeof(float) * WIDTH * HEIGHT);
+}
+
+TEST_F(FrameAllocations, IntraProcessFramesRecyclePlanes) {
+    // Only the Frame object and its frame id are allocated per frame, the planes come back from the subscriber
+    EXPECT_LE(countAllocations(true, 100), 200u);
+    EXPECT_LT(largestAllocation.load(), size_t(WIDTH) * HEIGHT);
+}
+
+TEST(FramePool, RecyclesPlanesOfDroppedFrames) {
+    FramePool pool(2);
+    auto frame = pool.acquire();
+    frame->resize(WIDTH, HEIGHT);
+    const float *points = frame->xyzc();
+    frame.reset();
+
+    auto recycled = pool.acquire();
+    EXPECT_EQ(recycled->xyzc(), points);
+}
@@ -0,0 +1,477 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <DepthStatistics.hpp>
+#include <FlyingPixelFilter.hpp>
+#include <FrameConversions.hpp>
+#include <FrameReducer.hpp>
+#include <TemporalFilter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <random>
+
+#include <gtest/gtest.h>
+
+using namespace pmd_royale_ros_driver;
+
+// The kernels are checked against plain scalar loops, for the widths they are instantiated for and for an odd width
+// which takes the generic instantiation
+
+namespace {
+const uint32_t WIDTHS[] = {FLEXX2_WIDTH, FLEXX2_VGA_WIDTH, 227};
+const uint32_t HEIGHT = 12;
+
+// A scene of a few planes at different depths with noise, so there are depth edges, and some invalid pixels
+Frame makeFrame(uint32_t width, uint32_t height, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+    std::uniform_int_distribution<int> gray(0, 255);
+    Frame frame(width, height);
+    uint8_t *grayPlane = frame.initGray();
+    for (auto row = 0u; row < height; ++row) {
+        for (auto col = 0u; col < width; ++col) {
+            auto i = size_t(row) * width + col;
+            float z = (col / 17 + row / 5) % 3 + 1.f + noise(random);
+            bool isValid = (random() % 7) != 0;
+            float *point = frame.xyzc() + 4 * i;
+            point[0] = (col - width * 0.5f) * 0.004f * z;
+            point[1] = (row - height * 0.5f) * 0.004f * z;
+            point[2] = isValid ? z : 0.f;
+            point[3] = isValid ? 0.2f + (random() % 80) * 0.01f : 0.f;
+            grayPlane[i] = static_cast<uint8_t>(gray(random));
+        }
+    }
+    return frame;
+}
+
+std::vector<float> points(const Frame &frame) {
+    return std::vector<float>(frame.xyzc(), frame.xyzc() + 4 * frame.numPoints());
+}
+
+bool isValid(const float *point) {
+    return point[3] > 0.f && point[2] > 0.f;
+}
+
+sensor_msgs::msg::RegionOfInterest makeRoi(uint32_t xOffset, uint32_t yOffset, uint32_t width, uint32_t height) {
+    sensor_msgs::msg::RegionOfInterest roi;
+    roi.x_offset = xOffset;
+    roi.y_offset = yOffset;
+    roi.width = width;
+    roi.height = height;
+    return roi;
+}
+
+std::vector<float> referenceFlyingPixels(const Frame &frame, int radius, float maxDepthJump, float minAngle) {
+    const int width = static_cast<int>(frame.width());
+    const int height = static_cast<int>(frame.height());
+    float cosMinAngle = cosf(minAngle * static_cast<float>(M_PI) / 180.f);
+    float cosMinAngleSq = cosMinAngle * cosMinAngle;
+    auto result = points(frame);
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            const float *p = frame.xyzc() + 4 * (size_t(row) * width + col);
+            int suspicious = 0;
+            int neighbors = 0;
+            for (int dy = -radius; dy <= radius; ++dy) {
+                for (int dx = -radius; dx <= radius; ++dx) {
+                    int nrow = row + dy;
+                    int ncol = col + dx;
+                    if ((dx == 0 && dy == 0) || nrow < 0 || nrow >= height || ncol < 0 || ncol >= width) {
+                        continue;
+                    }
+                    const float *n = frame.xyzc() + 4 * (size_t(nrow) * width + ncol);
+                    if (!isValid(p) || !isValid(n)) {
+                        continue;
+                    }
+                    float vx = n[0] - p[0];
+                    float vy = n[1] - p[1];
+                    float vz = n[2] - p[2];
+                    float dot = vx * p[0] + vy * p[1] + vz * p[2];
+                    float lengthSq = vx * vx + vy * vy + vz * vz;
+                    float raySq = p[0] * p[0] + p[1] * p[1] + p[2] * p[2];
+                    neighbors++;
+                    if (fabsf(vz) > maxDepthJump * p[2] || dot * dot > cosMinAngleSq * lengthSq * raySq) {
+                        suspicious++;
+                    }
+                }
+            }
+            if (2 * suspicious > neighbors) {
+                std::fill_n(result.begin() + 4 * (size_t(row) * width + col), 4, 0.f);
+            }
+        }
+    }
+    return result;
+}
+
+// History of the depth and confidence, newest first
+using History = std::deque<std::vector<float>>;
+
+std::vector<float> referenceTemporal(const Frame &frame, const History &history, TemporalFilter::Mode mode,
+                                     float resetDistance) {
+    auto result = points(frame);
+    for (auto i = 0u; i < frame.numPoints(); ++i) {
+        float depth0 = history[0][2 * i];
+        float filtered = depth0;
+        if (mode == TemporalFilter::Mode::Mean) {
+            float sumWeights = 0.f;
+            float sumDepths = 0.f;
+            for (const auto &plane : history) {
+                float depth = plane[2 * i];
+                float confidence = plane[2 * i + 1];
+                if (confidence > 0.f && fabsf(depth - depth0) <= resetDistance) {
+                    sumWeights += confidence;
+                    sumDepths += confidence * depth;
+                }
+            }
+            filtered = sumWeights > 0.f ? sumDepths / sumWeights : depth0;
+        } else {
+            std::vector<float> samples;
+            for (const auto &plane : history) {
+                if (plane[2 * i + 1] > 0.f && fabsf(plane[2 * i] - depth0) <= resetDistance) {
+                    samples.push_back(plane[2 * i]);
+                }
+            }
+            std::sort(samples.begin(), samples.end());
+            filtered = samples.empty() ? depth0 : samples[(samples.size() - 1) / 2];
+        }
+        float scale = depth0 > 0.f ? filtered / depth0 : 1.f;
+        for (auto c = 0u; c < 3; ++c) {
+            result[4 * i + c] *= scale;
+        }
+    }
+    return result;
+}
+
+std::vector<float> referenceReduced(const Frame &frame, FrameReducer::Mode mode, uint32_t factor) {
+    auto width = frame.width() / factor;
+    auto height = frame.height() / factor;
+    float center = (factor - 1) * 0.5f;
+    std::vector<float> result(4 * size_t(width) * height, 0.f);
+    for (auto row = 0u; row < height; ++row) {
+        for (auto col = 0u; col < width; ++col) {
+            float *out = result.data() + 4 * (size_t(row) * width + col);
+            // The valid points of the block in the order of the block
+            std::vector<const float *> samples;
+            std::vector<float> distances;
+            for (auto by = 0u; by < factor; ++by) {
+                for (auto bx = 0u; bx < factor; ++bx) {
+                    const float *point =
+                        frame.xyzc() + 4 * ((size_t(row) * factor + by) * frame.width() + col * factor + bx);
+                    if (isValid(point)) {
+                        samples.push_back(point);
+                        distances.push_back((bx - center) * (bx - center) + (by - center) * (by - center));
+                    }
+                }
+            }
+            if (samples.empty()) {
+                continue;
+            }
+            if (mode == FrameReducer::Mode::Mean) {
+                float sum[4] = {0.f, 0.f, 0.f, 0.f};
+                for (const float *point : samples) {
+                    for (auto c = 0u; c < 4; ++c) {
+                        sum[c] += point[c];
+                    }
+                }
+                for (auto c = 0u; c < 4; ++c) {
+                    out[c] = sum[c] * (1.f / samples.size());
+                }
+            } else if (mode == FrameReducer::Mode::Median) {
+                auto sorted = samples;
+                std::stable_sort(sorted.begin(), sorted.end(),
+                                 [](const float *a, const float *b) { return a[2] < b[2]; });
+                std::copy_n(sorted[(sorted.size() - 1) / 2], 4, out);
+            } else {
+                // Of equally distant pixels, the last one in the block wins
+                size_t nearest = 0;
+                for (auto k = 1u; k < samples.size(); ++k) {
+                    nearest = distances[k] <= distances[nearest] ? k : nearest;
+                }
+                std::copy_n(samples[nearest], 4, out);
+            }
+        }
+    }
+    return result;
+}
+} // namespace
+
+TEST(FrameConversions, CopyRoiMatchesScalarLoop) {
+    for (auto width : WIDTHS) {
+        auto frame = makeFrame(width + 10, HEIGHT, width);
+        std::vector<uint8_t> mask(frame.numPoints());
+        for (auto i = 0u; i < mask.size(); ++i) {
+            mask[i] = i % 3 != 0;
+        }
+
+        // Rows of the kernel width, both at the start and with an offset into the full rows
+        const uint8_t *masks[] = {nullptr, mask.data()};
+        for (auto xOffset : {0u, 7u}) {
+            auto roi = makeRoi(xOffset, 2, width, HEIGHT - 3);
+            for (const uint8_t *roiMask : masks) {
+                std::vector<float> copied(4 * roi.width * roi.height, -1.f);
+                copyRoi(frame.xyzc(), frame.width(), roi, roiMask, copied.data());
+
+                for (auto row = 0u; row < roi.height; ++row) {
+                    for (auto col = 0u; col < roi.width; ++col) {
+                        auto srcIdx = (roi.y_offset + row) * frame.width() + roi.x_offset + col;
+                        bool keep = !roiMask || roiMask[srcIdx];
+                        for (auto c = 0u; c < 4; ++c) {
+                            float expected = keep ? frame.xyzc()[4 * srcIdx + c] : 0.f;
+                            ASSERT_EQ(copied[4 * (row * roi.width + col) + c], expected)
+                                << "width " << width << " row " << row << " col " << col;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(FrameConversions, CopyGrayRoiMatchesScalarLoop) {
+    for (auto width : WIDTHS) {
+        auto frame = makeFrame(width + 10, HEIGHT, width);
+        auto roi = makeRoi(5, 1, width, HEIGHT - 2);
+        std::vector<uint8_t> copied(roi.width * roi.height);
+        copyGrayRoi(frame.gray(), frame.width(), roi, copied.data());
+
+        for (auto row = 0u; row < roi.height; ++row) {
+            for (auto col = 0u; col < roi.width; ++col) {
+                ASSERT_EQ(copied[row * roi.width + col],
+                          frame.gray()[(roi.y_offset + row) * frame.width() + roi.x_offset + col]);
+            }
+        }
+    }
+}
+
+TEST(FrameConversions, FillDepthImageMatchesScalarLoop) {
+    for (auto width : WIDTHS) {
+        auto frame = makeFrame(width, HEIGHT, width);
+        std::vector<float> expected(frame.numPoints());
+        for (auto i = 0u; i < frame.numPoints(); ++i) {
+            expected[i] = frame.xyzc()[4 * i + 2];
+        }
+
+        // The depth written together with the statistics has to be the same
+        DepthStatistics statistics;
+        for (auto *stats : {static_cast<DepthStatistics *>(nullptr), &statistics}) {
+            sensor_msgs::msg::Image image;
+            fillDepthImage(frame, image, stats);
+            EXPECT_EQ(image.width, width);
+            EXPECT_EQ(image.height, HEIGHT);
+            EXPECT_EQ(image.step, width * sizeof(float));
+            ASSERT_EQ(image.data.size(), expected.size() * sizeof(float));
+            EXPECT_EQ(::memcmp(image.data.data(), expected.data(), image.data.size()), 0);
+        }
+    }
+}
+
+TEST(FrameConversions, DepthStatisticsMatchScalarLoop) {
+    for (auto width : WIDTHS) {
+        auto frame = makeFrame(width, HEIGHT, width);
+        DepthStatistics statistics;
+        statistics.configure({1, 4.f});
+        statistics.apply(frame, nullptr);
+        std_msgs::msg::Float32MultiArray msg;
+        statistics.fill(msg);
+        ASSERT_EQ(msg.data.size(), DepthStatistics::NUM_VALUES);
+
+        double count = 0.;
+        double sum = 0.;
+        float minDepth = std::numeric_limits<float>::max();
+        float maxDepth = 0.f;
+        std::vector<double> histogram(DepthStatistics::HISTOGRAM_BINS, 0.);
+        for (auto i = 0u; i < frame.numPoints(); ++i) {
+            const float *point = frame.xyzc() + 4 * i;
+            if (point[3] > 0.f) {
+                count++;
+                sum += point[2];
+                minDepth = std::min(minDepth, point[2]);
+                maxDepth = std::max(maxDepth, point[2]);
+                auto bin = static_cast<uint32_t>(point[2] * (DepthStatistics::HISTOGRAM_BINS / 4.f));
+                histogram[std::min(bin, DepthStatistics::HISTOGRAM_BINS - 1)]++;
+            }
+        }
+
+        EXPECT_FLOAT_EQ(msg.data[0], count / frame.numPoints());
+        EXPECT_EQ(msg.data[1], minDepth);
+        EXPECT_EQ(msg.data[2], maxDepth);
+        EXPECT_NEAR(msg.data[3], sum / count, 1e-5);
+        for (auto bin = 0u; bin < DepthStatistics::HISTOGRAM_BINS; ++bin) {
+            EXPECT_FLOAT_EQ(msg.data[4 + bin], histogram[bin] / count) << "bin " << bin;
+        }
+    }
+}
+
+TEST(FrameConversions, PackPointsMatchesScalarLoop) {
+    for (auto width : WIDTHS) {
+        auto frame = makeFrame(width, HEIGHT, width);
+        auto numPoints = frame.numPoints();
+        for (auto hasIntensity : {false, true}) {
+            for (auto hasConf : {false, true}) {
+                for (const uint8_t *gray : {static_cast<const uint8_t *>(nullptr), frame.gray()}) {
+                    std::vector<float> expected;
+                    for (auto i = 0u; i < numPoints; ++i) {
+                        const float *point = frame.xyzc() + 4 * i;
+                        expected.insert(expected.end(), point, point + 3);
+                        if (hasIntensity) {
+                            expected.push_back(gray ? gray[i] : 0.f);
+                        }
+                        if (hasConf) {
+                            expected.push_back(point[3]);
+                        }
+                    }
+
+                    std::vector<float> packed(expected.size());
+                    packCloud(frame.xyzc(), gray, numPoints, hasIntensity, hasConf, packed.data());
+                    EXPECT_EQ(packed, expected) << "intensity " << hasIntensity << " conf " << hasConf;
+
+                    // The instantiation of the layout packCloud copies has to produce it as well
+                    if (!hasIntensity && hasConf) {
+                        packPoints<false, true>(frame.xyzc(), gray, numPoints, packed.data());
+                        EXPECT_EQ(packed, expected);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(FrameConversions, FlyingPixelFilterMatchesScalarLoop) {
+    for (auto numThreads : {0u, 2u}) {
+        RowBandPool pool(numThreads);
+        for (auto windowSize : {3u, 5u}) {
+            FlyingPixelFilter filter;
+            filter.configure({true, windowSize, 0.05f, 10.f});
+            for (auto width : WIDTHS) {
+                auto frame = makeFrame(width, HEIGHT, width);
+                auto expected = referenceFlyingPixels(frame, windowSize / 2, 0.05f, 10.f);
+                filter.apply(frame, pool);
+
+                auto filtered = points(frame);
+                EXPECT_EQ(filtered, expected) << "width " << width << " window " << windowSize;
+                // The scene has edges, so the comparison isn't trivially passed by an unfiltered frame
+                EXPECT_NE(filtered, points(makeFrame(width, HEIGHT, width)));
+            }
+        }
+    }
+}
+
+TEST(FrameConversions, TemporalFilterMatchesScalarLoop) {
+    for (auto numThreads : {0u, 2u}) {
+        RowBandPool pool(numThreads);
+        for (auto mode : {TemporalFilter::Mode::Mean, TemporalFilter::Mode::Median}) {
+            for (auto width : WIDTHS) {
+                TemporalFilter filter;
+                filter.configure({mode, 4, 0.015f});
+                History history;
+                for (auto frameIdx = 0u; frameIdx < 6; ++frameIdx) {
+                    auto frame = makeFrame(width, HEIGHT, width * 10 + frameIdx);
+                    std::vector<float> plane(2 * frame.numPoints());
+                    for (auto i = 0u; i < frame.numPoints(); ++i) {
+                        plane[2 * i] = frame.xyzc()[4 * i + 2];
+                        plane[2 * i + 1] = frame.xyzc()[4 * i + 3];
+                    }
+                    history.push_front(plane);
+                    if (history.size() > 4) {
+                        history.pop_back();
+                    }
+
+                    auto expected = referenceTemporal(frame, history, mode, 0.015f);
+                    filter.apply(frame, pool);
+                    ASSERT_EQ(points(frame), expected) << "width " << width << " frame " << frameIdx;
+                }
+            }
+        }
+    }
+}
+
+TEST(FrameConversions, FrameReducerMatchesScalarLoop) {
+    RowBandPool pool(0);
+    for (auto mode : {FrameReducer::Mode::Mean, FrameReducer::Mode::Median, FrameReducer::Mode::Nearest}) {
+        for (auto factor : {2u, 4u}) {
+            FrameReducer reducer;
+            reducer.configure({mode, factor});
+            for (auto width : WIDTHS) {
+                auto frame = makeFrame(width, HEIGHT, width);
+                frame.setCloudFields(Frame::CloudFields::Xyzic);
+                Frame reduced(1, 1);
+                reducer.apply(frame, reduced, pool);
+
+                ASSERT_EQ(reduced.width(), width / factor);
+                ASSERT_EQ(reduced.height(), HEIGHT / factor);
+                EXPECT_EQ(points(reduced), referenceReduced(frame, mode, factor))
+                    << "width " << width << " factor " << factor << " mode " << static_cast<int>(mode);
+
+                ASSERT_TRUE(reduced.hasGray());
+                for (auto row = 0u; row < reduced.height(); ++row) {
+                    for (auto col = 0u; col < reduced.width(); ++col) {
+                        uint32_t sum = 0;
+                        for (auto by = 0u; by < factor; ++by) {
+                            for (auto bx = 0u; bx < factor; ++bx) {
+                                sum += frame.gray()[(row * factor + by) * width + col * factor + bx];
+                            }
+                        }
+                        ASSERT_EQ(reduced.gray()[row * reduced.width() + col], sum / (factor * factor));
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(FrameConversions, ReducedCameraInfoMatchesBlocks) {
+    RowBandPool pool(0);
+    for (auto factor : {2u, 4u}) {
+        FrameReducer reducer;
+        reducer.configure({FrameReducer::Mode::Mean, factor});
+        // The offsets aren't multiples of the factor, the blocks start at the origin of the region nonetheless
+        for (auto xOffset : {0u, 3u, 6u}) {
+            for (auto yOffset : {0u, 5u}) {
+                Frame frame = makeFrame(21, 13, xOffset);
+                frame.setRegion(xOffset, yOffset, 40, 30);
+                Frame reduced(1, 1);
+                ASSERT_EQ(reducer.apply(frame, reduced, pool), factor);
+
+                sensor_msgs::msg::CameraInfo cameraInfo;
+                cameraInfo.width = 40;
+                cameraInfo.height = 30;
+                cameraInfo.k = {100., 0., 19.7, 0., 101., 14.2, 0., 0., 1.};
+                cameraInfo.p = {100., 0., 19.7, 0., 0., 101., 14.2, 0., 0., 0., 1., 0.};
+                cameraInfo.roi = makeRoi(xOffset, yOffset, frame.width(), frame.height());
+                auto full = cameraInfo;
+                FrameReducer::reduceCameraInfo(factor, cameraInfo);
+
+                EXPECT_EQ(cameraInfo.roi.x_offset, reduced.xOffset());
+                EXPECT_EQ(cameraInfo.roi.y_offset, reduced.yOffset());
+                EXPECT_EQ(cameraInfo.roi.width, reduced.width());
+                EXPECT_EQ(cameraInfo.roi.height, reduced.height());
+
+                // The ray of a reduced pixel has to be the one of the center of its block
+                for (auto u = 0u; u < reduced.width(); ++u) {
+                    double center = xOffset + factor * u + (factor - 1) * 0.5;
+                    double reducedRay = (cameraInfo.roi.x_offset + u - cameraInfo.k[2]) / cameraInfo.k[0];
+                    EXPECT_NEAR(reducedRay, (center - full.k[2]) / full.k[0], 1e-9) << "factor " << factor;
+                    reducedRay = (cameraInfo.roi.x_offset + u - cameraInfo.p[2]) / cameraInfo.p[0];
+                    EXPECT_NEAR(reducedRay, (center - full.p[2]) / full.p[0], 1e-9);
+                }
+                for (auto v = 0u; v < reduced.height(); ++v) {
+                    double center = yOffset + factor * v + (factor - 1) * 0.5;
+                    double reducedRay = (cameraInfo.roi.y_offset + v - cameraInfo.k[5]) / cameraInfo.k[4];
+                    EXPECT_NEAR(reducedRay, (center - full.k[5]) / full.k[4], 1e-9) << "factor " << factor;
+                    reducedRay = (cameraInfo.roi.y_offset + v - cameraInfo.p[6]) / cameraInfo.p[5];
+                    EXPECT_NEAR(reducedRay, (center - full.p[6]) / full.p[5], 1e-9);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,143 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <GrayPairing.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace pmd_royale_ros_driver;
+
+namespace {
+const uint32_t WIDTH = 6;
+const uint32_t HEIGHT = 4;
+
+std::unique_ptr<Frame> makeFrame() {
+    return std::unique_ptr<Frame>(new Frame(WIDTH, HEIGHT));
+}
+
+std::vector<uint8_t> makeGray(uint8_t value) {
+    return std::vector<uint8_t>(WIDTH * HEIGHT, value);
+}
+
+sensor_msgs::msg::RegionOfInterest fullRoi() {
+    sensor_msgs::msg::RegionOfInterest roi;
+    roi.width = WIDTH;
+    roi.height = HEIGHT;
+    return roi;
+}
+} // namespace
+
+TEST(GrayPairing, GrayBeforeFrame) {
+    GrayPairing pairing;
+    auto gray = makeGray(7);
+    auto result = pairing.addGray(gray.data(), WIDTH, fullRoi(), 100);
+    EXPECT_FALSE(result.complete.frame);
+    EXPECT_FALSE(result.withoutGray.frame);
+
+    result = pairing.addFrame(makeFrame(), 100, 3, true);
+    ASSERT_TRUE(result.complete.frame);
+    EXPECT_EQ(result.complete.throttledOutputs, 3u);
+    ASSERT_TRUE(result.complete.frame->hasGray());
+    EXPECT_EQ(result.complete.frame->gray()[0], 7);
+    EXPECT_FALSE(result.withoutGray.frame);
+}
+
+TEST(GrayPairing, FrameBeforeGray) {
+    GrayPairing pairing;
+    auto result = pairing.addFrame(makeFrame(), 100, 5, true);
+    EXPECT_FALSE(result.complete.frame);
+    EXPECT_FALSE(result.withoutGray.frame);
+
+    // The second callback of the capture hands the frame on
+    auto gray = makeGray(9);
+    result = pairing.addGray(gray.data(), WIDTH, fullRoi(), 100);
+    ASSERT_TRUE(result.complete.frame);
+    EXPECT_EQ(result.complete.throttledOutputs, 5u);
+    ASSERT_TRUE(result.complete.frame->hasGray());
+    EXPECT_EQ(result.complete.frame->gray()[WIDTH * HEIGHT - 1], 9);
+    EXPECT_FALSE(result.withoutGray.frame);
+}
+
+TEST(GrayPairing, OrderChangesBetweenCaptures) {
+    GrayPairing pairing;
+    auto gray = makeGray(1);
+    for (uint64_t timestamp = 100; timestamp < 110; ++timestamp) {
+        GrayPairing::Result first;
+        GrayPairing::Result second;
+        if (timestamp % 2) {
+            first = pairing.addFrame(makeFrame(), timestamp, 0, true);
+            second = pairing.addGray(gray.data(), WIDTH, fullRoi(), timestamp);
+        } else {
+            first = pairing.addGray(gray.data(), WIDTH, fullRoi(), timestamp);
+            second = pairing.addFrame(makeFrame(), timestamp, 0, true);
+        }
+        EXPECT_FALSE(first.complete.frame);
+        EXPECT_FALSE(first.withoutGray.frame);
+        ASSERT_TRUE(second.complete.frame) << timestamp;
+        EXPECT_TRUE(second.complete.frame->hasGray());
+        EXPECT_FALSE(second.withoutGray.frame);
+    }
+}
+
+TEST(GrayPairing, LostGrayIsHandedOnWithoutIt) {
+    GrayPairing pairing;
+    pairing.addFrame(makeFrame(), 100, 1, true);
+
+    // The next frame comes without a gray image in between
+    auto result = pairing.addFrame(makeFrame(), 101, 2, true);
+    EXPECT_FALSE(result.complete.frame);
+    ASSERT_TRUE(result.withoutGray.frame);
+    EXPECT_EQ(result.withoutGray.throttledOutputs, 1u);
+    EXPECT_FALSE(result.withoutGray.frame->hasGray());
+
+    // The gray image of a later capture comes, the one of the held frame is lost as well
+    auto gray = makeGray(1);
+    result = pairing.addGray(gray.data(), WIDTH, fullRoi(), 102);
+    EXPECT_FALSE(result.complete.frame);
+    ASSERT_TRUE(result.withoutGray.frame);
+    EXPECT_EQ(result.withoutGray.throttledOutputs, 2u);
+}
+
+TEST(GrayPairing, EarlierGrayKeepsFrameWaiting) {
+    GrayPairing pairing;
+    auto gray = makeGray(1);
+    pairing.addFrame(makeFrame(), 101, 0, true);
+    auto result = pairing.addGray(gray.data(), WIDTH, fullRoi(), 100);
+    EXPECT_FALSE(result.complete.frame);
+    EXPECT_FALSE(result.withoutGray.frame);
+
+    result = pairing.addGray(gray.data(), WIDTH, fullRoi(), 101);
+    ASSERT_TRUE(result.complete.frame);
+    EXPECT_TRUE(result.complete.frame->hasGray());
+}
+
+TEST(GrayPairing, FrameWithoutIntensityIsNotHeld) {
+    GrayPairing pairing;
+    auto result = pairing.addFrame(makeFrame(), 100, 0, false);
+    ASSERT_TRUE(result.complete.frame);
+    EXPECT_FALSE(result.complete.frame->hasGray());
+
+    // A frame held for its gray image goes out when intensity isn't needed anymore
+    pairing.addFrame(makeFrame(), 101, 0, true);
+    result = pairing.addFrame(makeFrame(), 102, 0, false);
+    EXPECT_TRUE(result.complete.frame);
+    EXPECT_TRUE(result.withoutGray.frame);
+}
+
+TEST(GrayPairing, GrayOfOtherSizeIsNotAttached) {
+    GrayPairing pairing;
+    auto gray = makeGray(1);
+    auto roi = fullRoi();
+    roi.width = WIDTH - 1;
+    pairing.addGray(gray.data(), WIDTH, roi, 100);
+    auto result = pairing.addFrame(makeFrame(), 100, 0, true);
+    EXPECT_FALSE(result.complete.frame);
+    EXPECT_FALSE(result.withoutGray.frame);
+}
@@ -0,0 +1,100 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include <ShmFrameRing.hpp>
+#include <ShmFrameRingWriter.hpp>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+using namespace pmd_royale_ros_driver;
+
+namespace {
+Frame makeFrame(uint32_t width, uint32_t height, float value) {
+    Frame frame(width, height);
+    for (auto i = 0u; i < 4 * frame.numPoints(); ++i) {
+        frame.xyzc()[i] = value + i;
+    }
+    return frame;
+}
+
+std::string ringName() {
+    return shmFrameRingName("test_shm_frame_ring_" + std::to_string(::getpid()), 0);
+}
+} // namespace
+
+TEST(ShmFrameRing, NameReplacesSlashes) {
+    EXPECT_EQ(shmFrameRingName("royale_cam0", 1), "/royale_cam0_point_cloud_1");
+    EXPECT_EQ(shmFrameRingName("robot/front/royale_cam0", 0), "/robot_front_royale_cam0_point_cloud_0");
+}
+
+TEST(ShmFrameRing, ReadsWrittenFrame) {
+    ShmFrameRingWriter writer;
+    ASSERT_TRUE(writer.create(ringName(), 2, 16));
+    ShmFrameRingReader reader;
+    ASSERT_TRUE(reader.open(ringName()));
+
+    auto frame = makeFrame(4, 3, 1.f);
+    auto sequence = writer.write(frame);
+    ASSERT_EQ(sequence, 1u);
+    EXPECT_EQ(reader.lastSequence(), 1u);
+
+    std::vector<float> xyzc;
+    ASSERT_TRUE(reader.read(sequence, [&](const ShmFrameView &view) {
+        EXPECT_EQ(view.width, 4u);
+        EXPECT_EQ(view.height, 3u);
+        EXPECT_EQ(view.gray, nullptr);
+        xyzc.assign(view.xyzc, view.xyzc + 4 * view.width * view.height);
+    }));
+    EXPECT_EQ(xyzc, std::vector<float>(frame.xyzc(), frame.xyzc() + 4 * frame.numPoints()));
+}
+
+TEST(ShmFrameRing, OverwrittenFrameIsRejected) {
+    ShmFrameRingWriter writer;
+    ASSERT_TRUE(writer.create(ringName(), 2, 16));
+    ShmFrameRingReader reader;
+    ASSERT_TRUE(reader.open(ringName()));
+
+    auto frame = makeFrame(4, 3, 1.f);
+    writer.write(frame);
+    writer.write(frame);
+    writer.write(frame);
+    EXPECT_FALSE(reader.read(1, [](const ShmFrameView &) { FAIL() << "Frame 1 was overwritten by frame 3"; }));
+    EXPECT_TRUE(reader.read(3, [](const ShmFrameView &) {}));
+}
+
+TEST(ShmFrameRing, TornReadIsRetried) {
+    ShmFrameRingWriter writer;
+    ASSERT_TRUE(writer.create(ringName(), 2, 16));
+    ShmFrameRingReader reader;
+    ASSERT_TRUE(reader.open(ringName()));
+
+    writer.write(makeFrame(4, 3, 1.f));
+
+    // The writer wraps around to the slot of frame 1 while the reader is accessing it, the way a reader which
+    // falls behind sees it. The seqlock detects it and the reader retries with the newest frame.
+    int attempts = 0;
+    float firstValue = 0.f;
+    uint64_t sequence = reader.lastSequence();
+    while (!reader.read(sequence, [&](const ShmFrameView &view) {
+        if (++attempts == 1) {
+            writer.write(makeFrame(4, 3, 2.f));
+            writer.write(makeFrame(4, 3, 3.f));
+        }
+        firstValue = view.xyzc[0];
+    })) {
+        sequence = reader.lastSequence();
+        ASSERT_LT(attempts, 3);
+    }
+
+    EXPECT_EQ(attempts, 2);
+    EXPECT_EQ(sequence, 3u);
+    EXPECT_EQ(firstValue, 3.f);
+}
@@ -18,6 +18,7 @@
 #include <QLabel>
 #include <QLineEdit>
 #include <QSlider>
+#include <QVBoxLayout>
 #include <QWidget>
 
 #include <pluginlib/class_list_macros.hpp>
@@ -25,16 +26,22 @@
 #include <rviz_common/panel.hpp>
 #include <std_msgs/msg/string.hpp>
 
-#define ROYALE_ROS_MAX_STREAMS 2u
-
 namespace pmd_royale_ros_examples {
 
+/// Controls of the usecase and of the exposure and processing parameters of every stream of a camera node.
+///
+/// The number of streams depends on the usecase; the panel takes it from the camera registry and calls
+/// setNumStreams() whenever it changes. Controls of streams which the usecase doesn't have are hidden.
 class CameraControlWidget : public QWidget, public CameraParametersClient {
     Q_OBJECT
   public:
-    CameraControlWidget(std::shared_ptr<rclcpp::Node> node, std::string cameraNodeName, QWidget *parent = 0);
+    CameraControlWidget(std::shared_ptr<rclcpp::Node> node, std::string cameraNodeName, uint32_t numStreams,
+                        QWidget *parent = 0);
     ~CameraControlWidget();
 
+    /// Show the controls of numStreams streams, the missing ones are created and their parameters fetched
+    void setNumStreams(uint32_t numStreams);
+
   private Q_SLOTS:
     void setUseCase(const QString &currentMode);
     void setExposureTime(int value, uint32_t streamIdx);
@@ -43,63 +50,31 @@ class CameraControlWidget : public QWidget, public CameraParametersClient {
 
     // The precise value can be entered directly via the text editor.
     void preciseExposureTimeSetting(uint32_t streamIdx);
-    
-    void chooseCamera(int idx);
 
   private:
+    struct StreamControls {
+        QWidget *widget;
+        QLabel *labelExpoTime;
+        QSlider *sliderExpoTime;
+        QLineEdit *lineEditExpoTime;
+        QCheckBox *checkBoxAutoExpo;
+        QLineEdit *lineEditParams;
+        rclcpp::Publisher<std_msgs::msg::String>::SharedPtr pubParameters;
+    };
+
+    // Parameters arrive on the spin thread and are shown on the GUI thread
     virtual void onNewCameraParameter(const CameraParameter &cameraParam) override;
-    
-    void callbackInit(const std_msgs::msg::String::SharedPtr msg);
-    
-    // Callback the current parameters of exposure time
-    // when the UI is started or user case is switched
-    void callbackExpoTimeParam(const std_msgs::msg::String::SharedPtr msg, uint32_t streamIdx);
-    void callbackExpoTimeValue(const std_msgs::msg::String::SharedPtr msg, uint32_t streamIdx);
-
-    // Callback the fps and display it
-    void callbackFps(const std_msgs::msg::String::SharedPtr msg, uint32_t streamIdx);
+    void showCameraParameter(const CameraParameter &cameraParam);
 
+    // Controls of a stream, nullptr if the stream has none yet
+    StreamControls *streamControls(const std::string &paramName, const char *prefix);
 
-    QComboBox *m_cams;
+    std::string m_cameraNodeName;
+    QVBoxLayout *m_controlLayout;
     QComboBox *m_comboBoxUseCases;
-    QLabel *m_labelExpoTime[ROYALE_ROS_MAX_STREAMS];
-    QSlider *m_sliderExpoTime[ROYALE_ROS_MAX_STREAMS];
-    QLineEdit *m_lineEditExpoTime[ROYALE_ROS_MAX_STREAMS];
-    QCheckBox *m_checkBoxAutoExpo[ROYALE_ROS_MAX_STREAMS];
-    QLineEdit *m_lineEditParams[ROYALE_ROS_MAX_STREAMS];
-    QLabel *m_labelEditFps[ROYALE_ROS_MAX_STREAMS];
-    QSlider *m_sliderDivisor;
-    QLineEdit *m_lineEditDivisor;
-    QSlider *m_sliderMinFilter;
-    QLineEdit *m_lineEditMinFilter;
-    QSlider *m_sliderMaxFilter;
-    QLineEdit *m_lineEditMaxFilter;
-    QString m_currentUseCase;
-
+    std::vector<StreamControls> m_streams;
 
     rclcpp::Node::SharedPtr m_nh;
-
-    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubParameters[ROYALE_ROS_MAX_STREAMS];
-    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubIsInit;
-    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubUseCase;
-    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubExpoTime[ROYALE_ROS_MAX_STREAMS];
-    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubExpoMode[ROYALE_ROS_MAX_STREAMS];
-    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubMinFilter;
-    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubMaxFilter;
-    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubDivisor;
-    rclcpp::Publisher<std_msgs::msg::String>::SharedPtr m_pubParams[ROYALE_ROS_MAX_STREAMS];
-
-    rclcpp::Subscription<std_msgs::msg::String>::SharedPtr m_subInit;
-    rclcpp::Subscription<std_msgs::msg::String>::SharedPtr m_subTemp;
-    rclcpp::Subscription<std_msgs::msg::String>::SharedPtr m_subExpoTimeParam[ROYALE_ROS_MAX_STREAMS];
-    rclcpp::Subscription<std_msgs::msg::String>::SharedPtr m_subExpoTimeValue[ROYALE_ROS_MAX_STREAMS];
-    rclcpp::Subscription<std_msgs::msg::String>::SharedPtr m_subFps[ROYALE_ROS_MAX_STREAMS];
-
-    bool m_isInit;
-    bool m_isAutomatic[ROYALE_ROS_MAX_STREAMS];
-    int m_exposureTime[ROYALE_ROS_MAX_STREAMS];
-    int m_minETSlider[ROYALE_ROS_MAX_STREAMS];
-    int m_maxETSlider[ROYALE_ROS_MAX_STREAMS];
 };
 
 } // namespace pmd_royale_ros_examples
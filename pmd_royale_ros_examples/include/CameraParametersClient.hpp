@@ -11,10 +11,14 @@
 #ifndef __PMD_ROYALE_ROS_EXAMPLES__CAMERA_PARAMETERS_CLIENT_HPP__
 #define __PMD_ROYALE_ROS_EXAMPLES__CAMERA_PARAMETERS_CLIENT_HPP__
 
+#include <chrono>
+#include <map>
+#include <mutex>
 #include <rclcpp/rclcpp.hpp>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace pmd_royale_ros_examples {
 
@@ -25,31 +29,62 @@ struct CameraParameter {
 };
 
 /// Client to access a camera node's parameters and listen for updates.
+///
+/// Writes are coalesced per parameter: while one write of a parameter is in flight, further values only replace the
+/// pending one, which is sent when the write completes. A write without a response after WRITE_TIMEOUT is given up by
+/// a timer and the pending value is sent then, so a lost response doesn't hold back the last value even if no further
+/// values come in. Parameters are fetched and described in batches, so the
+/// camera node never sees more than one request per parameter at a time.
 class CameraParametersClient {
   public:
+    static constexpr std::chrono::seconds WRITE_TIMEOUT{2};
+
     CameraParametersClient(rclcpp::Node::SharedPtr node, std::string cameraNode);
 
     /// Subscribe for desired camera parameters by name
     void subscribeForCameraParameters(const std::set<std::string> &parameterNames);
 
-    /// Submit change to camera parameter
+    /// Submit change to camera parameter, the latest value wins if a write of it is still in flight
     void setParameter(const rclcpp::Parameter &parameter);
 
   protected:
     void onParametersDescriptorResult(std::shared_future<std::vector<rcl_interfaces::msg::ParameterDescriptor>> future);
     void onParametersResult(std::shared_future<std::vector<rclcpp::Parameter>> future);
     void onParameterEvent(const rcl_interfaces::msg::ParameterEvent &event);
+    void onSetParametersResult(const std::string &name, uint64_t writeId,
+                               std::shared_future<std::vector<rcl_interfaces::msg::SetParametersResult>> future);
+    void onWriteTimeout(const std::string &name, uint64_t writeId);
 
     /// Callback for when a new or updated CameraParameter is available
     virtual void onNewCameraParameter(const CameraParameter &parameter) = 0;
 
   private:
+    // Store new values of subscribed parameters, the ones without descriptor are described in one request
+    void updateParameters(const std::vector<rclcpp::Parameter> &params);
+
+    // Send a write, m_writesMutex has to be held
+    void sendParameter(const rclcpp::Parameter &parameter);
+
+    // End the write of a parameter and send its pending value if there is one, m_writesMutex has to be held
+    void finishWrite(const std::string &name);
+
     rclcpp::Node::SharedPtr m_nh;
     std::string m_cameraNode;
     rclcpp::AsyncParametersClient::SharedPtr m_parametersClient;
     rclcpp::Subscription<rcl_interfaces::msg::ParameterEvent>::SharedPtr m_parameterEventSub;
     std::set<std::string> m_subsribedParameters;
     std::unordered_map<std::string, CameraParameter> m_parameters;
+
+    struct WriteInFlight {
+        uint64_t id;
+        // Fires once after WRITE_TIMEOUT, it is released with the write
+        rclcpp::TimerBase::SharedPtr timeout;
+    };
+
+    std::mutex m_writesMutex;
+    uint64_t m_nextWriteId = 0;
+    std::map<std::string, WriteInFlight> m_writesInFlight;
+    std::map<std::string, rclcpp::Parameter> m_pendingWrites;
 };
 
 } // namespace pmd_royale_ros_examples
@@ -0,0 +1,28 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_EXAMPLES__MESSAGE_STAMP_HPP__
+#define __PMD_ROYALE_ROS_EXAMPLES__MESSAGE_STAMP_HPP__
+
+#include <string>
+
+#include <rclcpp/rclcpp.hpp>
+
+namespace pmd_royale_ros_examples {
+
+/// Whether the messages of a type of the driver start with a std_msgs/Header
+bool hasHeaderStamp(const std::string &type);
+
+/// Read the header stamp of a serialized message without deserializing it. The stamp follows the 4 byte
+/// encapsulation header of the CDR data; only little endian data is read.
+bool readHeaderStamp(const rclcpp::SerializedMessage &msg, rcl_clock_type_t clockType, rclcpp::Time &stamp);
+
+} // namespace pmd_royale_ros_examples
+
+#endif // __PMD_ROYALE_ROS_EXAMPLES__MESSAGE_STAMP_HPP__
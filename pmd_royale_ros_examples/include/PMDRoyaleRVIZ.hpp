@@ -13,17 +13,24 @@
 
 #include "CameraControlWidget.hpp"
 #include "CameraInfoWidget.hpp"
+#include "TopicStatisticsWidget.hpp"
 
+#include <CameraRegistry.hpp>
+#include <map>
 #include <thread>
 
+#include <QComboBox>
 #include <QLabel>
 #include <QLineEdit>
 
 #include <rclcpp/rclcpp.hpp>
 #include <rviz_common/panel.hpp>
+#include <std_msgs/msg/string.hpp>
 
 namespace pmd_royale_ros_examples {
 
+using pmd_royale_ros_driver::CameraRegistryEntry;
+
 /// RVIZ panel for configuring a camera node
 class PMDRoyaleRVIZ : public rviz_common::Panel {
     Q_OBJECT
@@ -33,6 +40,7 @@ class PMDRoyaleRVIZ : public rviz_common::Panel {
 
   private Q_SLOTS:
     void handleCameraNodeSetting();
+    void chooseCamera(int idx);
     virtual void load(const rviz_common::Config &config) override;
     virtual void save(rviz_common::Config config) const override;
 
@@ -40,13 +48,21 @@ class PMDRoyaleRVIZ : public rviz_common::Panel {
     void init();
     void spin();
 
+    // Registry entries arrive on the spin thread and are added to the list of cameras on the GUI thread
+    void onRegistryEntry(const std_msgs::msg::String::SharedPtr msg);
+    void addCamera(const CameraRegistryEntry &entry);
+
     QString m_cameraNode;
     QLabel *m_labelCameraNode;
     QLineEdit *m_lineEditCameraNode;
+    QComboBox *m_comboBoxCameras;
+    std::map<std::string, CameraRegistryEntry> m_cameras;
     CameraControlWidget *m_cameraControlWidget;
     CameraInfoWidget *m_cameraInfoWidget;
+    TopicStatisticsWidget *m_topicStatisticsWidget;
     QTabWidget *m_tabWidget;
     rclcpp::Node::SharedPtr m_nh;
+    rclcpp::Subscription<std_msgs::msg::String>::SharedPtr m_subRegistry;
     rclcpp::executors::SingleThreadedExecutor m_exec;
     std::thread m_thread;
 };
@@ -0,0 +1,117 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_EXAMPLES__SOAK_MONITOR_HPP__
+#define __PMD_ROYALE_ROS_EXAMPLES__SOAK_MONITOR_HPP__
+
+#include <CameraRegistry.hpp>
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+#include <std_msgs/msg/string.hpp>
+
+namespace pmd_royale_ros_examples {
+
+using pmd_royale_ros_driver::CameraRegistryEntry;
+
+/// Measures a camera node over a long run and decides whether the run passed.
+///
+/// The monitor takes the outputs of the camera from the registry and subscribes to all of them with generic
+/// subscriptions. Every sample period it writes the rate of each topic and the CPU load and resident memory of the
+/// driver's process, found by its command line in /proc, to samples.csv. After the warmup the counters start over;
+/// at the end the rates and latency percentiles go to summary.csv. The run fails if the memory grew by more than
+/// max_rss_growth_mb over the measurement, if a topic delivered nothing, or if a topic's rate dropped by more than
+/// max_fps_regression against the summary of a baseline run.
+class SoakMonitor : public rclcpp::Node {
+  public:
+    SoakMonitor(const rclcpp::NodeOptions &options = rclcpp::NodeOptions());
+
+    /// Whether the run finished, and whether it passed
+    bool isFinished() const;
+    bool isPassed() const;
+
+  private:
+    // Latencies are counted in bins of 0.1 ms, everything from 1 s on in the last one, so the memory of the
+    // monitor doesn't grow over the run
+    static constexpr size_t LATENCY_BINS = 10001;
+    static constexpr double LATENCY_BIN_WIDTH = 1e-4;
+
+    // Written by the subscriptions, read by the sample timer
+    struct Counters {
+        std::mutex mutex;
+        uint64_t messages = 0;
+        uint64_t periodMessages = 0;
+        uint64_t stamped = 0;
+        double latencyMax = 0.;
+        std::array<uint64_t, LATENCY_BINS> latencyBins{};
+    };
+
+    struct Topic {
+        CameraRegistryEntry::Topic topic;
+        bool hasHeader;
+        std::shared_ptr<Counters> counters;
+        rclcpp::GenericSubscription::SharedPtr subscription;
+    };
+
+    struct ProcessSample {
+        double cpuTime = 0.;
+        double rssMb = 0.;
+    };
+
+    void onRegistryEntry(const std_msgs::msg::String::SharedPtr msg);
+    void sample();
+    void finish();
+
+    // The driver's process, -1 if it isn't found
+    int findProcess() const;
+    bool readProcess(ProcessSample &sample) const;
+
+    // Latency in seconds below which the given fraction of the stamped messages lies
+    static double latencyPercentile(const Counters &counters, double fraction);
+
+    std::string m_cameraNode;
+    std::string m_processMatch;
+    double m_duration;
+    double m_warmup;
+    double m_samplePeriod;
+    std::string m_outputDir;
+    std::string m_baseline;
+    double m_maxFpsRegression;
+    double m_maxRssGrowthMb;
+
+    rclcpp::Subscription<std_msgs::msg::String>::SharedPtr m_subRegistry;
+    rclcpp::TimerBase::SharedPtr m_sampleTimer;
+    std::vector<Topic> m_topics;
+    std::ofstream m_samples;
+
+    int m_pid;
+    bool m_isProcessLost;
+    ProcessSample m_lastProcess;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_warmStart;
+    std::chrono::steady_clock::time_point m_lastSample;
+    bool m_isWarm;
+    double m_rssStartMb;
+    double m_rssEndMb;
+    double m_rssMaxMb;
+
+    bool m_isFinished;
+    bool m_isPassed;
+};
+
+} // namespace pmd_royale_ros_examples
+
+#endif // __PMD_ROYALE_ROS_EXAMPLES__SOAK_MONITOR_HPP__
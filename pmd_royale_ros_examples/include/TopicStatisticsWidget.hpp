@@ -0,0 +1,76 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+#ifndef __PMD_ROYALE_ROS_EXAMPLES__TOPIC_STATISTICS_WIDGET_HPP__
+#define __PMD_ROYALE_ROS_EXAMPLES__TOPIC_STATISTICS_WIDGET_HPP__
+
+#include <CameraRegistry.hpp>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QTableWidget>
+#include <QTimer>
+#include <QWidget>
+
+#include <rclcpp/rclcpp.hpp>
+
+namespace pmd_royale_ros_examples {
+
+using pmd_royale_ros_driver::CameraRegistryEntry;
+
+/// Shows rate, bandwidth and latency of the outputs of a camera node.
+///
+/// The topics are measured with generic subscriptions, so the messages are never deserialized; the latency is the
+/// difference between the receive time and the header stamp, which is read directly from the CDR data. Topics are
+/// only subscribed while they are checked, as the driver skips the conversion of outputs nobody listens to.
+class TopicStatisticsWidget : public QWidget {
+    Q_OBJECT
+  public:
+    TopicStatisticsWidget(std::shared_ptr<rclcpp::Node> node, QWidget *parent = 0);
+
+    /// Show the topics of a registry entry, keeps the subscriptions if they didn't change
+    void setTopics(const std::vector<CameraRegistryEntry::Topic> &topics);
+
+  private Q_SLOTS:
+    void onItemChanged(QTableWidgetItem *item);
+    void updateStatistics();
+
+  private:
+    // Written by the subscription on the spin thread, read and reset by the GUI
+    struct Counters {
+        std::mutex mutex;
+        uint64_t messages = 0;
+        uint64_t bytes = 0;
+        uint64_t stamped = 0;
+        double latencySum = 0.;
+        double latencyMax = 0.;
+    };
+
+    struct Topic {
+        CameraRegistryEntry::Topic topic;
+        bool hasHeader;
+        std::shared_ptr<Counters> counters;
+        rclcpp::GenericSubscription::SharedPtr subscription;
+    };
+
+    void subscribe(Topic &topic);
+
+    rclcpp::Node::SharedPtr m_nh;
+    QTableWidget *m_table;
+    QTimer *m_timer;
+    std::vector<Topic> m_topics;
+    std::chrono::steady_clock::time_point m_lastUpdate;
+};
+
+} // namespace pmd_royale_ros_examples
+
+#endif // __PMD_ROYALE_ROS_EXAMPLES__TOPIC_STATISTICS_WIDGET_HPP__
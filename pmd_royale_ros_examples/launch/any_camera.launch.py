@@ -36,6 +36,7 @@ def generate_launch_description():
                 package='pmd_royale_ros_driver',
                 plugin='pmd_royale_ros_driver::CameraNode',
                 name='pmd_royale_ros_camera_node',
+                extra_arguments=[{'use_intra_process_comms': True}],
                 parameters=[{
                     # # Uncomment below to set specific parameters
                     # 'serial' : '8230-93AE-1FA8-283C',
@@ -44,6 +45,7 @@ def generate_launch_description():
                     # 'exposure_time': 230,
                     # 'access_code' : '',
                     # 'recording_file' : 'file_to_record_to.rrf',
+                    # 'target_frame' : 'pmd_royale_ros_camera_node_link',
                 }])
         ],
         output='screen',
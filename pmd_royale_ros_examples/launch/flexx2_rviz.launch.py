@@ -48,6 +48,7 @@ def generate_launch_description():
                 package='pmd_royale_ros_driver',
                 plugin='pmd_royale_ros_driver::CameraNode',
                 name='pmd_royale_ros_camera_node',
+                extra_arguments=[{'use_intra_process_comms': True}],
                 parameters=[flexx_config]
             )
         ],
@@ -0,0 +1,79 @@
+# ****************************************************************************\
+# * Copyright (C) 2023 pmdtechnologies ag
+# *
+# * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+# * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+# * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+# * PARTICULAR PURPOSE.
+# *
+# ****************************************************************************/
+
+from launch import LaunchDescription
+from launch.actions import DeclareLaunchArgument
+from launch.substitutions import LaunchConfiguration
+from launch_ros.actions import ComposableNodeContainer
+from launch_ros.descriptions import ComposableNode
+from launch_ros.parameter_descriptions import ParameterValue
+
+# Name and mounting of every camera on the robot, as translation and rotation (x, y, z, w) of its optical frame
+CAMERAS = [
+    ('camera_front', 'serial_front', [0.2, 0.0, 0.3], [-0.5, 0.5, -0.5, 0.5]),
+    ('camera_back', 'serial_back', [-0.2, 0.0, 0.3], [0.5, 0.5, -0.5, -0.5]),
+]
+
+def generate_launch_description():
+    arguments = [
+        DeclareLaunchArgument('base_frame', default_value='base_link', description='Frame of the fused point cloud'),
+        DeclareLaunchArgument('sync_tolerance', default_value='0.01'),
+    ] + [DeclareLaunchArgument(serial, default_value='', description='Serial number of ' + name)
+         for name, serial, _, _ in CAMERAS]
+
+    nodes = []
+    for name, serial, translation, rotation in CAMERAS:
+        nodes.append(ComposableNode(
+            package="tf2_ros",
+            plugin='tf2_ros::StaticTransformBroadcasterNode',
+            name=name + '_tf',
+            parameters=[{
+                'frame_id' : LaunchConfiguration('base_frame'),
+                'child_frame_id' : name + '_optical_frame',
+                'translation.x' : translation[0],
+                'translation.y' : translation[1],
+                'translation.z' : translation[2],
+                'rotation.x' : rotation[0],
+                'rotation.y': rotation[1],
+                'rotation.z' : rotation[2],
+                'rotation.w' : rotation[3]}]))
+        # The stamps of the cameras are only comparable in the node clock
+        nodes.append(ComposableNode(
+            package='pmd_royale_ros_driver',
+            plugin='pmd_royale_ros_driver::CameraNode',
+            name=name,
+            extra_arguments=[{'use_intra_process_comms': True}],
+            parameters=[{
+                'serial' : ParameterValue(LaunchConfiguration(serial), value_type=str),
+                'stamp_source' : 'synchronized',
+            }]))
+
+    # Receives the frames of the cameras in the same container without any copy
+    nodes.append(ComposableNode(
+        package='pmd_royale_ros_driver',
+        plugin='pmd_royale_ros_driver::CloudAggregatorNode',
+        name='pmd_royale_ros_cloud_aggregator',
+        extra_arguments=[{'use_intra_process_comms': True}],
+        parameters=[{
+            'input_topics' : ['/' + name + '/point_cloud_0' for name, _, _, _ in CAMERAS],
+            'target_frame' : LaunchConfiguration('base_frame'),
+            'sync_tolerance' : LaunchConfiguration('sync_tolerance'),
+        }]))
+
+    container = ComposableNodeContainer(
+        name='pmd_royale_ros_multi_camera_container',
+        namespace='',
+        package='rclcpp_components',
+        executable='component_container_mt',
+        composable_node_descriptions=nodes,
+        output='screen',
+    )
+
+    return LaunchDescription(arguments + [container])
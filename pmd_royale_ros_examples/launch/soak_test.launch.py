@@ -0,0 +1,71 @@
+# ****************************************************************************\
+# * Copyright (C) 2023 pmdtechnologies ag
+# *
+# * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+# * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+# * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+# * PARTICULAR PURPOSE.
+# *
+# ****************************************************************************/
+
+from launch import LaunchDescription
+from launch.actions import DeclareLaunchArgument, EmitEvent, RegisterEventHandler
+from launch.event_handlers import OnProcessExit
+from launch.events import Shutdown
+from launch.substitutions import LaunchConfiguration
+from launch_ros.actions import ComposableNodeContainer, Node
+from launch_ros.descriptions import ComposableNode
+from launch_ros.parameter_descriptions import ParameterValue
+
+def generate_launch_description():
+    arguments = [
+        DeclareLaunchArgument('playback_file', description='Royale recording (.rrf) played back instead of a camera'),
+        DeclareLaunchArgument('duration', default_value='3600.0', description='Measured time in seconds'),
+        DeclareLaunchArgument('warmup', default_value='60.0', description='Time in seconds before the measurement starts'),
+        DeclareLaunchArgument('output_dir', default_value='soak_results'),
+        DeclareLaunchArgument('baseline', default_value='', description='summary.csv of a previous run to compare the rates with'),
+        DeclareLaunchArgument('max_fps_regression', default_value='0.05'),
+        DeclareLaunchArgument('max_rss_growth_mb', default_value='10.0'),
+    ]
+
+    # The monitor finds the container by this name on its command line
+    container = ComposableNodeContainer(
+        name='pmd_royale_ros_soak_container',
+        namespace='',
+        package='rclcpp_components',
+        executable='component_container',
+        composable_node_descriptions=[
+            ComposableNode(
+                package='pmd_royale_ros_driver',
+                plugin='pmd_royale_ros_driver::CameraNode',
+                name='pmd_royale_ros_camera_node',
+                extra_arguments=[{'use_intra_process_comms': True}],
+                # The monitor measures the latency against its own clock, the device timestamps of a recording
+                # are not comparable to it
+                parameters=[{
+                    'playback_file' : ParameterValue(LaunchConfiguration('playback_file'), value_type=str),
+                    'stamp_source' : 'arrival',
+                }])
+        ],
+        output='screen',
+    )
+
+    monitor = Node(
+        package='pmd_royale_ros_examples',
+        executable='soak_monitor',
+        output='screen',
+        parameters=[{
+            'camera_node' : '/pmd_royale_ros_camera_node',
+            'process_match' : '__node:=pmd_royale_ros_soak_container',
+            'duration' : LaunchConfiguration('duration'),
+            'warmup' : LaunchConfiguration('warmup'),
+            'output_dir' : ParameterValue(LaunchConfiguration('output_dir'), value_type=str),
+            'baseline' : ParameterValue(LaunchConfiguration('baseline'), value_type=str),
+            'max_fps_regression' : LaunchConfiguration('max_fps_regression'),
+            'max_rss_growth_mb' : LaunchConfiguration('max_rss_growth_mb'),
+        }])
+
+    # The run ends with the monitor
+    shutdown = RegisterEventHandler(OnProcessExit(target_action=monitor, on_exit=[EmitEvent(event=Shutdown())]))
+
+    return LaunchDescription(arguments + [container, monitor, shutdown])
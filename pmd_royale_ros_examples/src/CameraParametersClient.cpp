@@ -14,6 +14,8 @@
 
 namespace pmd_royale_ros_examples {
 
+constexpr std::chrono::seconds CameraParametersClient::WRITE_TIMEOUT;
+
 CameraParametersClient::CameraParametersClient(rclcpp::Node::SharedPtr node, std::string cameraNode)
     : m_nh(node), m_cameraNode(cameraNode) {
     m_parametersClient = std::make_shared<rclcpp::AsyncParametersClient>(m_nh, m_cameraNode);
@@ -23,7 +25,13 @@ CameraParametersClient::CameraParametersClient(rclcpp::Node::SharedPtr node, std
 
 void CameraParametersClient::onParametersDescriptorResult(
     std::shared_future<std::vector<rcl_interfaces::msg::ParameterDescriptor>> future) {
-    auto result = future.get();
+    std::vector<rcl_interfaces::msg::ParameterDescriptor> result;
+    try {
+        result = future.get();
+    } catch (const std::exception &e) {
+        RCLCPP_WARN(m_nh->get_logger(), "Describing the parameters of %s failed: %s", m_cameraNode.c_str(), e.what());
+        return;
+    }
     for (auto &descriptor : result) {
         if (m_subsribedParameters.find(descriptor.name) != m_subsribedParameters.end()) {
             auto &cameraParameter = m_parameters[descriptor.name];
@@ -36,22 +44,33 @@ void CameraParametersClient::onParametersDescriptorResult(
 }
 
 void CameraParametersClient::onParametersResult(std::shared_future<std::vector<rclcpp::Parameter>> future) {
-    auto result = future.get();
-    for (auto &param : result) {
+    try {
+        updateParameters(future.get());
+    } catch (const std::exception &e) {
+        RCLCPP_WARN(m_nh->get_logger(), "Getting the parameters of %s failed: %s", m_cameraNode.c_str(), e.what());
+    }
+}
+
+void CameraParametersClient::updateParameters(const std::vector<rclcpp::Parameter> &params) {
+    std::vector<std::string> undescribed;
+    for (auto &param : params) {
         if (m_subsribedParameters.find(param.get_name()) != m_subsribedParameters.end() &&
             param.get_type() != rclcpp::PARAMETER_NOT_SET) {
             auto &cameraParameter = m_parameters[param.get_name()];
             cameraParameter.parameter =
                 std::make_shared<rclcpp::Parameter>(param.get_name(), param.get_parameter_value());
             if (!cameraParameter.descriptor) {
-                m_parametersClient->describe_parameters(
-                    {param.get_name()},
-                    std::bind(&CameraParametersClient::onParametersDescriptorResult, this, std::placeholders::_1));
+                undescribed.push_back(param.get_name());
             } else {
                 onNewCameraParameter(m_parameters[param.get_name()]);
             }
         }
     }
+
+    if (!undescribed.empty()) {
+        m_parametersClient->describe_parameters(
+            undescribed, std::bind(&CameraParametersClient::onParametersDescriptorResult, this, std::placeholders::_1));
+    }
 }
 
 void CameraParametersClient::onParameterEvent(const rcl_interfaces::msg::ParameterEvent &event) {
@@ -67,36 +86,85 @@ void CameraParametersClient::onParameterEvent(const rcl_interfaces::msg::Paramet
         }
     }
 
-    auto params = rclcpp::ParameterEventHandler::get_parameters_from_event(event);
-    for (auto &param : params) {
-        if (m_subsribedParameters.find(param.get_name()) != m_subsribedParameters.end() &&
-            param.get_type() != rclcpp::PARAMETER_NOT_SET) {
-            auto &cameraParameter = m_parameters[param.get_name()];
-            cameraParameter.parameter =
-                std::make_shared<rclcpp::Parameter>(param.get_name(), param.get_parameter_value());
+    updateParameters(rclcpp::ParameterEventHandler::get_parameters_from_event(event));
+}
 
-            if (!cameraParameter.descriptor) {
-                m_parametersClient->describe_parameters(
-                    {param.get_name()},
-                    std::bind(&CameraParametersClient::onParametersDescriptorResult, this, std::placeholders::_1));
-            } else {
-                onNewCameraParameter(m_parameters[param.get_name()]);
+void CameraParametersClient::subscribeForCameraParameters(const std::set<std::string> &parameterNames) {
+    // Only the parameters which aren't subscribed yet are fetched
+    std::vector<std::string> newParameters;
+    std::set_difference(parameterNames.begin(), parameterNames.end(), m_subsribedParameters.begin(),
+                        m_subsribedParameters.end(), std::back_inserter(newParameters));
+    if (newParameters.empty()) {
+        return;
+    }
+    m_subsribedParameters.insert(newParameters.begin(), newParameters.end());
+    m_parametersClient->get_parameters(
+        newParameters, std::bind(&CameraParametersClient::onParametersResult, this, std::placeholders::_1));
+}
+
+void CameraParametersClient::setParameter(const rclcpp::Parameter &parameter) {
+    std::lock_guard<std::mutex> lock(m_writesMutex);
+    if (m_writesInFlight.find(parameter.get_name()) != m_writesInFlight.end()) {
+        m_pendingWrites[parameter.get_name()] = parameter;
+        return;
+    }
+    sendParameter(parameter);
+}
+
+void CameraParametersClient::sendParameter(const rclcpp::Parameter &parameter) {
+    auto name = parameter.get_name();
+    auto id = m_nextWriteId++;
+    // The timeout doesn't wait for further values from the UI, the user may have stopped changing the parameter
+    auto timeout = m_nh->create_wall_timer(WRITE_TIMEOUT, [this, name, id]() { onWriteTimeout(name, id); });
+    m_writesInFlight[name] = WriteInFlight{id, timeout};
+    m_parametersClient->set_parameters({parameter}, std::bind(&CameraParametersClient::onSetParametersResult, this,
+                                                              name, id, std::placeholders::_1));
+}
+
+void CameraParametersClient::onSetParametersResult(
+    const std::string &name, uint64_t writeId,
+    std::shared_future<std::vector<rcl_interfaces::msg::SetParametersResult>> future) {
+    try {
+        for (auto &result : future.get()) {
+            if (!result.successful) {
+                RCLCPP_WARN(m_nh->get_logger(), "Setting %s failed: %s", name.c_str(), result.reason.c_str());
             }
         }
+    } catch (const std::exception &e) {
+        RCLCPP_WARN(m_nh->get_logger(), "Setting %s failed: %s", name.c_str(), e.what());
     }
+
+    // A late response of a write which timed out doesn't end the write which replaced it
+    std::lock_guard<std::mutex> lock(m_writesMutex);
+    auto inFlight = m_writesInFlight.find(name);
+    if (inFlight == m_writesInFlight.end() || inFlight->second.id != writeId) {
+        return;
+    }
+
+    finishWrite(name);
 }
 
-void CameraParametersClient::subscribeForCameraParameters(const std::set<std::string> &parameterNames) {
-    std::set<std::string> newParameters;
-    std::set_union(m_subsribedParameters.begin(), m_subsribedParameters.end(), parameterNames.begin(),
-                   parameterNames.end(), std::inserter(newParameters, newParameters.begin()));
-    m_subsribedParameters = newParameters;
-    std::vector<std::string> parameters(m_subsribedParameters.begin(), m_subsribedParameters.end());
-    m_parametersClient->get_parameters(
-        parameters, std::bind(&CameraParametersClient::onParametersResult, this, std::placeholders::_1));
+void CameraParametersClient::onWriteTimeout(const std::string &name, uint64_t writeId) {
+    std::lock_guard<std::mutex> lock(m_writesMutex);
+    auto inFlight = m_writesInFlight.find(name);
+    if (inFlight == m_writesInFlight.end() || inFlight->second.id != writeId) {
+        return;
+    }
+    RCLCPP_WARN(m_nh->get_logger(), "Setting %s got no response within %lld s, giving up on it", name.c_str(),
+                static_cast<long long>(WRITE_TIMEOUT.count()));
+    finishWrite(name);
 }
 
-void CameraParametersClient::setParameter(const rclcpp::Parameter &parameter) {
-    m_parametersClient->set_parameters({parameter});
+void CameraParametersClient::finishWrite(const std::string &name) {
+    // The timer of the write is released with it, so it never fires again
+    m_writesInFlight.erase(name);
+
+    // Send the latest value which came in while this write was in flight
+    auto pending = m_pendingWrites.find(name);
+    if (pending != m_pendingWrites.end()) {
+        auto parameter = pending->second;
+        m_pendingWrites.erase(pending);
+        sendParameter(parameter);
+    }
 }
 } // namespace pmd_royale_ros_examples
@@ -0,0 +1,41 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include "MessageStamp.hpp"
+
+#include <cstring>
+#include <set>
+
+namespace pmd_royale_ros_examples {
+
+namespace {
+const std::set<std::string> STAMPED_TYPES = {"sensor_msgs/msg/CameraInfo", "sensor_msgs/msg/CompressedImage",
+                                             "sensor_msgs/msg/Image", "sensor_msgs/msg/LaserScan",
+                                             "sensor_msgs/msg/PointCloud2"};
+} // namespace
+
+bool hasHeaderStamp(const std::string &type) {
+    return STAMPED_TYPES.count(type) > 0;
+}
+
+bool readHeaderStamp(const rclcpp::SerializedMessage &msg, rcl_clock_type_t clockType, rclcpp::Time &stamp) {
+    auto &serialized = msg.get_rcl_serialized_message();
+    if (serialized.buffer_length < 12 || serialized.buffer[1] != 1) {
+        return false;
+    }
+    int32_t sec;
+    uint32_t nanosec;
+    ::memcpy(&sec, serialized.buffer + 4, sizeof(sec));
+    ::memcpy(&nanosec, serialized.buffer + 8, sizeof(nanosec));
+    stamp = rclcpp::Time(sec, nanosec, clockType);
+    return true;
+}
+
+} // namespace pmd_royale_ros_examples
@@ -28,8 +28,15 @@ PMDRoyaleRVIZ::PMDRoyaleRVIZ(QWidget *parent)
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
     mainLayout->setSizeConstraint(QLayout::SetMinimumSize);
 
-    // Top section to specify camera node name
+    // Top section to pick one of the registered cameras or specify the camera node name
     QVBoxLayout *topLayout = new QVBoxLayout();
+    QHBoxLayout *camerasLayout = new QHBoxLayout();
+    camerasLayout->addWidget(new QLabel("Cameras: ", this));
+    m_comboBoxCameras = new QComboBox(this);
+    camerasLayout->addWidget(m_comboBoxCameras);
+    connect(m_comboBoxCameras, SIGNAL(activated(int)), this, SLOT(chooseCamera(int)));
+    topLayout->addLayout(camerasLayout);
+
     QHBoxLayout *cameraNodeLayout = new QHBoxLayout();
     m_labelCameraNode = new QLabel("Camera Node: ", this);
     m_lineEditCameraNode = new QLineEdit(m_cameraNode, this);
@@ -47,6 +54,11 @@ PMDRoyaleRVIZ::PMDRoyaleRVIZ(QWidget *parent)
 
     init();
 
+    // The camera nodes announce themselves, so the panel doesn't need to look through the topics of the graph
+    m_subRegistry = m_nh->create_subscription<std_msgs::msg::String>(
+        pmd_royale_ros_driver::CAMERA_REGISTRY_TOPIC, rclcpp::QoS(10).transient_local(),
+        std::bind(&PMDRoyaleRVIZ::onRegistryEntry, this, std::placeholders::_1));
+
     m_thread = std::thread(&PMDRoyaleRVIZ::spin, this);
 }
 
@@ -63,6 +75,39 @@ void PMDRoyaleRVIZ::handleCameraNodeSetting() {
     }
 }
 
+void PMDRoyaleRVIZ::chooseCamera(int idx) {
+    auto cameraName = m_comboBoxCameras->itemData(idx).toString();
+    m_lineEditCameraNode->setText(cameraName);
+    handleCameraNodeSetting();
+}
+
+void PMDRoyaleRVIZ::onRegistryEntry(const std_msgs::msg::String::SharedPtr msg) {
+    CameraRegistryEntry entry;
+    if (!CameraRegistryEntry::parse(msg->data, entry)) {
+        RCLCPP_WARN(m_nh->get_logger(), "Ignoring malformed camera registry entry");
+        return;
+    }
+    QMetaObject::invokeMethod(this, [this, entry]() { addCamera(entry); }, Qt::QueuedConnection);
+}
+
+void PMDRoyaleRVIZ::addCamera(const CameraRegistryEntry &entry) {
+    m_cameras[entry.node] = entry;
+
+    auto node = QString::fromStdString(entry.node);
+    auto text = node + " (" + QString::fromStdString(entry.model) + " " + QString::fromStdString(entry.serial) + ")";
+    int idx = m_comboBoxCameras->findData(node);
+    if (idx == -1) {
+        m_comboBoxCameras->addItem(text, node);
+    } else {
+        m_comboBoxCameras->setItemText(idx, text);
+    }
+    if (node == m_cameraNode) {
+        m_comboBoxCameras->setCurrentIndex(m_comboBoxCameras->findData(node));
+        m_cameraControlWidget->setNumStreams(entry.numStreams);
+        m_topicStatisticsWidget->setTopics(entry.topics);
+    }
+}
+
 void PMDRoyaleRVIZ::init() {
     // Clear any existing widgets for existing camera node
     for (int i = m_tabWidget->count(); i > 0; i--) {
@@ -70,11 +115,20 @@ void PMDRoyaleRVIZ::init() {
         m_tabWidget->removeTab(i - 1);
     }
 
-    m_cameraControlWidget = new CameraControlWidget(m_nh, m_cameraNode.toStdString(), m_tabWidget);
+    // Until the camera shows up in the registry, only the first stream is known to exist
+    auto camera = m_cameras.find(m_cameraNode.toStdString());
+    uint32_t numStreams = camera != m_cameras.end() ? camera->second.numStreams : 1u;
+    m_cameraControlWidget = new CameraControlWidget(m_nh, m_cameraNode.toStdString(), numStreams, m_tabWidget);
     m_tabWidget->addTab(m_cameraControlWidget, "Control");
 
     m_cameraInfoWidget = new CameraInfoWidget(m_nh, m_cameraNode.toStdString(), m_tabWidget);
     m_tabWidget->addTab(m_cameraInfoWidget, "Info");
+
+    m_topicStatisticsWidget = new TopicStatisticsWidget(m_nh, m_tabWidget);
+    m_tabWidget->addTab(m_topicStatisticsWidget, "Statistics");
+    if (camera != m_cameras.end()) {
+        m_topicStatisticsWidget->setTopics(camera->second.topics);
+    }
 }
 
 void PMDRoyaleRVIZ::spin() {
@@ -0,0 +1,332 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include "SoakMonitor.hpp"
+#include "MessageStamp.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <dirent.h>
+#include <iterator>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pmd_royale_ros_examples {
+
+namespace {
+// Position of utime in /proc/<pid>/stat, counted from the state field behind the command name
+const size_t STAT_UTIME_IDX = 11;
+
+double seconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+// Rates of the topics of a summary.csv, by topic name
+std::map<std::string, double> readSummary(const std::string &path) {
+    std::map<std::string, double> rates;
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string topic;
+        std::string type;
+        std::string fps;
+        if (std::getline(fields, topic, ',') && std::getline(fields, type, ',') && std::getline(fields, fps, ',')) {
+            rates[topic] = std::stod(fps);
+        }
+    }
+    return rates;
+}
+} // namespace
+
+SoakMonitor::SoakMonitor(const rclcpp::NodeOptions &options)
+    : Node("pmd_royale_ros_soak_monitor", options),
+      m_pid(-1),
+      m_isProcessLost(false),
+      m_isWarm(false),
+      m_rssStartMb(0.),
+      m_rssEndMb(0.),
+      m_rssMaxMb(0.),
+      m_isFinished(false),
+      m_isPassed(false) {
+    m_cameraNode = this->declare_parameter("camera_node", "");
+    m_processMatch = this->declare_parameter("process_match", "pmd_royale_ros_camera_node_container");
+    m_duration = this->declare_parameter("duration", 3600.);
+    m_warmup = this->declare_parameter("warmup", 60.);
+    m_samplePeriod = this->declare_parameter("sample_period", 10.);
+    m_outputDir = this->declare_parameter("output_dir", "soak_results");
+    m_baseline = this->declare_parameter("baseline", "");
+    m_maxFpsRegression = this->declare_parameter("max_fps_regression", 0.05);
+    m_maxRssGrowthMb = this->declare_parameter("max_rss_growth_mb", 10.);
+
+    if (::mkdir(m_outputDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        RCLCPP_ERROR(this->get_logger(), "Couldn't create %s", m_outputDir.c_str());
+    }
+
+    m_subRegistry = this->create_subscription<std_msgs::msg::String>(
+        pmd_royale_ros_driver::CAMERA_REGISTRY_TOPIC, rclcpp::QoS(10).transient_local(),
+        std::bind(&SoakMonitor::onRegistryEntry, this, std::placeholders::_1));
+    RCLCPP_INFO(this->get_logger(), "Waiting for the camera node in the registry");
+}
+
+bool SoakMonitor::isFinished() const {
+    return m_isFinished;
+}
+
+bool SoakMonitor::isPassed() const {
+    return m_isPassed;
+}
+
+void SoakMonitor::onRegistryEntry(const std_msgs::msg::String::SharedPtr msg) {
+    CameraRegistryEntry entry;
+    if (!CameraRegistryEntry::parse(msg->data, entry) || (!m_cameraNode.empty() && entry.node != m_cameraNode)) {
+        return;
+    }
+    if (!m_topics.empty()) {
+        // The columns of the samples are fixed, a run measures one usecase
+        RCLCPP_WARN(this->get_logger(), "Outputs of %s changed, keeping the original topics", entry.node.c_str());
+        return;
+    }
+    m_cameraNode = entry.node;
+
+    auto clock = this->get_clock();
+    for (auto &registryTopic : entry.topics) {
+        Topic topic;
+        topic.topic = registryTopic;
+        topic.hasHeader = hasHeaderStamp(registryTopic.type);
+        topic.counters = std::make_shared<Counters>();
+        auto counters = topic.counters;
+        auto hasHeader = topic.hasHeader;
+        topic.subscription = this->create_generic_subscription(
+            registryTopic.name, registryTopic.type, rclcpp::SensorDataQoS(),
+            [counters, hasHeader, clock](std::shared_ptr<rclcpp::SerializedMessage> msg) {
+                auto receive = clock->now();
+                rclcpp::Time stamp;
+                bool isStamped = hasHeader && readHeaderStamp(*msg, receive.get_clock_type(), stamp);
+                double latency = isStamped ? std::max((receive - stamp).seconds(), 0.) : 0.;
+
+                std::lock_guard<std::mutex> lock(counters->mutex);
+                counters->messages++;
+                counters->periodMessages++;
+                if (isStamped) {
+                    auto bin = std::min(static_cast<size_t>(latency / LATENCY_BIN_WIDTH), LATENCY_BINS - 1);
+                    counters->latencyBins[bin]++;
+                    counters->latencyMax = std::max(counters->latencyMax, latency);
+                    counters->stamped++;
+                }
+            });
+        m_topics.push_back(topic);
+    }
+
+    m_samples.open(m_outputDir + "/samples.csv");
+    m_samples << "time_s,cpu_percent,rss_mb";
+    for (auto &topic : m_topics) {
+        m_samples << "," << topic.topic.name << "_fps";
+    }
+    m_samples << "\n";
+
+    m_pid = findProcess();
+    if (m_pid < 0) {
+        RCLCPP_ERROR(this->get_logger(), "No process matches %s", m_processMatch.c_str());
+    } else {
+        readProcess(m_lastProcess);
+    }
+
+    RCLCPP_INFO(this->get_logger(), "Measuring %zu topics of %s for %.0f s after a warmup of %.0f s", m_topics.size(),
+                m_cameraNode.c_str(), m_duration, m_warmup);
+    m_start = std::chrono::steady_clock::now();
+    m_lastSample = m_start;
+    m_sampleTimer = this->create_wall_timer(std::chrono::duration<double>(m_samplePeriod),
+                                            std::bind(&SoakMonitor::sample, this));
+}
+
+void SoakMonitor::sample() {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = seconds(now - m_lastSample);
+    double time = seconds(now - m_start);
+    m_lastSample = now;
+    if (elapsed <= 0.) {
+        return;
+    }
+
+    ProcessSample process;
+    bool hasProcess = m_pid >= 0 && readProcess(process);
+    if (m_pid >= 0 && !hasProcess) {
+        RCLCPP_ERROR(this->get_logger(), "Process %d of the driver is gone", m_pid);
+        m_isProcessLost = true;
+        m_pid = -1;
+    }
+    double cpu = hasProcess ? 100. * (process.cpuTime - m_lastProcess.cpuTime) / elapsed : 0.;
+    m_lastProcess = process;
+
+    m_samples << time << "," << cpu << "," << process.rssMb;
+    for (auto &topic : m_topics) {
+        std::lock_guard<std::mutex> lock(topic.counters->mutex);
+        m_samples << "," << topic.counters->periodMessages / elapsed;
+        topic.counters->periodMessages = 0;
+    }
+    m_samples << "\n";
+    m_samples.flush();
+
+    // Start the measurement over once the driver is warm, the allocations of the startup don't count as growth
+    if (!m_isWarm && time >= m_warmup) {
+        m_isWarm = true;
+        m_warmStart = now;
+        m_rssStartMb = process.rssMb;
+        for (auto &topic : m_topics) {
+            std::lock_guard<std::mutex> lock(topic.counters->mutex);
+            topic.counters->messages = 0;
+            topic.counters->stamped = 0;
+            topic.counters->latencyMax = 0.;
+            topic.counters->latencyBins.fill(0);
+        }
+    }
+    if (m_isWarm) {
+        m_rssEndMb = process.rssMb;
+        m_rssMaxMb = std::max(m_rssMaxMb, process.rssMb);
+    }
+
+    if (time >= m_warmup + m_duration) {
+        finish();
+    }
+}
+
+void SoakMonitor::finish() {
+    m_sampleTimer->cancel();
+    double measured = seconds(std::chrono::steady_clock::now() - m_warmStart);
+    auto baseline = m_baseline.empty() ? std::map<std::string, double>() : readSummary(m_baseline);
+    if (!m_baseline.empty() && baseline.empty()) {
+        RCLCPP_ERROR(this->get_logger(), "Couldn't read the baseline %s", m_baseline.c_str());
+    }
+
+    std::vector<std::string> failures;
+    std::ofstream summary(m_outputDir + "/summary.csv");
+    summary << "topic,type,fps,latency_p50_ms,latency_p90_ms,latency_p99_ms,latency_max_ms\n";
+    for (auto &topic : m_topics) {
+        std::lock_guard<std::mutex> lock(topic.counters->mutex);
+        auto &counters = *topic.counters;
+        double fps = counters.messages / measured;
+        summary << topic.topic.name << "," << topic.topic.type << "," << fps;
+        if (counters.stamped > 0) {
+            summary << "," << 1e3 * latencyPercentile(counters, 0.5) << "," << 1e3 * latencyPercentile(counters, 0.9)
+                    << "," << 1e3 * latencyPercentile(counters, 0.99) << "," << 1e3 * counters.latencyMax << "\n";
+        } else {
+            summary << ",,,,\n";
+        }
+
+        auto baselineFps = baseline.find(topic.topic.name);
+        if (counters.messages == 0) {
+            failures.push_back(topic.topic.name + " delivered no messages");
+        } else if (baselineFps != baseline.end() && fps < (1. - m_maxFpsRegression) * baselineFps->second) {
+            std::ostringstream failure;
+            failure << topic.topic.name << " delivered " << fps << " Hz, baseline " << baselineFps->second << " Hz";
+            failures.push_back(failure.str());
+        }
+    }
+
+    double rssGrowth = m_rssEndMb - m_rssStartMb;
+    if (m_pid < 0 || m_isProcessLost) {
+        failures.push_back("Driver process " + m_processMatch + " wasn't measured to the end");
+    } else if (rssGrowth > m_maxRssGrowthMb) {
+        std::ostringstream failure;
+        failure << "Resident memory grew by " << rssGrowth << " MB";
+        failures.push_back(failure.str());
+    }
+
+    m_isPassed = failures.empty();
+    std::ofstream result(m_outputDir + "/result.txt");
+    result << "passed=" << (m_isPassed ? "true" : "false") << "\n";
+    result << "measured_s=" << measured << "\n";
+    result << "rss_start_mb=" << m_rssStartMb << "\n";
+    result << "rss_end_mb=" << m_rssEndMb << "\n";
+    result << "rss_max_mb=" << m_rssMaxMb << "\n";
+    for (auto &failure : failures) {
+        result << "failure=" << failure << "\n";
+        RCLCPP_ERROR(this->get_logger(), "%s", failure.c_str());
+    }
+    RCLCPP_INFO(this->get_logger(), "Soak test %s, results in %s", m_isPassed ? "passed" : "failed", m_outputDir.c_str());
+
+    m_isFinished = true;
+    m_topics.clear();
+    rclcpp::shutdown();
+}
+
+int SoakMonitor::findProcess() const {
+    DIR *proc = ::opendir("/proc");
+    if (!proc) {
+        return -1;
+    }
+    int pid = -1;
+    while (struct dirent *entry = ::readdir(proc)) {
+        int candidate = ::atoi(entry->d_name);
+        if (candidate <= 0 || candidate == ::getpid()) {
+            continue;
+        }
+        // The arguments are separated by 0 bytes
+        std::ifstream cmdlineFile("/proc/" + std::string(entry->d_name) + "/cmdline");
+        std::string cmdline((std::istreambuf_iterator<char>(cmdlineFile)), std::istreambuf_iterator<char>());
+        std::replace(cmdline.begin(), cmdline.end(), '\0', ' ');
+        if (cmdline.find(m_processMatch) != std::string::npos) {
+            pid = candidate;
+            break;
+        }
+    }
+    ::closedir(proc);
+    return pid;
+}
+
+bool SoakMonitor::readProcess(ProcessSample &sample) const {
+    auto procDir = "/proc/" + std::to_string(m_pid);
+    std::ifstream statFile(procDir + "/stat");
+    std::string stat((std::istreambuf_iterator<char>(statFile)), std::istreambuf_iterator<char>());
+    auto commandEnd = stat.rfind(')');
+    if (commandEnd == std::string::npos) {
+        return false;
+    }
+    std::istringstream fields(stat.substr(commandEnd + 2));
+    std::string field;
+    size_t fieldIdx = 0;
+    while (fieldIdx < STAT_UTIME_IDX && fields >> field) {
+        fieldIdx++;
+    }
+    double utime = 0.;
+    double stime = 0.;
+    if (!(fields >> utime >> stime)) {
+        return false;
+    }
+    sample.cpuTime = (utime + stime) / ::sysconf(_SC_CLK_TCK);
+
+    std::ifstream statusFile(procDir + "/status");
+    std::string line;
+    while (std::getline(statusFile, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            sample.rssMb = std::stod(line.substr(6)) / 1024.;
+            return true;
+        }
+    }
+    return false;
+}
+
+double SoakMonitor::latencyPercentile(const Counters &counters, double fraction) {
+    uint64_t target = static_cast<uint64_t>(fraction * counters.stamped);
+    uint64_t count = 0;
+    for (auto i = 0u; i < LATENCY_BINS - 1; ++i) {
+        count += counters.latencyBins[i];
+        if (count > target) {
+            return (i + 1) * LATENCY_BIN_WIDTH;
+        }
+    }
+    return counters.latencyMax;
+}
+
+} // namespace pmd_royale_ros_examples
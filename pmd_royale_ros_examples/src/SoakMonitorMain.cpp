@@ -0,0 +1,24 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include "SoakMonitor.hpp"
+
+int main(int argc, char **argv) {
+    rclcpp::init(argc, argv);
+    auto monitor = std::make_shared<pmd_royale_ros_examples::SoakMonitor>();
+    rclcpp::spin(monitor);
+    bool isPassed = monitor->isFinished() && monitor->isPassed();
+    if (rclcpp::ok()) {
+        rclcpp::shutdown();
+    }
+
+    // The exit code tells a CI job whether the run passed, an interrupted run didn't
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include "TopicStatisticsWidget.hpp"
+#include "MessageStamp.hpp"
+
+#include <QHeaderView>
+#include <QLabel>
+#include <QVBoxLayout>
+#include <algorithm>
+
+namespace pmd_royale_ros_examples {
+
+namespace {
+enum Column { TopicColumn, RateColumn, BandwidthColumn, LatencyColumn, NumColumns };
+} // namespace
+
+TopicStatisticsWidget::TopicStatisticsWidget(std::shared_ptr<rclcpp::Node> node, QWidget *parent)
+    : QWidget(parent), m_nh(node), m_lastUpdate(std::chrono::steady_clock::now()) {
+    QVBoxLayout *statisticsLayout = new QVBoxLayout(this);
+    statisticsLayout->addWidget(new QLabel("Check a topic to measure it:", this));
+
+    m_table = new QTableWidget(0, NumColumns, this);
+    m_table->setHorizontalHeaderLabels({"Topic", "Rate (Hz)", "Bandwidth (MB/s)", "Latency (ms)"});
+    m_table->horizontalHeader()->setSectionResizeMode(TopicColumn, QHeaderView::Stretch);
+    m_table->verticalHeader()->hide();
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    statisticsLayout->addWidget(m_table);
+    connect(m_table, &QTableWidget::itemChanged, this, &TopicStatisticsWidget::onItemChanged);
+
+    m_timer = new QTimer(this);
+    connect(m_timer, &QTimer::timeout, this, &TopicStatisticsWidget::updateStatistics);
+    m_timer->start(1000);
+}
+
+void TopicStatisticsWidget::setTopics(const std::vector<CameraRegistryEntry::Topic> &topics) {
+    bool isSame = topics.size() == m_topics.size();
+    for (auto i = 0u; isSame && i < topics.size(); ++i) {
+        isSame = topics[i].name == m_topics[i].topic.name && topics[i].type == m_topics[i].topic.type;
+    }
+    if (isSame) {
+        return;
+    }
+
+    m_topics.clear();
+    m_table->blockSignals(true);
+    m_table->setRowCount(static_cast<int>(topics.size()));
+    for (auto i = 0u; i < topics.size(); ++i) {
+        Topic topic;
+        topic.topic = topics[i];
+        topic.hasHeader = hasHeaderStamp(topics[i].type);
+        topic.counters = std::make_shared<Counters>();
+        m_topics.push_back(topic);
+
+        auto *item = new QTableWidgetItem(QString::fromStdString(topics[i].name));
+        item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Unchecked);
+        item->setToolTip(QString::fromStdString(topics[i].type));
+        m_table->setItem(static_cast<int>(i), TopicColumn, item);
+        for (int column = RateColumn; column < NumColumns; ++column) {
+            m_table->setItem(static_cast<int>(i), column, new QTableWidgetItem("-"));
+        }
+    }
+    m_table->blockSignals(false);
+}
+
+void TopicStatisticsWidget::onItemChanged(QTableWidgetItem *item) {
+    if (item->column() != TopicColumn || item->row() >= static_cast<int>(m_topics.size())) {
+        return;
+    }
+    auto &topic = m_topics[item->row()];
+    if (item->checkState() == Qt::Checked) {
+        subscribe(topic);
+    } else {
+        topic.subscription.reset();
+    }
+}
+
+void TopicStatisticsWidget::subscribe(Topic &topic) {
+    // Start with fresh counters, a callback of an old subscription may still be running
+    topic.counters = std::make_shared<Counters>();
+    auto counters = topic.counters;
+    auto hasHeader = topic.hasHeader;
+    auto clock = m_nh->get_clock();
+    topic.subscription = m_nh->create_generic_subscription(
+        topic.topic.name, topic.topic.type, rclcpp::SensorDataQoS(),
+        [counters, hasHeader, clock](std::shared_ptr<rclcpp::SerializedMessage> msg) {
+            auto receive = clock->now();
+            rclcpp::Time stamp;
+            bool isStamped = hasHeader && readHeaderStamp(*msg, receive.get_clock_type(), stamp);
+            double latency = isStamped ? (receive - stamp).seconds() : 0.;
+
+            std::lock_guard<std::mutex> lock(counters->mutex);
+            counters->messages++;
+            counters->bytes += msg->size();
+            if (isStamped) {
+                counters->stamped++;
+                counters->latencySum += latency;
+                counters->latencyMax = std::max(counters->latencyMax, latency);
+            }
+        });
+}
+
+void TopicStatisticsWidget::updateStatistics() {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastUpdate).count();
+    m_lastUpdate = now;
+    if (elapsed <= 0.) {
+        return;
+    }
+
+    m_table->blockSignals(true);
+    for (auto i = 0u; i < m_topics.size(); ++i) {
+        auto &topic = m_topics[i];
+        auto row = static_cast<int>(i);
+        if (!topic.subscription) {
+            for (int column = RateColumn; column < NumColumns; ++column) {
+                m_table->item(row, column)->setText("-");
+            }
+            continue;
+        }
+
+        Counters counters;
+        {
+            std::lock_guard<std::mutex> lock(topic.counters->mutex);
+            counters.messages = topic.counters->messages;
+            counters.bytes = topic.counters->bytes;
+            counters.stamped = topic.counters->stamped;
+            counters.latencySum = topic.counters->latencySum;
+            counters.latencyMax = topic.counters->latencyMax;
+            topic.counters->messages = 0;
+            topic.counters->bytes = 0;
+            topic.counters->stamped = 0;
+            topic.counters->latencySum = 0.;
+            topic.counters->latencyMax = 0.;
+        }
+
+        m_table->item(row, RateColumn)->setText(QString::number(counters.messages / elapsed, 'f', 1));
+        m_table->item(row, BandwidthColumn)->setText(QString::number(counters.bytes / elapsed / 1e6, 'f', 2));
+        if (counters.stamped > 0) {
+            double mean = 1e3 * counters.latencySum / counters.stamped;
+            m_table->item(row, LatencyColumn)->setText(QString::number(mean, 'f', 1) + " (max " +
+                                                       QString::number(1e3 * counters.latencyMax, 'f', 1) + ")");
+        } else {
+            m_table->item(row, LatencyColumn)->setText("-");
+        }
+    }
+    m_table->blockSignals(false);
+}
+
+} // namespace pmd_royale_ros_examples
@@ -0,0 +1,65 @@
+/****************************************************************************\
+ * Copyright (C) 2023 pmdtechnologies ag
+ *
+ * THIS CODE AND INFORMATION ARE PROVIDED "AS IS" WITHOUT WARRANTY OF ANY
+ * KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+ * PARTICULAR PURPOSE.
+ *
+ \****************************************************************************/
+
+#include "MessageStamp.hpp"
+
+#include <rclcpp/serialization.hpp>
+#include <sensor_msgs/msg/compressed_image.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace pmd_royale_ros_examples;
+
+namespace {
+template <typename Message>
+rclcpp::SerializedMessage serialize(const Message &msg) {
+    rclcpp::SerializedMessage serialized;
+    rclcpp::Serialization<Message>().serialize_message(&msg, &serialized);
+    return serialized;
+}
+} // namespace
+
+TEST(MessageStamp, StampedTypesOfTheDriver) {
+    EXPECT_TRUE(hasHeaderStamp("sensor_msgs/msg/CameraInfo"));
+    EXPECT_TRUE(hasHeaderStamp("sensor_msgs/msg/CompressedImage"));
+    EXPECT_TRUE(hasHeaderStamp("sensor_msgs/msg/Image"));
+    EXPECT_TRUE(hasHeaderStamp("sensor_msgs/msg/LaserScan"));
+    EXPECT_TRUE(hasHeaderStamp("sensor_msgs/msg/PointCloud2"));
+    EXPECT_FALSE(hasHeaderStamp("std_msgs/msg/Float32MultiArray"));
+    EXPECT_FALSE(hasHeaderStamp("std_msgs/msg/String"));
+}
+
+TEST(MessageStamp, ReadsStampOfSerializedMessage) {
+    sensor_msgs::msg::CompressedImage compressed;
+    compressed.header.stamp.sec = 1700000000;
+    compressed.header.stamp.nanosec = 123456789;
+    compressed.header.frame_id = "pmd_royale_ros_camera_node_optical_frame";
+    compressed.format = "pmd_cloud_codec";
+    compressed.data.resize(100, 0xAB);
+
+    rclcpp::Time stamp;
+    ASSERT_TRUE(readHeaderStamp(serialize(compressed), RCL_ROS_TIME, stamp));
+    EXPECT_EQ(stamp, rclcpp::Time(compressed.header.stamp, RCL_ROS_TIME));
+    EXPECT_EQ(stamp.get_clock_type(), RCL_ROS_TIME);
+
+    sensor_msgs::msg::Image image;
+    image.header.stamp.sec = 5;
+    image.header.stamp.nanosec = 999999999;
+    ASSERT_TRUE(readHeaderStamp(serialize(image), RCL_SYSTEM_TIME, stamp));
+    EXPECT_EQ(stamp.nanoseconds(), 5999999999);
+}
+
+TEST(MessageStamp, RejectsTruncatedMessage) {
+    rclcpp::SerializedMessage serialized(8);
+    serialized.get_rcl_serialized_message().buffer_length = 8;
+    rclcpp::Time stamp;
+    EXPECT_FALSE(readHeaderStamp(serialized, RCL_ROS_TIME, stamp));
+}